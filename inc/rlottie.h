@@ -64,6 +64,126 @@ namespace rlottie {
  */
 RLOTTIE_API void configureModelCacheSize(size_t cacheSize);
 
+/**
+ *  @brief Configures how long an animation instance keeps the content of a
+ *  precomp layer that is no longer on screen.
+ *
+ *  The content of a precomp layer is built the first time the layer becomes
+ *  visible. With a non zero delay it is released again once the layer was
+ *  not visible for @p frameCount rendered frames, and rebuilt on its next
+ *  activation.
+ *
+ *  @param[in] frameCount  Number of inactive frames before the release.
+ *
+ *  @note by default (0) the content is kept for the lifetime of the
+ *        instance.
+ *  @note the content of an instance that had setValue() called on it is
+ *        never released.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configurePrecompReleaseDelay(size_t frameCount);
+
+/**
+ *  @brief How the rasterized content of a static layer is kept between
+ *  frames.
+ *
+ *  A shape layer whose content doesn't change (only its transform and
+ *  opacity are animated) can reuse its raster from the previous frame
+ *  while it only moves by whole pixels.
+ */
+enum class LayerCache {
+    None,   /*!< the layers are rasterized on every change (default) */
+    Rle,    /*!< keep the coverage of static layers */
+    Bitmap  /*!< also keep the blended pixels of static layers */
+};
+
+/**
+ *  @brief Configures the raster cache of the static layers.
+ *
+ *  @param[in] policy  Cache policy used by the instances created afterwards.
+ *
+ *  @note with the Bitmap policy a static layer is blended into its own
+ *        buffer once, the result may differ by a rounding step from
+ *        blending its shapes directly.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureLayerCache(LayerCache policy);
+
+/**
+ *  @brief How the pixels of a rotated or scaled image layer are sampled.
+ */
+enum class ImageQuality {
+    Nearest,  /*!< the closest pixel of the image (default) */
+    Bilinear  /*!< a blend of the 4 closest pixels, smoother but slower */
+};
+
+/**
+ *  @brief Configures the sampling of the transformed image layers.
+ *
+ *  @param[in] quality  Sampling used by the instances created afterwards.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureImageQuality(ImageQuality quality);
+
+/**
+ *  @brief How the shapes are scan converted into coverage.
+ */
+enum class Rasterizer {
+    Cells,        /*!< sorted cell lists per scanline (default) */
+    Accumulation  /*!< dense rows of coverage deltas summed per scanline */
+};
+
+/**
+ *  @brief Configures the scan converter of the shapes.
+ *
+ *  @param[in] rasterizer  Scan converter of the shapes rasterized afterwards.
+ *
+ *  @note both give the same coverage, the accumulation one is faster on
+ *        shapes with many edges.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureRasterizer(Rasterizer rasterizer);
+
+/**
+ *  @brief Configures the memory budget of the offscreen buffer pool.
+ *
+ *  Mattes and translucent precomps are composed in offscreen buffers. The
+ *  buffers are pooled and shared by all the animation instances. A buffer
+ *  that is given back stays in the pool while the pool is under the
+ *  budget, the least recently used ones are freed first. Buffers that were
+ *  not reused for a second are freed as well.
+ *
+ *  @param[in] bytes  Maximum memory held by the idle buffers.
+ *
+ *  @note the default budget is 16MB.
+ *  @note to flush the pool configure it with 0 and then reconfigure with
+ *        the new budget.
+ *
+ *  @internal
+ */
+RLOTTIE_API void configureSurfaceCacheSize(size_t bytes);
+
+/**
+ *  @brief Usage counters of the offscreen buffer pool.
+ */
+struct SurfaceCacheStats {
+    size_t hits{0};     /*!< requests served by a pooled buffer */
+    size_t misses{0};   /*!< requests that allocated a new buffer */
+    size_t buffers{0};  /*!< number of idle buffers in the pool */
+    size_t bytes{0};    /*!< memory held by the idle buffers */
+};
+
+/**
+ *  @brief Returns the usage counters of the offscreen buffer pool.
+ *
+ *  @internal
+ */
+RLOTTIE_API SurfaceCacheStats surfaceCacheStats();
+
 struct Color {
     Color() = default;
     Color(float r, float g , float b):_r(r), _g(g), _b(b){}
@@ -122,6 +242,20 @@ struct Size_Type{};
 struct Float_Type{};
 template <typename T> struct MapType;
 
+/**
+ *  @brief Pixel layouts the buffer of a Surface can be rendered in.
+ *
+ *  @see Animation::renderSync
+ */
+enum class PixelFormat {
+    ARGB32_Premultiplied, /*!< 32 bit 0xAARRGGBB words, premultiplied (default) */
+    RGBA32_Premultiplied, /*!< r, g, b, a bytes, premultiplied */
+    RGBA32,               /*!< r, g, b, a bytes, not premultiplied */
+    BGRA32,               /*!< b, g, r, a bytes, not premultiplied */
+    RGB16_565,            /*!< 16 bit 5-6-5 words, the frame over black */
+    Alpha8                /*!< the coverage alone, one byte a pixel */
+};
+
 class RLOTTIE_API Surface {
 public:
     /**
@@ -255,6 +389,32 @@ private:
     }mDrawArea;
 };
 
+/**
+ *  @brief Plane layouts of a YuvFrame.
+ */
+enum class YuvFormat {
+    I420,  /*!< y plane, then u and v planes of half the width and height */
+    NV12   /*!< y plane, then one plane of u, v pairs of half the height */
+};
+
+/**
+ *  @brief 8 bit planes a frame is written to as BT.601 video range YUV.
+ *
+ *  The chroma is subsampled 2x2, the planes of an odd width or height are
+ *  rounded up. The frame is taken as if over black.
+ */
+struct YuvFrame {
+    uint8_t  *y{nullptr};     /*!< luma plane */
+    uint8_t  *u{nullptr};     /*!< u plane, or the u, v pairs of NV12 */
+    uint8_t  *v{nullptr};     /*!< v plane, unused with NV12 */
+    size_t    yStride{0};     /*!< bytes in a luma scanline */
+    size_t    uStride{0};     /*!< bytes in a u or u, v pair scanline */
+    size_t    vStride{0};     /*!< bytes in a v scanline */
+    size_t    width{0};       /*!< frame width in pixels */
+    size_t    height{0};      /*!< frame height in pixels */
+    YuvFormat format{YuvFormat::I420};
+};
+
 using MarkerList = std::vector<std::tuple<std::string, int , int>>;
 /**
  *  @brief https://helpx.adobe.com/after-effects/using/layer-markers-composition-markers.html
@@ -325,6 +485,31 @@ public:
     static std::unique_ptr<Animation>
     loadFromData(std::string jsonData, std::string resourcePath, ColorFilter filter);
 
+    /**
+     *  @brief Constructs an animation object from JSON string data and update
+     *  the color properties using ColorFilter.
+     *
+     *  Unlike the overload above, the data is parsed only once per key and
+     *  the unfiltered model is kept in the model cache. Each call then only
+     *  copies and filters the color properties, so loading several color
+     *  themes of the same resource does not reparse it.
+     *
+     *  @param[in] jsonData The JSON string data.
+     *  @param[in] key the string that will be used to cache the base model.
+     *  @param[in] filter The color filter that will be applied for each color
+     *             property of the model.
+     *  @param[in] resourcePath the path will be used to search for external
+     *             resource.
+     *
+     *  @return Animation object that can render the contents of the
+     *          Lottie resource represented by JSON string data.
+     *
+     *  @internal
+     */
+    static std::unique_ptr<Animation>
+    loadFromData(std::string jsonData, const std::string &key,
+                 ColorFilter filter, const std::string &resourcePath);
+
     /**
      *  @brief Returns default framerate of the Lottie resource.
      *
@@ -421,6 +606,57 @@ public:
      */
     void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
 
+    /**
+     *  @brief Renders the content to a surface of another pixel format.
+     *
+     *  ARGB32_Premultiplied, RGBA32_Premultiplied and Alpha8 surfaces are
+     *  blended directly. The straight alpha and 5-6-5 formats can not be
+     *  blended into, the frame is blended in bands of a buffer of the
+     *  offscreen pool and each band is written out while in the cache.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] format  Layout of the pixels in the surface buffer.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @see PixelFormat
+     *  @internal
+     */
+    void              renderSync(size_t frameNo, Surface surface, PixelFormat format,
+                                 bool keepAspectRatio=true);
+
+    /**
+     *  @brief Renders the content to a surface of another pixel format
+     *         asynchronously, @see renderSync
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] surface Surface in which content will be drawn
+     *  @param[in] format  Layout of the pixels in the surface buffer.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @return future that will hold the result when rendering finished.
+     *
+     *  @internal
+     */
+    std::future<Surface> render(size_t frameNo, Surface surface, PixelFormat format,
+                                bool keepAspectRatio=true);
+
+    /**
+     *  @brief Renders the content straight to YUV planes synchronously.
+     *
+     *  The frame is blended in bands of a buffer of the offscreen pool,
+     *  each band is converted while in the cache, the caller needs no ARGB
+     *  surface of its own.
+     *
+     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
+     *  @param[in] frame   Planes the content is written to.
+     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+     *
+     *  @see YuvFrame
+     *  @internal
+     */
+    void              renderSync(size_t frameNo, const YuvFrame &frame, bool keepAspectRatio=true);
+
     /**
      *  @brief Returns root layer of the composition updated with
      *         content of the Lottie resource at frame number @p frameNo.
@@ -23,6 +23,7 @@
 #include "lottieitem.h"
 #include "lottiemodel.h"
 #include "rlottie.h"
+#include "vraster.h"
 
 #include <fstream>
 
@@ -34,6 +35,38 @@ RLOTTIE_API void rlottie::configureModelCacheSize(size_t cacheSize)
     internal::model::configureModelCacheSize(cacheSize);
 }
 
+RLOTTIE_API void rlottie::configurePrecompReleaseDelay(size_t frameCount)
+{
+    internal::renderer::configurePrecompReleaseDelay(frameCount);
+}
+
+RLOTTIE_API void rlottie::configureLayerCache(LayerCache policy)
+{
+    internal::renderer::configureLayerCache(policy);
+}
+
+RLOTTIE_API void rlottie::configureImageQuality(ImageQuality quality)
+{
+    internal::renderer::configureImageQuality(quality);
+}
+
+RLOTTIE_API void rlottie::configureRasterizer(Rasterizer rasterizer)
+{
+    VRasterizer::setBackend(rasterizer == Rasterizer::Accumulation
+                                ? VRasterizer::Backend::Accumulation
+                                : VRasterizer::Backend::Cells);
+}
+
+RLOTTIE_API void rlottie::configureSurfaceCacheSize(size_t bytes)
+{
+    internal::renderer::SurfaceCache::configure(bytes);
+}
+
+RLOTTIE_API SurfaceCacheStats rlottie::surfaceCacheStats()
+{
+    return internal::renderer::SurfaceCache::stats();
+}
+
 struct RenderTask {
     RenderTask() { receiver = sender.get_future(); }
     std::promise<Surface> sender;
@@ -41,6 +74,7 @@ struct RenderTask {
     AnimationImpl *       playerImpl{nullptr};
     size_t                frameNo{0};
     Surface               surface;
+    PixelFormat           format{PixelFormat::ARGB32_Premultiplied};
     bool                  keepAspectRatio{true};
 };
 using SharedRenderTask = std::shared_ptr<RenderTask>;
@@ -48,6 +82,7 @@ using SharedRenderTask = std::shared_ptr<RenderTask>;
 class AnimationImpl {
 public:
     void    init(std::shared_ptr<model::Composition> composition);
+    void    init(std::shared_ptr<model::ColorVariant> variant);
     bool    update(size_t frameNo, const VSize &size, bool keepAspectRatio);
     VSize   size() const { return mModel->size(); }
     double  duration() const { return mModel->duration(); }
@@ -55,9 +90,10 @@ public:
     size_t  totalFrame() const { return mModel->totalFrame(); }
     size_t  frameAtPos(double pos) const { return mModel->frameAtPos(pos); }
     Surface render(size_t frameNo, const Surface &surface,
-                   bool keepAspectRatio);
+                   PixelFormat format, bool keepAspectRatio);
     std::future<Surface> renderAsync(size_t frameNo, Surface &&surface,
-                                     bool keepAspectRatio);
+                                     PixelFormat format, bool keepAspectRatio);
+    void    render(size_t frameNo, const YuvFrame &frame, bool keepAspectRatio);
     const LOTLayerNode * renderTree(size_t frameNo, const VSize &size);
 
     const LayerInfoList &layerInfoList() const
@@ -82,7 +118,7 @@ private:
 void AnimationImpl::setValue(const std::string &keypath, LOTVariant &&value)
 {
     if (keypath.empty()) return;
-    mRenderer->setValue(keypath, value);
+    mRenderer->setValue(keypath, std::move(value));
 }
 
 const LOTLayerNode *AnimationImpl::renderTree(size_t frameNo, const VSize &size)
@@ -106,7 +142,7 @@ bool AnimationImpl::update(size_t frameNo, const VSize &size,
 }
 
 Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
-                              bool keepAspectRatio)
+                              PixelFormat format, bool keepAspectRatio)
 {
     bool renderInProgress = mRenderInProgress.load();
     if (renderInProgress) {
@@ -119,12 +155,27 @@ Surface AnimationImpl::render(size_t frameNo, const Surface &surface,
         frameNo,
         VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())),
         keepAspectRatio);
-    mRenderer->render(surface);
+    mRenderer->render(surface, format);
     mRenderInProgress.store(false);
 
     return surface;
 }
 
+void AnimationImpl::render(size_t frameNo, const YuvFrame &frame,
+                           bool keepAspectRatio)
+{
+    if (mRenderInProgress.load()) {
+        vCritical << "Already Rendering Scheduled for this Animation";
+        return;
+    }
+
+    mRenderInProgress.store(true);
+    update(frameNo, VSize(int(frame.width), int(frame.height)),
+           keepAspectRatio);
+    mRenderer->render(frame);
+    mRenderInProgress.store(false);
+}
+
 void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
 {
     mModel = composition.get();
@@ -132,6 +183,13 @@ void AnimationImpl::init(std::shared_ptr<model::Composition> composition)
     mRenderInProgress = false;
 }
 
+void AnimationImpl::init(std::shared_ptr<model::ColorVariant> variant)
+{
+    mModel = variant->composition().get();
+    mRenderer = std::make_unique<renderer::Composition>(std::move(variant));
+    mRenderInProgress = false;
+}
+
 #ifdef LOTTIE_THREAD_SUPPORT
 
 #include <thread>
@@ -167,8 +225,9 @@ class RenderTaskScheduler {
             }
             if (!success && !_q[i].pop(task)) break;
 
-            auto result = task->playerImpl->render(task->frameNo, task->surface,
-                                                   task->keepAspectRatio);
+            auto result =
+                task->playerImpl->render(task->frameNo, task->surface,
+                                         task->format, task->keepAspectRatio);
             task->sender.set_value(result);
         }
     }
@@ -223,6 +282,7 @@ public:
     std::future<Surface> process(SharedRenderTask task)
     {
         auto result = task->playerImpl->render(task->frameNo, task->surface,
+                                               task->format,
                                                task->keepAspectRatio);
         task->sender.set_value(result);
         return std::move(task->receiver);
@@ -230,9 +290,10 @@ public:
 };
 #endif
 
-std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
-                                                Surface &&surface,
-                                                bool      keepAspectRatio)
+std::future<Surface> AnimationImpl::renderAsync(size_t      frameNo,
+                                                Surface &&  surface,
+                                                PixelFormat format,
+                                                bool        keepAspectRatio)
 {
     if (!mTask) {
         mTask = std::make_shared<RenderTask>();
@@ -243,6 +304,7 @@ std::future<Surface> AnimationImpl::renderAsync(size_t    frameNo,
     mTask->playerImpl = this;
     mTask->frameNo = frameNo;
     mTask->surface = std::move(surface);
+    mTask->format = format;
     mTask->keepAspectRatio = keepAspectRatio;
 
     return RenderTaskScheduler::instance().process(mTask);
@@ -292,6 +354,25 @@ std::unique_ptr<Animation> Animation::loadFromData(std::string jsonData,
     return nullptr;
 }
 
+std::unique_ptr<Animation> Animation::loadFromData(
+    std::string jsonData, const std::string &key, ColorFilter filter,
+    const std::string &resourcePath)
+{
+    if (jsonData.empty()) {
+        vWarning << "jason data is empty";
+        return nullptr;
+    }
+
+    auto variant =
+        model::loadFromData(std::move(jsonData), key, resourcePath, filter);
+    if (variant) {
+        auto animation = std::unique_ptr<Animation>(new Animation);
+        animation->d->init(std::move(variant));
+        return animation;
+    }
+    return nullptr;
+}
+
 std::unique_ptr<Animation> Animation::loadFromFile(const std::string &path,
                                                    bool cachePolicy)
 {
@@ -346,13 +427,34 @@ const LOTLayerNode *Animation::renderTree(size_t frameNo, size_t width,
 std::future<Surface> Animation::render(size_t frameNo, Surface surface,
                                        bool keepAspectRatio)
 {
-    return d->renderAsync(frameNo, std::move(surface), keepAspectRatio);
+    return d->renderAsync(frameNo, std::move(surface),
+                          PixelFormat::ARGB32_Premultiplied, keepAspectRatio);
+}
+
+std::future<Surface> Animation::render(size_t frameNo, Surface surface,
+                                       PixelFormat format, bool keepAspectRatio)
+{
+    return d->renderAsync(frameNo, std::move(surface), format,
+                          keepAspectRatio);
 }
 
 void Animation::renderSync(size_t frameNo, Surface surface,
                            bool keepAspectRatio)
 {
-    d->render(frameNo, surface, keepAspectRatio);
+    d->render(frameNo, surface, PixelFormat::ARGB32_Premultiplied,
+              keepAspectRatio);
+}
+
+void Animation::renderSync(size_t frameNo, Surface surface, PixelFormat format,
+                           bool keepAspectRatio)
+{
+    d->render(frameNo, surface, format, keepAspectRatio);
+}
+
+void Animation::renderSync(size_t frameNo, const YuvFrame &frame,
+                           bool keepAspectRatio)
+{
+    d->render(frameNo, frame, keepAspectRatio);
 }
 
 const LayerInfoList &Animation::layers() const
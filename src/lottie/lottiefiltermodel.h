@@ -23,9 +23,9 @@
 #ifndef LOTTIEFILTERMODEL_H
 #define LOTTIEFILTERMODEL_H
 
-#include <algorithm>
-#include <bitset>
+#include <array>
 #include <cassert>
+#include <memory>
 #include "lottiemodel.h"
 #include "rlottie.h"
 
@@ -234,80 +234,113 @@ namespace internal {
 
 namespace model {
 
-class FilterData {
+/*
+ * A dynamic property value set through Animation::setValue().
+ * One instance is shared by every object the keypath resolved to, and the
+ * callback result is kept for the last queried frame so the user callback
+ * runs at most once per frame no matter how many objects use it.
+ */
+class FilterValue {
 public:
-    void addValue(LOTVariant& value)
-    {
-        uint index = static_cast<uint>(value.property());
-        if (mBitset.test(index)) {
-            std::replace_if(mFilters.begin(), mFilters.end(),
-                            [&value](const LOTVariant& e) {
-                                return e.property() == value.property();
-                            },
-                            value);
-        } else {
-            mBitset.set(index);
-            mFilters.push_back(value);
+    explicit FilterValue(LOTVariant&& value) : mValue(std::move(value)) {}
+
+    rlottie::Property property() const { return mValue.property(); }
+
+    model::Color color(int frame) const
+    {
+        if (!cached(frame)) {
+            rlottie::Color col = mValue.color()(rlottie::FrameInfo(frame));
+            store(frame, col.r(), col.g(), col.b());
         }
+        return model::Color(mCache[0], mCache[1], mCache[2]);
     }
-
-    void removeValue(LOTVariant& value)
+    VPointF point(int frame) const
+    {
+        if (!cached(frame)) {
+            rlottie::Point pt = mValue.point()(rlottie::FrameInfo(frame));
+            store(frame, pt.x(), pt.y());
+        }
+        return VPointF(mCache[0], mCache[1]);
+    }
+    VSize scale(int frame) const
     {
-        uint index = static_cast<uint>(value.property());
-        if (mBitset.test(index)) {
-            mBitset.reset(index);
-            mFilters.erase(std::remove_if(mFilters.begin(), mFilters.end(),
-                                          [&value](const LOTVariant& e) {
-                                              return e.property() ==
-                                                     value.property();
-                                          }),
-                           mFilters.end());
+        if (!cached(frame)) {
+            rlottie::Size sz = mValue.size()(rlottie::FrameInfo(frame));
+            store(frame, sz.w(), sz.h());
         }
+        return VSize(int(mCache[0]), int(mCache[1]));
+    }
+    float value(int frame) const
+    {
+        if (!cached(frame)) {
+            store(frame, mValue.value()(rlottie::FrameInfo(frame)));
+        }
+        return mCache[0];
+    }
+
+private:
+    bool cached(int frame) const { return mValid && mFrame == frame; }
+    void store(int frame, float v0, float v1 = 0, float v2 = 0) const
+    {
+        mCache[0] = v0;
+        mCache[1] = v1;
+        mCache[2] = v2;
+        mFrame = frame;
+        mValid = true;
     }
+
+    LOTVariant    mValue;
+    mutable float mCache[3]{0, 0, 0};
+    mutable int   mFrame{0};
+    mutable bool  mValid{false};
+};
+
+using SharedFilterValue = std::shared_ptr<FilterValue>;
+
+/*
+ * Override slots of an object, one per rlottie::Property.
+ */
+class FilterData {
+public:
+    void addValue(const SharedFilterValue& value)
+    {
+        mSlots[index(value->property())] = value;
+    }
+
+    void removeValue(rlottie::Property prop) { mSlots[index(prop)].reset(); }
+
     bool hasFilter(rlottie::Property prop) const
     {
-        return mBitset.test(static_cast<uint>(prop));
+        return mSlots[index(prop)] != nullptr;
     }
     model::Color color(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Color     col = data(prop).color()(info);
-        return model::Color(col.r(), col.g(), col.b());
+        return mSlots[index(prop)]->color(frame);
     }
     VPointF point(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Point     pt = data(prop).point()(info);
-        return VPointF(pt.x(), pt.y());
+        return mSlots[index(prop)]->point(frame);
     }
     VSize scale(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        rlottie::Size      sz = data(prop).size()(info);
-        return VSize(sz.w(), sz.h());
+        return mSlots[index(prop)]->scale(frame);
     }
     float opacity(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        float              val = data(prop).value()(info);
-        return val / 100;
+        return mSlots[index(prop)]->value(frame) / 100;
     }
     float value(rlottie::Property prop, int frame) const
     {
-        rlottie::FrameInfo info(frame);
-        return data(prop).value()(info);
+        return mSlots[index(prop)]->value(frame);
     }
 
 private:
-    const LOTVariant& data(rlottie::Property prop) const
-    {
-        auto result = std::find_if(
-            mFilters.begin(), mFilters.end(),
-            [prop](const LOTVariant& e) { return e.property() == prop; });
-        return *result;
-    }
-    std::bitset<32>         mBitset{0};
-    std::vector<LOTVariant> mFilters;
+    static constexpr size_t PropertyCount =
+        size_t(rlottie::Property::TrOpacity) + 1;
+
+    static size_t index(rlottie::Property prop) { return size_t(prop); }
+
+    std::array<SharedFilterValue, PropertyCount> mSlots;
 };
 
 template <typename T>
@@ -338,13 +371,14 @@ struct FilterBase
 template <typename T>
 class Filter : public FilterBase<T> {
 public:
-    Filter(T* model): FilterBase<T>(model){}
+    Filter(T* model): FilterBase<T>(model), color_(&model->mColor){}
+    void setColor(const Property<Color>* color) { color_ = color; }
     model::Color color(int frame) const
     {
         if (this->hasFilter(rlottie::Property::StrokeColor)) {
             return this->filter()->color(rlottie::Property::StrokeColor, frame);
         }
-        return this->model()->color(frame);
+        return color_->value(frame);
     }
     float opacity(int frame) const
     {
@@ -370,6 +404,9 @@ public:
     {
         return this->model()->getDashInfo(frameNo, result);
     }
+
+private:
+    const Property<Color>* color_;
 };
 
 
@@ -377,14 +414,17 @@ template <>
 class Filter<model::Fill>: public FilterBase<model::Fill>
 {
 public:
-    Filter(model::Fill* model) : FilterBase<model::Fill>(model) {}
+    Filter(model::Fill* model)
+        : FilterBase<model::Fill>(model), color_(&model->mColor) {}
+
+    void setColor(const Property<Color>* color) { color_ = color; }
 
     model::Color color(int frame) const
     {
         if (this->hasFilter(rlottie::Property::FillColor)) {
             return this->filter()->color(rlottie::Property::FillColor, frame);
         }
-        return this->model()->color(frame);
+        return color_->value(frame);
     }
 
     float opacity(int frame) const
@@ -396,6 +436,9 @@ public:
     }
 
     FillRule fillRule() const { return this->model()->fillRule(); }
+
+private:
+    const Property<Color>* color_;
 };
 
 template <>
@@ -22,7 +22,12 @@
 
 #include "lottieitem.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <cstring>
 #include <iterator>
 #include "lottiekeypath.h"
 #include "vbitmap.h"
@@ -72,24 +77,47 @@ static bool strokeProp(rlottie::Property prop)
     }
 }
 
-static renderer::Layer *createLayerItem(model::Layer *layerData,
-                                        VArenaAlloc * allocator)
+static std::atomic<size_t> Precomp_Release_Delay{0};
+
+static std::atomic<rlottie::LayerCache> Layer_Cache_Policy{
+    rlottie::LayerCache::None};
+
+static std::atomic<rlottie::ImageQuality> Image_Quality{
+    rlottie::ImageQuality::Nearest};
+
+static bool hasLayerItem(const model::Layer *layerData)
+{
+    switch (layerData->mLayerType) {
+    case model::Layer::Type::Precomp:
+    case model::Layer::Type::Solid:
+    case model::Layer::Type::Shape:
+    case model::Layer::Type::Null:
+    case model::Layer::Type::Image:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static renderer::Layer *createLayerItem(model::Layer *         layerData,
+                                        renderer::BuildContext &ctx)
 {
+    auto allocator = ctx.mAllocator;
     switch (layerData->mLayerType) {
     case model::Layer::Type::Precomp: {
-        return allocator->make<renderer::CompLayer>(layerData, allocator);
+        return allocator->make<renderer::CompLayer>(layerData, ctx);
     }
     case model::Layer::Type::Solid: {
         return allocator->make<renderer::SolidLayer>(layerData);
     }
     case model::Layer::Type::Shape: {
-        return allocator->make<renderer::ShapeLayer>(layerData, allocator);
+        return allocator->make<renderer::ShapeLayer>(layerData, ctx);
     }
     case model::Layer::Type::Null: {
         return allocator->make<renderer::NullLayer>(layerData);
     }
     case model::Layer::Type::Image: {
-        return allocator->make<renderer::ImageLayer>(layerData);
+        return allocator->make<renderer::ImageLayer>(layerData, ctx);
     }
     default:
         return nullptr;
@@ -98,19 +126,283 @@ static renderer::Layer *createLayerItem(model::Layer *layerData,
 }
 
 renderer::Composition::Composition(std::shared_ptr<model::Composition> model)
-    : mCurFrameNo(-1)
-{
-    mModel = std::move(model);
-    mRootLayer = createLayerItem(mModel->mRootLayer, &mAllocator);
+    : mModel(std::move(model)),
+      mPrototype(Prototype::shared(mModel.get())),
+      mAllocator(512),
+      mCurFrameNo(-1)
+{
+    mLazy.mLayerCache = Layer_Cache_Policy.load();
+    mLazy.mImageQuality = Image_Quality.load();
+
+    // only the root is built here, the precomp layers build their
+    // content on first activation.
+    BuildContext ctx{&mAllocator, mPrototype, &mLazy};
+    mRootLayer = createLayerItem(mModel->mRootLayer, ctx);
     mRootLayer->setComplexContent(false);
     mViewSize = mModel->size();
 }
 
+renderer::Composition::Composition(std::shared_ptr<model::ColorVariant> variant)
+    : Composition(variant->composition())
+{
+    mColorVariant = std::move(variant);
+    mLazy.mColorVariant = mColorVariant.get();
+    mRootLayer->applyColorVariant(*mColorVariant);
+}
+
 void renderer::Composition::setValue(const std::string &keypath,
-                                     LOTVariant &       value)
+                                     LOTVariant &&      value)
+{
+    if (!mKeyPathIndex) {
+        // the index refers to the nodes of the whole tree, so it is built
+        // completely and never released.
+        mLazy.mPinned = true;
+        mKeyPathIndex = std::make_unique<renderer::KeyPathIndex>();
+        mRootLayer->buildKeyPathIndex(*mKeyPathIndex);
+    }
+
+    const auto &objects = mKeyPathIndex->resolve(keypath, mRootLayer);
+    if (objects.empty()) return;
+
+    // all the resolved objects share the same value.
+    auto shared = std::make_shared<model::FilterValue>(std::move(value));
+    for (auto &obj : objects) {
+        obj->setValue(shared);
+    }
+}
+
+uint renderer::KeyPathIndex::intern(const char *name)
+{
+    auto result = mNames.emplace(name, uint(mNames.size()));
+    return result.first->second;
+}
+
+void renderer::KeyPathIndex::add(const char *name, renderer::Object *obj)
+{
+    if (!push(name)) return;
+    add(obj);
+    pop();
+}
+
+const renderer::KeyPathIndex::ObjectList &renderer::KeyPathIndex::resolve(
+    const std::string &keypath, renderer::Layer *root)
 {
-    LOTKeyPath key(keypath);
-    mRootLayer->resolveKeyPath(key, 0, value);
+    // glob patterns are matched against the tree only once.
+    if (keypath.find('*') != std::string::npos) {
+        auto search = mGlobs.find(keypath);
+        if (search != mGlobs.end()) return search->second;
+
+        auto &     result = mGlobs[keypath];
+        LOTKeyPath key(keypath);
+        root->resolveKeyPath(key, 0, result);
+        return result;
+    }
+
+    // literal keypath, map each key to its interned id.
+    // an unknown key means nothing in the tree can match.
+    mLookup.clear();
+    size_t start = 0;
+    while (start < keypath.size()) {
+        auto end = keypath.find('.', start);
+        if (end == std::string::npos) end = keypath.size();
+
+        auto search = mNames.find(keypath.substr(start, end - start));
+        if (search == mNames.end()) return mEmpty;
+
+        mLookup.push_back(search->second);
+        start = end + 1;
+    }
+
+    auto search = mLiterals.find(mLookup);
+    return (search != mLiterals.end()) ? search->second : mEmpty;
+}
+
+/*
+ * Idle offscreen buffers shared by all the instances. A buffer is filed
+ * under the power of two class of its allocation size, so every buffer of
+ * the class above the one of a request is large enough for it.
+ */
+class SurfacePool {
+public:
+    static SurfacePool &instance()
+    {
+        static SurfacePool singleton;
+        return singleton;
+    }
+
+    VBitmap take(size_t width, size_t height, VBitmap::Format format)
+    {
+        size_t bpp = (format == VBitmap::Format::Alpha8) ? 1 : 4;
+        size_t size = ((width * bpp + 3) & ~size_t(3)) * height;
+        auto   now = Clock::now();
+
+        VBitmap surface;
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            trim(now);
+            // look at most two classes up, not to waste a large buffer.
+            auto first = sizeClass(size);
+            for (auto c = first; c < first + 3 && c < mBuckets.size(); c++) {
+                auto &bucket = mBuckets[c];
+                auto  search = std::find_if(
+                    bucket.rbegin(), bucket.rend(), [size](const Entry &e) {
+                        return e.mSurface.capacity() >= size;
+                    });
+                if (search == bucket.rend()) continue;
+
+                surface = search->mSurface;
+                bucket.erase(std::next(search).base());
+                mBytes -= surface.capacity();
+                break;
+            }
+            if (surface.valid())
+                mHits++;
+            else
+                mMisses++;
+        }
+
+        if (surface.valid()) {
+            surface.reset(width, height, format);
+            return surface;
+        }
+        return {width, height, format};
+    }
+
+    void give(const VBitmap &surface)
+    {
+        size_t size = surface.capacity();
+        if (!size) return;
+
+        auto                        now = Clock::now();
+        std::lock_guard<std::mutex> guard(mMutex);
+        trim(now);
+        if (size > mBudget) return;
+
+        while (mBytes + size > mBudget) evictOldest();
+        mBuckets[sizeClass(size)].push_back({surface, now});
+        mBytes += size;
+    }
+
+    void configure(size_t budget)
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mBudget = budget;
+        while (mBytes > mBudget) evictOldest();
+    }
+
+    rlottie::SurfaceCacheStats stats()
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        rlottie::SurfaceCacheStats stats;
+        stats.hits = mHits;
+        stats.misses = mMisses;
+        for (const auto &bucket : mBuckets) stats.buffers += bucket.size();
+        stats.bytes = mBytes;
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry {
+        VBitmap           mSurface;
+        Clock::time_point mLastUse;
+    };
+
+    SurfacePool() = default;
+
+    static size_t sizeClass(size_t size)
+    {
+        size_t c = 0;
+        while (size >>= 1) c++;
+        return c;
+    }
+
+    void evictOldest()
+    {
+        std::vector<Entry> *oldest = nullptr;
+        size_t              index = 0;
+        for (auto &bucket : mBuckets) {
+            for (size_t i = 0; i < bucket.size(); i++) {
+                if (oldest &&
+                    (*oldest)[index].mLastUse <= bucket[i].mLastUse)
+                    continue;
+                oldest = &bucket;
+                index = i;
+            }
+        }
+        if (!oldest) return;
+
+        mBytes -= (*oldest)[index].mSurface.capacity();
+        oldest->erase(oldest->begin() + long(index));
+    }
+
+    // frees the buffers that were not reused for a while.
+    void trim(Clock::time_point now)
+    {
+        if (now - mLastTrim < Idle_Time) return;
+        mLastTrim = now;
+
+        for (auto &bucket : mBuckets) {
+            auto idle = std::remove_if(
+                bucket.begin(), bucket.end(), [&](const Entry &e) {
+                    if (now - e.mLastUse < Idle_Time) return false;
+                    mBytes -= e.mSurface.capacity();
+                    return true;
+                });
+            bucket.erase(idle, bucket.end());
+        }
+    }
+
+    static constexpr std::chrono::seconds Idle_Time{1};
+
+    std::array<std::vector<Entry>, sizeof(size_t) * CHAR_BIT> mBuckets;
+    std::mutex        mMutex;
+    Clock::time_point mLastTrim{Clock::now()};
+    size_t            mBudget{16 * 1024 * 1024};
+    size_t            mBytes{0};
+    size_t            mHits{0};
+    size_t            mMisses{0};
+};
+
+constexpr std::chrono::seconds SurfacePool::Idle_Time;
+
+VBitmap renderer::SurfaceCache::make_surface(size_t width, size_t height,
+                                             VBitmap::Format format)
+{
+    return SurfacePool::instance().take(width, height, format);
+}
+
+void renderer::SurfaceCache::release_surface(VBitmap &surface)
+{
+    SurfacePool::instance().give(surface);
+}
+
+void renderer::SurfaceCache::configure(size_t budget)
+{
+    SurfacePool::instance().configure(budget);
+}
+
+rlottie::SurfaceCacheStats renderer::SurfaceCache::stats()
+{
+    return SurfacePool::instance().stats();
+}
+
+/*
+ * Offset between two matrices that only differ by a whole pixel
+ * translation, the rasterizer works with a 1/64 pixel precision.
+ */
+static bool pixelOffset(const VMatrix &from, const VMatrix &to, VPoint &offset)
+{
+    if (!vCompare(from.m_11(), to.m_11()) ||
+        !vCompare(from.m_12(), to.m_12()) ||
+        !vCompare(from.m_21(), to.m_21()) || !vCompare(from.m_22(), to.m_22()))
+        return false;
+
+    float dx = to.m_tx() - from.m_tx();
+    float dy = to.m_ty() - from.m_ty();
+    offset = VPoint(int(std::round(dx)), int(std::round(dy)));
+    return std::fabs(dx - offset.x()) <= 1.0f / 64 &&
+           std::fabs(dy - offset.y()) <= 1.0f / 64;
 }
 
 bool renderer::Composition::update(int frameNo, const VSize &size,
@@ -143,21 +435,157 @@ bool renderer::Composition::update(int frameNo, const VSize &size,
     } else {
         m.scale(sx, sy);
     }
+    mLazy.mTick++;
     mRootLayer->update(frameNo, m, 1.0);
+    mLazy.releaseInactive(Precomp_Release_Delay.load());
     return true;
 }
 
-bool renderer::Composition::render(const rlottie::Surface &surface)
+void renderer::LazyBuild::releaseInactive(size_t delay)
 {
+    if (!delay || mPinned) return;
+
+    // a precomp is never more recently active than the precomp it is part
+    // of and is built after it, so walking back to front releases the
+    // nested ones before their parent frees them.
+    auto last = mBuilt.size();
+    for (auto i = mBuilt.size(); i-- > 0;) {
+        auto layer = mBuilt[i];
+        if (mTick - layer->lastActive() > delay) {
+            layer->releaseLayers();
+        } else {
+            mBuilt[--last] = layer;
+        }
+    }
+    mBuilt.erase(mBuilt.begin(), mBuilt.begin() + long(last));
+}
+
+void renderer::configurePrecompReleaseDelay(size_t frameCount)
+{
+    Precomp_Release_Delay.store(frameCount);
+}
+
+void renderer::configureLayerCache(rlottie::LayerCache policy)
+{
+    Layer_Cache_Policy.store(policy);
+}
+
+void renderer::configureImageQuality(rlottie::ImageQuality quality)
+{
+    Image_Quality.store(quality);
+}
+
+// rows of a band of the frame, about 256KB of argb so that the band stays
+// in the l2 cache, next to the layer buffers, from its blending to its
+// conversion.
+static int bandRows(int width)
+{
+    constexpr int bandBytes = 256 * 1024;
+    return std::max(2, bandBytes / (4 * std::max(width, 1))) & ~1;
+}
+
+// blends the frame band by band into a pooled argb buffer and hands each
+// band to write(band, top, rows) while it is still in the cache.
+template <typename Write>
+static void renderBands(renderer::Layer *root, renderer::SurfaceCache &cache,
+                        int width, int height, Write write)
+{
+    if (width <= 0 || height <= 0) return;
+
+    const int rows = std::min(bandRows(width), height);
+    VBitmap   band = cache.make_surface(size_t(width), size_t(rows));
+    for (int top = 0; top < height; top += rows) {
+        const int count = std::min(rows, height - top);
+        VPainter  painter(&band);
+        painter.setDrawRegion(VRect(0, 0, width, count));
+        painter.setDrawOrigin(VPoint(0, top));
+        root->render(&painter, {}, {}, cache);
+        painter.end();
+        write(band, top, count);
+    }
+    cache.release_surface(band);
+}
+
+// writes the rows of a premultiplied argb band into the draw region of a
+// surface of another format, starting at the row top of the region.
+static void writeBand(const VBitmap &band, int top, int rows,
+                      const rlottie::Surface &surface,
+                      rlottie::PixelFormat    format)
+{
+    const int width = int(band.width());
+    size_t    bpp = (format == rlottie::PixelFormat::RGB16_565) ? 2 : 4;
+    auto      base = reinterpret_cast<uchar *>(surface.buffer()) +
+                (surface.drawRegionPosY() + size_t(top)) *
+                    surface.bytesPerLine() +
+                surface.drawRegionPosX() * bpp;
+
+    for (int y = 0; y < rows; y++) {
+        auto src = reinterpret_cast<const uint32_t *>(band.data() +
+                                                      y * band.stride());
+        auto line = base + y * surface.bytesPerLine();
+        auto dest = reinterpret_cast<uint32_t *>(line);
+        switch (format) {
+        case rlottie::PixelFormat::RGBA32:
+            convertPixels(PixelFunc::Type::Unpremultiply, dest, src, width);
+            convertPixels(PixelFunc::Type::SwapRB, dest, dest, width);
+            break;
+        case rlottie::PixelFormat::BGRA32:
+            convertPixels(PixelFunc::Type::Unpremultiply, dest, src, width);
+            break;
+        case rlottie::PixelFormat::RGB16_565:
+            convertToRgb565(reinterpret_cast<uint16_t *>(line), src, width);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool renderer::Composition::render(const rlottie::Surface &surface,
+                                   rlottie::PixelFormat      format)
+{
+    // premultiplied argb and rgba only differ by the order of red and blue
+    // and are blended directly, as is the coverage of an alpha8 surface.
+    // straight alpha and 5-6-5 can not be blended into, those are blended
+    // in bands and each band is written out from the cache.
+    auto target = VBitmap::Format::Invalid;
+    switch (format) {
+    case rlottie::PixelFormat::ARGB32_Premultiplied:
+        target = VBitmap::Format::ARGB32_Premultiplied;
+        break;
+    case rlottie::PixelFormat::RGBA32_Premultiplied:
+        target = VBitmap::Format::RGBA32_Premultiplied;
+        break;
+    case rlottie::PixelFormat::Alpha8:
+        target = VBitmap::Format::Alpha8;
+        break;
+    default:
+        break;
+    }
+
+    VRect clip(0, 0, int(surface.drawRegionWidth()),
+               int(surface.drawRegionHeight()));
+
+    if (target == VBitmap::Format::Invalid) {
+        // cleared as the painter clears a surface it blends into.
+        if (clip.size() != VSize(int(surface.width()), int(surface.height())))
+            memset(surface.buffer(), 0,
+                   surface.bytesPerLine() * surface.height());
+
+        mRootLayer->preprocess(clip);
+        renderBands(mRootLayer, mSurfaceCache, clip.width(), clip.height(),
+                    [&](const VBitmap &band, int top, int rows) {
+                        writeBand(band, top, rows, surface, format);
+                    });
+        return true;
+    }
+
     mSurface.reset(reinterpret_cast<uchar *>(surface.buffer()),
                    uint(surface.width()), uint(surface.height()),
-                   uint(surface.bytesPerLine()),
-                   VBitmap::Format::ARGB32_Premultiplied);
+                   uint(surface.bytesPerLine()), target);
 
     /* schedule all preprocess task for this frame at once.
      */
-    VRect clip(0, 0, int(surface.drawRegionWidth()),
-               int(surface.drawRegionHeight()));
     mRootLayer->preprocess(clip);
 
     VPainter painter(&mSurface);
@@ -170,6 +598,37 @@ bool renderer::Composition::render(const rlottie::Surface &surface)
     return true;
 }
 
+bool renderer::Composition::render(const rlottie::YuvFrame &frame)
+{
+    const int width = int(frame.width);
+    const int height = int(frame.height);
+    if (width <= 0 || height <= 0) return false;
+
+    mRootLayer->preprocess(VRect(0, 0, width, height));
+
+    // the bands have an even number of rows, so no chroma row spans two.
+    uint8_t *v = frame.format == rlottie::YuvFormat::I420 ? frame.v : nullptr;
+    renderBands(mRootLayer, mSurfaceCache, width, height,
+                [&](const VBitmap &band, int top, int rows) {
+        for (int y = 0; y < rows; y += 2) {
+            auto row0 = reinterpret_cast<const uint32_t *>(band.data() +
+                                                           y * band.stride());
+            // the last row of an odd height is paired with itself.
+            auto row1 = y + 1 < rows ? row0 + band.stride() / 4 : row0;
+            auto luma = frame.y + size_t(top + y) * frame.yStride;
+            convertToYuvLuma(luma, row0, width);
+            if (y + 1 < rows)
+                convertToYuvLuma(luma + frame.yStride, row1, width);
+
+            size_t line = size_t(top + y) / 2;
+            convertToYuvChroma(frame.u + line * frame.uStride,
+                               v ? v + line * frame.vStride : nullptr, row0,
+                               row1, width);
+        }
+    });
+    return true;
+}
+
 void renderer::Mask::update(int frameNo, const VMatrix &parentMatrix,
                             float /*parentAlpha*/, const DirtyFlag &flag)
 {
@@ -257,6 +716,66 @@ void renderer::Layer::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+VRect renderer::Layer::bounds(const VRect &clip)
+{
+    VRect bounds;
+    for (auto &i : renderList()) bounds = bounds | i->rle().boundingRect();
+    return bounds & clip;
+}
+
+// the spans of rle inside area that have full coverage.
+static VRle solidSpans(const VRle &rle, const VRect &area)
+{
+    std::vector<VRle::Span> spans;
+    rle.intersect(
+        area,
+        [](size_t count, const VRle::Span *span, void *data) {
+            auto out = static_cast<std::vector<VRle::Span> *>(data);
+            for (size_t i = 0; i < count; i++)
+                if (span[i].coverage == 255) out->push_back(span[i]);
+        },
+        &spans);
+    VRle result;
+    if (!spans.empty()) result.addSpan(spans.data(), spans.size());
+    return result;
+}
+
+static size_t rectArea(const VRect &rect)
+{
+    return rect.empty() ? 0 : size_t(rect.width()) * size_t(rect.height());
+}
+
+static size_t rleArea(const VRle &rle)
+{
+    size_t area = 0;
+    rle.intersect(
+        rle.boundingRect(),
+        [](size_t count, const VRle::Span *span, void *data) {
+            auto out = static_cast<size_t *>(data);
+            for (size_t i = 0; i < count; i++) *out += span[i].len;
+        },
+        &area);
+    return area;
+}
+
+VRle renderer::Layer::opaqueArea(const VRect &area)
+{
+    VRle opaque;
+    if (mLayerMask || hasMatte()) return opaque;
+
+    // any drawable painted on top still blends over an opaque pixel.
+    for (auto &i : renderList()) {
+        if (i->mBrush.type() != VBrush::Type::Solid ||
+            i->mBrush.mColor.alpha() != 255)
+            continue;
+        VRle rle = i->rle();
+        if ((rle.boundingRect() & area).empty()) continue;
+        rle = solidSpans(rle, area);
+        opaque = opaque.empty() ? rle : opaque + rle;
+    }
+    return opaque;
+}
+
 void renderer::LayerMask::preprocess(const VRect &clip)
 {
     for (auto &i : mMasks) {
@@ -289,7 +808,8 @@ void renderer::LayerMask::update(int frameNo, const VMatrix &parentMatrix,
 
 VRle renderer::LayerMask::maskRle(const VRect &clipRect)
 {
-    if (!mDirty) return mRle;
+    // a frame rendered in bands asks for each band.
+    if (!mDirty && clipRect == mClip) return mRle;
 
     VRle rle;
     for (auto &e : mMasks) {
@@ -333,6 +853,7 @@ VRle renderer::LayerMask::maskRle(const VRect &clipRect)
     } else {
         mRle = rle;
     }
+    mClip = clipRect;
     mDirty = false;
     return mRle;
 }
@@ -344,42 +865,62 @@ renderer::Layer::Layer(model::Layer *layerData) : mLayerData(layerData)
 }
 
 bool renderer::Layer::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                     LOTVariant &value)
+                                     KeyPathIndex::ObjectList &)
 {
     if (!keyPath.matches(name(), depth)) {
         return false;
     }
 
     if (!keyPath.skip(name())) {
-        if (keyPath.fullyResolvesTo(name(), depth) &&
-            transformProp(value.property())) {
-            //@TODO handle propery update.
+        if (keyPath.fullyResolvesTo(name(), depth)) {
+            //@TODO handle layer transform property update.
         }
     }
     return true;
 }
 
+void renderer::Layer::buildKeyPathIndex(KeyPathIndex &)
+{
+    //@TODO handle layer transform property update.
+}
+
 bool renderer::ShapeLayer::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                          LOTVariant &value)
+                                          KeyPathIndex::ObjectList &result)
 {
-    if (renderer::Layer::resolveKeyPath(keyPath, depth, value)) {
+    if (renderer::Layer::resolveKeyPath(keyPath, depth, result)) {
         if (keyPath.propagate(name(), depth)) {
             uint newDepth = keyPath.nextDepth(name(), depth);
-            mRoot->resolveKeyPath(keyPath, newDepth, value);
+            mRoot->resolveKeyPath(keyPath, newDepth, result);
         }
         return true;
     }
     return false;
 }
 
+void renderer::ShapeLayer::buildKeyPathIndex(KeyPathIndex &index)
+{
+    // the content can be changed through setValue() from now on.
+    dropRasterCache();
+    bool pushed = index.push(name());
+    mRoot->buildKeyPathIndex(index);
+    if (pushed) index.pop();
+}
+
+void renderer::ShapeLayer::applyColorVariant(
+    const model::ColorVariant &variant)
+{
+    mRoot->applyColorVariant(variant);
+}
+
 bool renderer::CompLayer::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                         LOTVariant &value)
+                                         KeyPathIndex::ObjectList &result)
 {
-    if (renderer::Layer::resolveKeyPath(keyPath, depth, value)) {
+    if (renderer::Layer::resolveKeyPath(keyPath, depth, result)) {
         if (keyPath.propagate(name(), depth)) {
+            buildLayers();
             uint newDepth = keyPath.nextDepth(name(), depth);
             for (const auto &layer : mLayers) {
-                layer->resolveKeyPath(keyPath, newDepth, value);
+                layer->resolveKeyPath(keyPath, newDepth, result);
             }
         }
         return true;
@@ -387,6 +928,26 @@ bool renderer::CompLayer::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
     return false;
 }
 
+void renderer::CompLayer::buildKeyPathIndex(KeyPathIndex &index)
+{
+    // the placements can be changed independently from now on.
+    mInstancing = false;
+    if (mLeader) detachInstance();
+    buildLayers();
+    bool pushed = index.push(name());
+    for (const auto &layer : mLayers) {
+        layer->buildKeyPathIndex(index);
+    }
+    if (pushed) index.pop();
+}
+
+void renderer::CompLayer::applyColorVariant(const model::ColorVariant &variant)
+{
+    for (const auto &layer : mLayers) {
+        layer->applyColorVariant(variant);
+    }
+}
+
 void renderer::Layer::update(int frameNumber, const VMatrix &parentMatrix,
                              float parentAlpha)
 {
@@ -457,9 +1018,35 @@ void renderer::Layer::preprocess(const VRect &clip)
     preprocessStage(clip);
 }
 
-renderer::CompLayer::CompLayer(model::Layer *layerModel, VArenaAlloc *allocator)
-    : renderer::Layer(layerModel)
+renderer::CompLayer::CompLayer(model::Layer *layerModel, BuildContext &ctx)
+    : renderer::Layer(layerModel), mPrototype(ctx.mPrototype), mLazy(ctx.mLazy)
+{
+    mInstancing = mLazy->mLayerCache == rlottie::LayerCache::Bitmap;
+
+    // check if its a nested composition
+    if (!layerModel->layerSize().empty()) {
+        mClipper = std::make_unique<renderer::Clipper>(layerModel->layerSize());
+    }
+
+    // the children are built on first activation (see buildLayers()).
+    auto count = std::count_if(
+        mLayerData->mChildren.begin(), mLayerData->mChildren.end(),
+        [](const auto &child) {
+            return hasLayerItem(static_cast<model::Layer *>(child));
+        });
+    if (count > 1) setComplexContent(true);
+}
+
+void renderer::CompLayer::buildLayers()
 {
+    if (mLayout) return;
+
+    // the children live in their own arena so that they can be released
+    // independently of the rest of the tree.
+    auto size = mPrototype->arenaSize(mLayerData);
+    mArena = std::make_unique<VArenaAlloc>(size ? size : 2048);
+    BuildContext ctx{mArena.get(), mPrototype, mLazy};
+
     if (!mLayerData->mChildren.empty())
         mLayers.reserve(mLayerData->mChildren.size());
 
@@ -468,27 +1055,191 @@ renderer::CompLayer::CompLayer(model::Layer *layerModel, VArenaAlloc *allocator)
     for (auto it = mLayerData->mChildren.crbegin();
          it != mLayerData->mChildren.rend(); ++it) {
         auto model = static_cast<model::Layer *>(*it);
-        auto item = createLayerItem(model, allocator);
+        auto item = createLayerItem(model, ctx);
         if (item) mLayers.push_back(item);
     }
 
-    // 2. update parent layer
-    for (const auto &layer : mLayers) {
-        int id = layer->parentId();
+    // 2. get the parent, matte and active range info shared by all the
+    // instances of this layer.
+    mLayout = &mPrototype->layout(mLayerData, mLayers);
+
+    // 3. update parent layer
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        int parent = mLayout->mParents[i];
+        if (parent >= 0) mLayers[i]->setParentLayer(mLayers[parent]);
+    }
+
+    mPrototype->recordArenaSize(mLayerData, mArena->usedBytes());
+    if (mLazy->mColorVariant) applyColorVariant(*mLazy->mColorVariant);
+    mLazy->mBuilt.push_back(this);
+}
+
+void renderer::CompLayer::releaseLayers()
+{
+    if (mCApiData) {
+        clayers().clear();
+        clayer().mLayerList.ptr = nullptr;
+        clayer().mLayerList.size = 0;
+    }
+    mLayers.clear();
+    mLayout = nullptr;
+    mActiveSegment = ActiveLayerIndex::InvalidSegment;
+    mArena.reset();
+}
+
+renderer::Prototype *renderer::Prototype::shared(model::Composition *model)
+{
+    auto prototype = std::atomic_load(&model->mPrototype);
+    if (!prototype) {
+        auto fresh = std::make_shared<Prototype>();
+        // another instance may have published one in the meantime.
+        if (std::atomic_compare_exchange_strong(&model->mPrototype,
+                                                &prototype, fresh))
+            prototype = std::move(fresh);
+    }
+    return prototype.get();
+}
+
+const renderer::Prototype::CompLayout &renderer::Prototype::layout(
+    const model::Layer *layerData, const std::vector<Layer *> &layers)
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        auto search = mLayouts.find(layerData);
+        if (search != mLayouts.end()) return search->second;
+    }
+
+    CompLayout layout;
+
+    // 1. resolve the parent layer index
+    layout.mParents.resize(layers.size(), -1);
+    for (size_t i = 0; i < layers.size(); i++) {
+        int id = layers[i]->parentId();
         if (id >= 0) {
             auto search =
-                std::find_if(mLayers.begin(), mLayers.end(),
+                std::find_if(layers.begin(), layers.end(),
                              [id](const auto &val) { return val->id() == id; });
-            if (search != mLayers.end()) layer->setParentLayer(*search);
+            if (search != layers.end())
+                layout.mParents[i] = int(search - layers.begin());
         }
     }
 
-    // 4. check if its a nested composition
-    if (!layerModel->layerSize().empty()) {
-        mClipper = std::make_unique<renderer::Clipper>(layerModel->layerSize());
+    // 2. pair the matte layers with their source layer.
+    // a matte layer uses the layer right after it (in back-to-front order)
+    // as its source. neither of them is rendered standalone.
+    layout.mMatteRoles.resize(layers.size(), MatteRole::None);
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (!layers[i]->hasMatte()) continue;
+        if (i + 1 < layers.size() && !layers[i + 1]->hasMatte()) {
+            layout.mMatteRoles[i] = MatteRole::Target;
+            layout.mMatteRoles[i + 1] = MatteRole::Source;
+        } else {
+            layout.mMatteRoles[i] = MatteRole::Unused;
+        }
     }
 
-    if (mLayers.size() > 1) setComplexContent(true);
+    // 3. bucket the layers by their active frame range
+    layout.mActiveIndex.build(layers);
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mLayouts.emplace(layerData, std::move(layout)).first->second;
+}
+
+size_t renderer::Prototype::arenaSize(const model::Layer *layerData)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto search = mArenaSizes.find(layerData);
+    return (search != mArenaSizes.end()) ? search->second : 0;
+}
+
+void renderer::Prototype::recordArenaSize(const model::Layer *layerData,
+                                          size_t              size)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto &current = mArenaSizes[layerData];
+    current = std::max(current, size);
+}
+
+void renderer::Prototype::shareStaticPath(const model::Object *data,
+                                          Shape *              shape)
+{
+    if (!shape->staticPath()) return;
+
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        auto search = mPaths.find(data);
+        if (search != mPaths.end()) {
+            shape->mLocalPath = search->second;
+            return;
+        }
+    }
+
+    // static path doesn't depend on the frame number.
+    shape->updatePath(shape->mLocalPath, 0);
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    mPaths.emplace(data, shape->mLocalPath);
+}
+
+void renderer::ActiveLayerIndex::build(const std::vector<Layer *> &layers)
+{
+    mBounds.clear();
+    mOffsets.clear();
+    mIndices.clear();
+
+    for (const auto &layer : layers) {
+        if (layer->inFrame() >= layer->outFrame()) continue;
+        mBounds.push_back(layer->inFrame());
+        mBounds.push_back(layer->outFrame());
+    }
+    std::sort(mBounds.begin(), mBounds.end());
+    mBounds.erase(std::unique(mBounds.begin(), mBounds.end()), mBounds.end());
+
+    if (mBounds.size() < 2) {
+        mBounds.clear();
+        return;
+    }
+
+    // segment i covers [mBounds[i], mBounds[i + 1])
+    auto segmentRange = [this](const Layer *layer) {
+        auto first = std::lower_bound(mBounds.begin(), mBounds.end(),
+                                      layer->inFrame());
+        auto last = std::lower_bound(first, mBounds.end(), layer->outFrame());
+        return std::make_pair(size_t(first - mBounds.begin()),
+                              size_t(last - mBounds.begin()));
+    };
+
+    // 1. count the layers per segment
+    std::vector<uint> counts(mBounds.size(), 0);
+    for (const auto &layer : layers) {
+        if (layer->inFrame() >= layer->outFrame()) continue;
+        auto range = segmentRange(layer);
+        for (size_t i = range.first; i < range.second; i++) counts[i]++;
+    }
+
+    // 2. convert the counts to offsets
+    mOffsets.resize(mBounds.size(), 0);
+    for (size_t i = 1; i < mOffsets.size(); i++)
+        mOffsets[i] = mOffsets[i - 1] + counts[i - 1];
+
+    // 3. fill the segments, visiting the layers in order keeps
+    // each segment sorted in back-to-front order.
+    mIndices.resize(mOffsets.back());
+    std::vector<uint> cursor(mOffsets.begin(), mOffsets.end());
+    for (uint index = 0; index < layers.size(); index++) {
+        const auto layer = layers[index];
+        if (layer->inFrame() >= layer->outFrame()) continue;
+        auto range = segmentRange(layer);
+        for (size_t i = range.first; i < range.second; i++)
+            mIndices[cursor[i]++] = index;
+    }
+}
+
+int renderer::ActiveLayerIndex::segment(int frameNo) const
+{
+    auto it = std::upper_bound(mBounds.begin(), mBounds.end(), frameNo);
+    if (it == mBounds.begin() || it == mBounds.end()) return -1;
+    return int(it - mBounds.begin()) - 1;
 }
 
 void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
@@ -496,17 +1247,42 @@ void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
 {
     if (vIsZero(combinedAlpha())) return;
 
+    // identical placements share the pixels of the first one.
+    if (mLeader) {
+        mLeader->renderInstance(painter, inheritMask, mInstanceOffset);
+        return;
+    }
+    if (mInstanced) {
+        if (!mInstanceBitmap.valid()) {
+            // the followers may need any part of the content, not only the
+            // one under the painter.
+            VRect area = mClipper->rle({}).boundingRect();
+            if (area.empty()) return;
+            mInstanceOrigin = VPoint(area.left(), area.top());
+            mInstanceBitmap = cache.make_surface(area.width(), area.height());
+            VPainter srcPainter;
+            srcPainter.begin(&mInstanceBitmap);
+            srcPainter.setDrawOrigin(mInstanceOrigin);
+            renderHelper(&srcPainter, {}, matteRle, cache);
+            srcPainter.end();
+        }
+        renderInstance(painter, inheritMask, VPoint());
+        return;
+    }
+
     if (vCompare(combinedAlpha(), 1.0)) {
         renderHelper(painter, inheritMask, matteRle, cache);
     } else {
         if (complexContent()) {
-            VSize    size = painter->clipBoundingRect().size();
+            VRect    area = painter->clipBoundingRect();
+            VPoint   origin(area.left(), area.top());
             VPainter srcPainter;
-            VBitmap srcBitmap = cache.make_surface(size.width(), size.height());
+            VBitmap srcBitmap = cache.make_surface(area.width(), area.height());
             srcPainter.begin(&srcBitmap);
+            srcPainter.setDrawOrigin(origin);
             renderHelper(&srcPainter, inheritMask, matteRle, cache);
             srcPainter.end();
-            painter->drawBitmap(VPoint(), srcBitmap,
+            painter->drawBitmap(origin, srcBitmap,
                                 uchar(combinedAlpha() * 255.0f));
             cache.release_surface(srcBitmap);
         } else {
@@ -515,6 +1291,13 @@ void renderer::CompLayer::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+VRect renderer::CompLayer::bounds(const VRect &clip)
+{
+    // a placement that follows another one has no clip of its own.
+    if (!mClipper || mLeader) return clip;
+    return mClipper->rle({}).boundingRect() & clip;
+}
+
 void renderer::CompLayer::renderHelper(VPainter *    painter,
                                        const VRle &  inheritMask,
                                        const VRle &  matteRle,
@@ -531,27 +1314,146 @@ void renderer::CompLayer::renderHelper(VPainter *    painter,
     }
 
     if (mClipper) {
-        mask = mClipper->rle(mask);
+        mask = mClipper->rle(mask, painter->clipBoundingRect());
         if (mask.empty()) return;
     }
 
-    renderer::Layer *matte = nullptr;
-    for (const auto &layer : mLayers) {
-        if (layer->hasMatte()) {
-            matte = layer;
-        } else {
-            if (layer->visible()) {
-                if (matte) {
-                    if (matte->visible())
-                        renderMatteLayer(painter, mask, matteRle, matte, layer,
-                                         cache);
-                } else {
-                    layer->render(painter, mask, matteRle, cache);
+    auto layers = activeLayers();
+    // the matte would let the layers below show through the opaque ones.
+    const bool culled = matteRle.empty();
+    if (culled) cullOccluded(layers, painter->clipBoundingRect(), mask);
+
+    for (size_t k = 0; k < layers.size(); k++) {
+        auto i = layers[k];
+        auto layer = mLayers[i];
+        if (!layer->visible()) continue;
+
+        const VRle *layerMask = &mask;
+        if (culled) {
+            if (mOcclusion[k].mVisibility == Visibility::Hidden) continue;
+            if (mOcclusion[k].mVisibility == Visibility::Clipped)
+                layerMask = &mOcclusion[k].mUncovered;
+        }
+
+        switch (mLayout->mMatteRoles[i]) {
+        case MatteRole::None:
+            layer->render(painter, *layerMask, matteRle, cache);
+            break;
+        case MatteRole::Target: {
+            auto src = mLayers[i + 1];
+            if (src->visible())
+                renderMatteLayer(painter, *layerMask, matteRle, layer, src,
+                                 cache);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // all the placements are drawn.
+    for (auto leader : mLeaders) {
+        if (!leader->mInstanceBitmap.valid()) continue;
+        cache.release_surface(leader->mInstanceBitmap);
+        leader->mInstanceBitmap = VBitmap();
+    }
+}
+
+bool renderer::CompLayer::sharesPixels(Layer *layer) const
+{
+    return layer->precompLayer() && static_cast<CompLayer *>(layer)->mInstanced;
+}
+
+void renderer::CompLayer::cullOccluded(VSpan<const uint> layers,
+                                       const VRect &clip, const VRle &mask)
+{
+    if (mOcclusion.size() < layers.size()) mOcclusion.resize(layers.size());
+
+    VRect below;
+    for (size_t k = 0; k < layers.size(); k++) {
+        auto  i = layers[k];
+        auto &entry = mOcclusion[k];
+        entry.mVisibility = Visibility::Full;
+        entry.mBelow = below;
+        entry.mBounds = VRect();
+        auto role = mLayout->mMatteRoles[i];
+        if (!mLayers[i]->visible() || role == MatteRole::Source ||
+            role == MatteRole::Unused)
+            continue;
+        // the followers draw from the pixels the leader renders.
+        if (sharesPixels(mLayers[i]) ||
+            (role == MatteRole::Target && sharesPixels(mLayers[i + 1])))
+            continue;
+        entry.mBounds = mLayers[i]->bounds(clip);
+        below = below | entry.mBounds;
+    }
+
+    // walk top down, gathering the pixels the layers above paint over.
+    VRle  opaque;
+    VRect opaqueBox;
+    for (size_t k = layers.size(); k-- > 0;) {
+        auto  i = layers[k];
+        auto &entry = mOcclusion[k];
+        if (entry.mBounds.empty()) continue;
+
+        // clipping away a small part costs more than blending it.
+        const size_t size = rectArea(entry.mBounds);
+        if (2 * rectArea(entry.mBounds & opaqueBox) >= size) {
+            VRle covered = entry.mBounds & opaque;
+            if (opaqueBox.contains(entry.mBounds) && rleArea(covered) == size) {
+                entry.mVisibility = Visibility::Hidden;
+                continue;
+            }
+            if (!covered.empty()) {
+                entry.mUncovered = entry.mBounds - opaque;
+                if (!mask.empty()) entry.mUncovered = entry.mUncovered & mask;
+                // an empty mask would not clip at all.
+                if (entry.mUncovered.empty()) {
+                    entry.mVisibility = Visibility::Hidden;
+                    continue;
                 }
+                entry.mVisibility = Visibility::Clipped;
             }
-            matte = nullptr;
         }
+
+        // only the pixels over the layers underneath are of any use, and
+        // only a large enough part of the view pays for the rle work.
+        VRect reach = entry.mBounds & entry.mBelow;
+        if (mLayout->mMatteRoles[i] != MatteRole::None ||
+            8 * rectArea(reach) < rectArea(clip))
+            continue;
+        VRle area = mLayers[i]->opaqueArea(reach);
+        if (area.empty()) continue;
+        // the inherited mask scales the coverage down.
+        if (!mask.empty()) area = solidSpans(area & mask, area.boundingRect());
+        opaque = opaque.empty() ? area : opaque + area;
+        opaqueBox = opaqueBox | area.boundingRect();
+    }
+}
+
+void renderer::CompLayer::renderInstance(VPainter *painter, const VRle &mask,
+                                         const VPoint &offset)
+{
+    // the bitmap holds the bounds of the content, the painter clips it.
+    if (!mInstanceBitmap.valid()) return;
+    VPoint origin(mInstanceOrigin.x() + offset.x(),
+                  mInstanceOrigin.y() + offset.y());
+    VRect  source = mInstanceBitmap.rect();
+    uchar alpha = complexContent() ? uchar(combinedAlpha() * 255.0f) : 255;
+
+    if (mask.empty()) {
+        painter->drawBitmap(VRect(origin, source.size()), mInstanceBitmap,
+                            source, alpha);
+        return;
     }
+
+    VTexture texture;
+    texture.mBitmap = mInstanceBitmap;
+    texture.mMatrix.translate(float(origin.x()), float(origin.y()));
+    texture.mAlpha = alpha;
+    painter->setBrush(VBrush(&texture));
+    painter->drawRle(VPoint(),
+                     source.translated(origin.x(), origin.y()) & mask);
 }
 
 void renderer::CompLayer::renderMatteLayer(VPainter *painter, const VRle &mask,
@@ -560,53 +1462,116 @@ void renderer::CompLayer::renderMatteLayer(VPainter *painter, const VRle &mask,
                                            renderer::Layer *src,
                                            SurfaceCache &   cache)
 {
-    VSize size = painter->clipBoundingRect().size();
-    // Decide if we can use fast matte.
+    if (renderRleMatte(painter, mask, layer, src, cache)) return;
+
+    // only the pixels of the layer can change, and with a non inverted
+    // matte only the ones the matte covers too.
+    VRect area = layer->bounds(painter->clipBoundingRect());
+    if (layer->matteType() == model::MatteType::Alpha ||
+        layer->matteType() == model::MatteType::Luma)
+        area = src->bounds(area);
+    if (area.empty()) return;
+    VPoint origin(area.left(), area.top());
+
+    // alpha mattes only need the coverage of the src layer, luma mattes
+    // need its color and take the luminosity while blending.
+    const bool luma = layer->matteType() == model::MatteType::Luma ||
+                      layer->matteType() == model::MatteType::LumaInv;
+
     // 1. draw src layer to matte buffer
     VPainter srcPainter;
-    VBitmap  srcBitmap = cache.make_surface(size.width(), size.height());
+    VBitmap  srcBitmap = cache.make_surface(
+        area.width(), area.height(),
+        luma ? VBitmap::Format::ARGB32_Premultiplied : VBitmap::Format::Alpha8);
     srcPainter.begin(&srcBitmap);
+    srcPainter.setDrawOrigin(origin);
     src->render(&srcPainter, mask, matteRle, cache);
     srcPainter.end();
 
     // 2. draw layer to layer buffer
     VPainter layerPainter;
-    VBitmap  layerBitmap = cache.make_surface(size.width(), size.height());
+    VBitmap  layerBitmap = cache.make_surface(area.width(), area.height());
     layerPainter.begin(&layerBitmap);
+    layerPainter.setDrawOrigin(origin);
     layer->render(&layerPainter, mask, matteRle, cache);
 
     // 2.1update composition mode
     switch (layer->matteType()) {
-    case model::MatteType::Alpha:
-    case model::MatteType::Luma: {
+    case model::MatteType::Alpha: {
         layerPainter.setBlendMode(BlendMode::DestIn);
         break;
     }
-    case model::MatteType::AlphaInv:
-    case model::MatteType::LumaInv: {
+    case model::MatteType::AlphaInv: {
         layerPainter.setBlendMode(BlendMode::DestOut);
         break;
     }
-    default:
+    case model::MatteType::Luma: {
+        layerPainter.setBlendMode(BlendMode::DestInLuma);
         break;
     }
-
-    // 2.2 update srcBuffer if the matte is luma type
-    if (layer->matteType() == model::MatteType::Luma ||
-        layer->matteType() == model::MatteType::LumaInv) {
-        srcBitmap.updateLuma();
+    case model::MatteType::LumaInv: {
+        layerPainter.setBlendMode(BlendMode::DestOutLuma);
+        break;
+    }
+    default:
+        break;
     }
 
-    // 2.3 draw src buffer as mask
-    layerPainter.drawBitmap(VPoint(), srcBitmap);
+    // 2.2 draw src buffer as mask
+    layerPainter.drawBitmap(origin, srcBitmap);
     layerPainter.end();
     // 3. draw the result buffer into painter
-    painter->drawBitmap(VPoint(), layerBitmap);
+    painter->drawBitmap(origin, layerBitmap);
 
     cache.release_surface(srcBitmap);
     cache.release_surface(layerBitmap);
 }
 
+/*
+ * An alpha matte made of solid colored shapes is just coverage, so it can
+ * be applied to a single drawable layer as an rle intersection without any
+ * offscreen buffer. With more drawables the matte has to be applied to their
+ * composition, otherwise overlapping edges get covered twice.
+ */
+bool renderer::CompLayer::renderRleMatte(VPainter *painter, const VRle &mask,
+                                         renderer::Layer *layer,
+                                         renderer::Layer *src,
+                                         SurfaceCache &   cache)
+{
+    auto type = layer->matteType();
+    if (type != model::MatteType::Alpha && type != model::MatteType::AlphaInv)
+        return false;
+    if (!layer->shapeContent() || !src->shapeContent() || src->hasMask() ||
+        src->hasMatte() || layer->renderList().size() != 1)
+        return false;
+
+    auto renderlist = src->renderList();
+    for (auto drawable : renderlist) {
+        if (drawable->mBrush.type() != VBrush::Type::Solid) return false;
+    }
+
+    // a band of the frame is matted by the part of the source in it.
+    const VRect clip = painter->clipBoundingRect();
+    VRle        matte;
+    if (src->skipRendering()) renderlist = {};
+    for (auto drawable : renderlist) {
+        VRle rle = drawable->rle();
+        if (!clip.contains(rle.boundingRect())) rle = clip & rle;
+        if (drawable->mBrush.mColor.a != 255) rle *= drawable->mBrush.mColor.a;
+        matte = matte.empty() ? rle : matte + rle;
+    }
+    if (!mask.empty()) matte = matte & mask;
+
+    if (matte.empty()) {
+        // nothing is covered, an inverted matte keeps the whole layer.
+        if (type == model::MatteType::AlphaInv)
+            layer->render(painter, mask, {}, cache);
+        return true;
+    }
+    layer->render(painter, mask, matte, cache);
+    return true;
+}
+
 void renderer::Clipper::update(const VMatrix &matrix)
 {
     mPath.reset();
@@ -622,49 +1587,159 @@ void renderer::Clipper::preprocess(const VRect &clip)
     mRasterRequest = false;
 }
 
-VRle renderer::Clipper::rle(const VRle &mask)
+VRle renderer::Clipper::rle(const VRle &mask, const VRect &clip)
 {
     if (mask.empty()) return mRasterizer.rle();
 
-    mMaskedRle.clone(mask);
+    // a frame drawn in bands needs only the part of the mask in the band.
+    if (!clip.contains(mask.boundingRect()))
+        mMaskedRle = clip & mask;
+    else
+        mMaskedRle.clone(mask);
     mMaskedRle &= mRasterizer.rle();
     return mMaskedRle;
 }
 
 void renderer::CompLayer::updateContent()
 {
-    if (mClipper && flag().testFlag(DirtyFlagBit::Matrix)) {
+    mLastActive = mLazy->mTick;
+
+    // an identical placement updated before this one renders it as well.
+    if (mLeader) {
+        if (followLeader()) return;
+        mLeader = nullptr;
+    }
+    buildLayers();
+
+    // the clipper is stale as well after following a leader.
+    if (mClipper && (flag().testFlag(DirtyFlagBit::Matrix) ||
+                     mActiveSegment == ActiveLayerIndex::InvalidSegment)) {
         mClipper->update(combinedMatrix());
     }
     int   mappedFrame = mLayerData->timeRemap(frameNo());
     float alpha = combinedAlpha();
     if (complexContent()) alpha = 1;
-    for (const auto &layer : mLayers) {
-        layer->update(mappedFrame, combinedMatrix(), alpha);
+
+    mLeaders.clear();
+    int segment = mLayout->mActiveIndex.segment(mappedFrame);
+    if (mActiveSegment == ActiveLayerIndex::InvalidSegment) {
+        // first update, bring every layer to a known state.
+        for (uint i = 0; i < mLayers.size(); i++) {
+            updateLayer(i, mappedFrame, alpha);
+        }
+    } else {
+        // layers leaving the active set only need to see the new frame
+        // number so that they report themselves as not visible.
+        if (segment != mActiveSegment) {
+            for (auto i : activeLayers()) {
+                auto layer = mLayers[i];
+                if (mappedFrame < layer->inFrame() ||
+                    mappedFrame >= layer->outFrame())
+                    layer->update(mappedFrame, combinedMatrix(), alpha);
+            }
+        }
+        for (auto i : mLayout->mActiveIndex.layers(segment)) {
+            updateLayer(i, mappedFrame, alpha);
+        }
+    }
+    mActiveSegment = segment;
+}
+
+void renderer::CompLayer::updateLayer(uint index, int frameNo, float alpha)
+{
+    auto layer = mLayers[index];
+    if (!mInstancing || !layer->precompLayer() ||
+        mLayout->mMatteRoles[index] != MatteRole::None) {
+        layer->update(frameNo, combinedMatrix(), alpha);
+        return;
+    }
+
+    // placements of the same precomp that only differ by a whole pixel
+    // translation are rendered once.
+    auto comp = static_cast<CompLayer *>(layer);
+    auto search =
+        std::find_if(mLeaders.begin(), mLeaders.end(),
+                     [comp](const auto &val) { return val->sameContent(comp); });
+    comp->mLeader = (search != mLeaders.end()) ? *search : nullptr;
+    comp->update(frameNo, combinedMatrix(), alpha);
+    if (!comp->mLeader) {
+        comp->mInstanced = false;
+        mLeaders.push_back(comp);
     }
 }
 
+bool renderer::CompLayer::sameContent(const CompLayer *other) const
+{
+    const auto &children = mLayerData->mChildren;
+    const auto &otherChildren = other->mLayerData->mChildren;
+    return mClipper && !mLayerMask && !other->mLayerMask &&
+           mLayerData->layerSize() == other->mLayerData->layerSize() &&
+           !children.empty() && children.size() == otherChildren.size() &&
+           children.front() == otherChildren.front();
+}
+
+bool renderer::CompLayer::followLeader()
+{
+    auto leader = mLeader;
+    if (!leader->visible() || vIsZero(leader->combinedAlpha()) ||
+        !vCompare(combinedAlpha(), leader->combinedAlpha()))
+        return false;
+
+    if (mLayerData->timeRemap(frameNo()) !=
+        leader->mLayerData->timeRemap(leader->frameNo()))
+        return false;
+
+    if (!pixelOffset(leader->combinedMatrix(), combinedMatrix(),
+                     mInstanceOffset))
+        return false;
+
+    leader->mInstanced = true;
+    // the content is brought up to date once this stops following.
+    mActiveSegment = ActiveLayerIndex::InvalidSegment;
+    return true;
+}
+
+void renderer::CompLayer::detachInstance()
+{
+    mLeader = nullptr;
+    updateContent();
+}
+
 void renderer::CompLayer::preprocessStage(const VRect &clip)
 {
+    // the pixels of the leader have to hold the visible part of the
+    // placement.
+    if (mLeader) {
+        VRect bounds = mLeader->combinedMatrix().map(
+            VRect(VPoint(), mLeader->mClipper->mSize));
+        bounds = VRect(bounds.x() - 1, bounds.y() - 1, bounds.width() + 2,
+                       bounds.height() + 2);
+        VRect visible =
+            bounds & clip.translated(-mInstanceOffset.x(), -mInstanceOffset.y());
+        if (visible.empty() || clip.contains(visible)) return;
+        detachInstance();
+    }
     // if layer has clipper
     if (mClipper) mClipper->preprocess(clip);
 
-    renderer::Layer *matte = nullptr;
-    for (const auto &layer : mLayers) {
-        if (layer->hasMatte()) {
-            matte = layer;
-        } else {
-            if (layer->visible()) {
-                if (matte) {
-                    if (matte->visible()) {
-                        layer->preprocess(clip);
-                        matte->preprocess(clip);
-                    }
-                } else {
-                    layer->preprocess(clip);
-                }
+    for (auto i : activeLayers()) {
+        auto layer = mLayers[i];
+        if (!layer->visible()) continue;
+
+        switch (mLayout->mMatteRoles[i]) {
+        case MatteRole::None:
+            layer->preprocess(clip);
+            break;
+        case MatteRole::Target: {
+            auto src = mLayers[i + 1];
+            if (src->visible()) {
+                src->preprocess(clip);
+                layer->preprocess(clip);
             }
-            matte = nullptr;
+            break;
+        }
+        default:
+            break;
         }
     }
 }
@@ -705,7 +1780,7 @@ renderer::DrawableList renderer::SolidLayer::renderList()
     return {&mDrawableList, 1};
 }
 
-renderer::ImageLayer::ImageLayer(model::Layer *layerData)
+renderer::ImageLayer::ImageLayer(model::Layer *layerData, BuildContext &ctx)
     : renderer::Layer(layerData)
 {
     mDrawableList = &mRenderNode;
@@ -713,6 +1788,8 @@ renderer::ImageLayer::ImageLayer(model::Layer *layerData)
     if (!mLayerData->asset()) return;
 
     mTexture.mBitmap = mLayerData->asset()->bitmap();
+    if (ctx.mLazy->mImageQuality == rlottie::ImageQuality::Bilinear)
+        mTexture.mFilter = VTexture::Filter::Bilinear;
     VBrush brush(&mTexture);
     mRenderNode.setBrush(brush);
 }
@@ -754,29 +1831,37 @@ renderer::NullLayer::NullLayer(model::Layer *layerData)
 }
 void renderer::NullLayer::updateContent() {}
 
-static renderer::Object *createContentItem(model::Object *contentData,
-                                           VArenaAlloc *  allocator)
+template <typename T, typename Data>
+static renderer::Object *createShapeItem(model::Object *         contentData,
+                                         renderer::BuildContext &ctx)
 {
+    auto shape = ctx.mAllocator->make<T>(static_cast<Data *>(contentData));
+    ctx.mPrototype->shareStaticPath(contentData, shape);
+    return shape;
+}
+
+static renderer::Object *createContentItem(model::Object *         contentData,
+                                           renderer::BuildContext &ctx)
+{
+    auto allocator = ctx.mAllocator;
     switch (contentData->type()) {
     case model::Object::Type::Group: {
         return allocator->make<renderer::Group>(
-            static_cast<model::Group *>(contentData), allocator);
+            static_cast<model::Group *>(contentData), ctx);
     }
     case model::Object::Type::Rect: {
-        return allocator->make<renderer::Rect>(
-            static_cast<model::Rect *>(contentData));
+        return createShapeItem<renderer::Rect, model::Rect>(contentData, ctx);
     }
     case model::Object::Type::Ellipse: {
-        return allocator->make<renderer::Ellipse>(
-            static_cast<model::Ellipse *>(contentData));
+        return createShapeItem<renderer::Ellipse, model::Ellipse>(contentData,
+                                                                  ctx);
     }
     case model::Object::Type::Path: {
-        return allocator->make<renderer::Path>(
-            static_cast<model::Path *>(contentData));
+        return createShapeItem<renderer::Path, model::Path>(contentData, ctx);
     }
     case model::Object::Type::Polystar: {
-        return allocator->make<renderer::Polystar>(
-            static_cast<model::Polystar *>(contentData));
+        return createShapeItem<renderer::Polystar, model::Polystar>(
+            contentData, ctx);
     }
     case model::Object::Type::Fill: {
         return allocator->make<renderer::Fill>(
@@ -796,7 +1881,7 @@ static renderer::Object *createContentItem(model::Object *contentData,
     }
     case model::Object::Type::Repeater: {
         return allocator->make<renderer::Repeater>(
-            static_cast<model::Repeater *>(contentData), allocator);
+            static_cast<model::Repeater *>(contentData), ctx);
     }
     case model::Object::Type::Trim: {
         return allocator->make<renderer::Trim>(
@@ -808,25 +1893,45 @@ static renderer::Object *createContentItem(model::Object *contentData,
     }
 }
 
-renderer::ShapeLayer::ShapeLayer(model::Layer *layerData,
-                                 VArenaAlloc * allocator)
+renderer::ShapeLayer::ShapeLayer(model::Layer *layerData, BuildContext &ctx)
     : renderer::Layer(layerData),
-      mRoot(allocator->make<renderer::Group>(nullptr, allocator))
+      mRoot(ctx.mAllocator->make<renderer::Group>(nullptr, ctx))
 {
-    mRoot->addChildren(layerData, allocator);
+    mRoot->addChildren(layerData, ctx);
 
-    std::vector<renderer::Shape *> list;
-    mRoot->processPaintItems(list);
+    // scratch list, the items are copied to the arena by the owners.
+    static vthread_local std::vector<renderer::Shape *> list;
+    list.clear();
+    mRoot->processPaintItems(list, ctx.mAllocator);
 
     if (layerData->hasPathOperator()) {
         list.clear();
-        mRoot->processTrimItems(list);
+        mRoot->processTrimItems(list, ctx.mAllocator);
+    }
+
+    // only the transform and opacity of the layer can change, so its
+    // raster can be kept from one frame to the next.
+    auto policy = ctx.mLazy->mLayerCache;
+    if (policy != rlottie::LayerCache::None && !layerData->hasMask() &&
+        std::all_of(layerData->mChildren.begin(), layerData->mChildren.end(),
+                    [](const auto &child) { return child->isStatic(); })) {
+        mRasterCache = std::make_unique<renderer::RasterCache>(
+            policy == rlottie::LayerCache::Bitmap);
     }
 }
 
 void renderer::ShapeLayer::updateContent()
 {
-    mRoot->update(frameNo(), combinedMatrix(), combinedAlpha(), flag());
+    DirtyFlag dirty = flag();
+    if (mRasterCache) {
+        if (mRasterCache->reuse(combinedMatrix(), dirty,
+                                {mDrawableList.data(), mDrawableList.size()}))
+            return;
+        // the paths still describe the position the raster was made at.
+        if (mRasterCache->invalidate()) dirty |= DirtyFlagBit::Matrix;
+    }
+
+    mRoot->update(frameNo(), combinedMatrix(), combinedAlpha(), dirty);
 
     if (mLayerData->hasPathOperator()) {
         mRoot->applyTrim();
@@ -839,6 +1944,117 @@ void renderer::ShapeLayer::preprocessStage(const VRect &clip)
     mRoot->renderList(mDrawableList);
 
     for (auto &drawable : mDrawableList) drawable->preprocess(clip);
+
+    if (mRasterCache) mRasterCache->rasterized(combinedMatrix(), clip);
+}
+
+void renderer::ShapeLayer::render(VPainter *painter, const VRle &mask,
+                                  const VRle &matteRle, SurfaceCache &cache)
+{
+    // the kept pixels hold neither the mask nor the matte.
+    if (mRasterCache && mask.empty() && matteRle.empty()) {
+        auto renderlist = renderList();
+        if (renderlist.empty()) return;
+        if (mRasterCache->render(painter, renderlist)) return;
+    }
+    renderer::Layer::render(painter, mask, matteRle, cache);
+}
+
+VRle renderer::ShapeLayer::opaqueArea(const VRect &area)
+{
+    // the kept pixels are blitted with a rounding loss.
+    if (mRasterCache && mRasterCache->keepsBitmap()) return {};
+    return renderer::Layer::opaqueArea(area);
+}
+
+void renderer::ShapeLayer::dropRasterCache()
+{
+    if (!mRasterCache) return;
+    if (mRasterCache->invalidate()) mDirtyFlag |= DirtyFlagBit::Matrix;
+    mRasterCache.reset();
+}
+
+bool renderer::RasterCache::reuse(const VMatrix &matrix, const DirtyFlag &flag,
+                                  DrawableList drawables)
+{
+    if (!mValid || (flag & DirtyFlagBit::Alpha)) return false;
+
+    VPoint offset;
+    if (!pixelOffset(mMatrix, matrix, offset)) return false;
+
+    if (offset.x() || offset.y()) {
+        // a gradient would have to move along, and a clipped raster can't
+        // be moved into the view.
+        for (auto drawable : drawables) {
+            if (drawable->mBrush.type() != VBrush::Type::Solid) return false;
+            auto bbox = drawable->rle().boundingRect();
+            if (!bbox.empty() && !mClip.contains(bbox, true)) return false;
+        }
+        for (auto drawable : drawables) drawable->mRasterizer.translate(offset);
+
+        mMatrix *= VMatrix().translate(float(offset.x()), float(offset.y()));
+        mBitmapPos += offset;
+        mMoved = true;
+    }
+    mReused = true;
+    return true;
+}
+
+void renderer::RasterCache::rasterized(const VMatrix &matrix, const VRect &clip)
+{
+    // the raster may come from any of the previous clips, keep the
+    // smallest one.
+    mClip = mClip.empty() ? clip : (mClip & clip);
+
+    if (mValid) return;
+    mMatrix = matrix;
+    mValid = true;
+}
+
+bool renderer::RasterCache::invalidate()
+{
+    bool moved = mMoved;
+    mValid = mMoved = mReused = false;
+    mBitmap = VBitmap();
+    return moved;
+}
+
+bool renderer::RasterCache::render(VPainter *painter, DrawableList drawables)
+{
+    // keep the pixels once the layer stayed static for a frame.
+    if (!mKeepBitmap || !mValid || !mReused) return false;
+
+    if (!mBitmap.valid()) {
+        int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+        for (auto drawable : drawables) {
+            // a gradient is bound to the surface coordinates.
+            if (drawable->mBrush.type() != VBrush::Type::Solid) return false;
+            auto bbox = drawable->rle().boundingRect();
+            if (bbox.empty()) continue;
+            left = std::min(left, bbox.left());
+            top = std::min(top, bbox.top());
+            right = std::max(right, bbox.right());
+            bottom = std::max(bottom, bbox.bottom());
+        }
+        if (left >= right || top >= bottom) return false;
+
+        mBitmap = VBitmap(size_t(right - left), size_t(bottom - top),
+                          VBitmap::Format::ARGB32_Premultiplied);
+        mBitmap.fill(0);
+        mBitmapPos = VPoint(left, top);
+
+        VPainter bitmapPainter;
+        bitmapPainter.begin(&mBitmap);
+        for (auto drawable : drawables) {
+            VRle rle = drawable->rle();
+            rle.translate(VPoint(-left, -top));
+            bitmapPainter.setBrush(drawable->mBrush);
+            bitmapPainter.drawRle(VPoint(), rle);
+        }
+        bitmapPainter.end();
+    }
+    painter->drawBitmap(mBitmapPos, mBitmap);
+    return true;
 }
 
 renderer::DrawableList renderer::ShapeLayer::renderList()
@@ -854,7 +2070,7 @@ renderer::DrawableList renderer::ShapeLayer::renderList()
 }
 
 bool renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                     LOTVariant &value)
+                                     KeyPathIndex::ObjectList &result)
 {
     if (!keyPath.skip(name())) {
         if (!keyPath.matches(mModel.name(), depth)) {
@@ -862,9 +2078,8 @@ bool renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
         }
 
         if (!keyPath.skip(mModel.name())) {
-            if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-                transformProp(value.property())) {
-                mModel.filter()->addValue(value);
+            if (keyPath.fullyResolvesTo(mModel.name(), depth)) {
+                result.push_back(this);
             }
         }
     }
@@ -872,63 +2087,115 @@ bool renderer::Group::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
     if (keyPath.propagate(name(), depth)) {
         uint newDepth = keyPath.nextDepth(name(), depth);
         for (auto &child : mContents) {
-            child->resolveKeyPath(keyPath, newDepth, value);
+            child->resolveKeyPath(keyPath, newDepth, result);
         }
     }
     return true;
 }
 
+void renderer::Group::buildKeyPathIndex(KeyPathIndex &index)
+{
+    bool pushed = index.push(name());
+    if (pushed) index.add(this);
+    for (auto &child : mContents) {
+        child->buildKeyPathIndex(index);
+    }
+    if (pushed) index.pop();
+}
+
+void renderer::Group::setValue(const model::SharedFilterValue &value)
+{
+    if (transformProp(value->property())) mModel.filter()->addValue(value);
+}
+
+void renderer::Group::applyColorVariant(const model::ColorVariant &variant)
+{
+    for (auto &child : mContents) {
+        child->applyColorVariant(variant);
+    }
+}
+
 bool renderer::Fill::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                    LOTVariant &value)
+                                    KeyPathIndex::ObjectList &result)
 {
     if (!keyPath.matches(mModel.name(), depth)) {
         return false;
     }
 
-    if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        fillProp(value.property())) {
-        mModel.filter()->addValue(value);
+    if (keyPath.fullyResolvesTo(mModel.name(), depth)) {
+        result.push_back(this);
         return true;
     }
     return false;
 }
 
+void renderer::Fill::buildKeyPathIndex(KeyPathIndex &index)
+{
+    index.add(mModel.name(), this);
+}
+
+void renderer::Fill::setValue(const model::SharedFilterValue &value)
+{
+    if (fillProp(value->property())) mModel.filter()->addValue(value);
+}
+
+void renderer::Fill::applyColorVariant(const model::ColorVariant &variant)
+{
+    mModel.setColor(variant.color(&mModel.model()->mColor));
+}
+
 bool renderer::Stroke::resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                      LOTVariant &value)
+                                      KeyPathIndex::ObjectList &result)
 {
     if (!keyPath.matches(mModel.name(), depth)) {
         return false;
     }
 
-    if (keyPath.fullyResolvesTo(mModel.name(), depth) &&
-        strokeProp(value.property())) {
-        mModel.filter()->addValue(value);
+    if (keyPath.fullyResolvesTo(mModel.name(), depth)) {
+        result.push_back(this);
         return true;
     }
     return false;
 }
 
-renderer::Group::Group(model::Group *data, VArenaAlloc *allocator)
-    : mModel(data)
+void renderer::Stroke::buildKeyPathIndex(KeyPathIndex &index)
+{
+    index.add(mModel.name(), this);
+}
+
+void renderer::Stroke::setValue(const model::SharedFilterValue &value)
+{
+    if (strokeProp(value->property())) mModel.filter()->addValue(value);
+}
+
+void renderer::Stroke::applyColorVariant(const model::ColorVariant &variant)
+{
+    mModel.setColor(variant.color(&mModel.model()->mColor));
+}
+
+renderer::Group::Group(model::Group *data, BuildContext &ctx) : mModel(data)
 {
-    addChildren(data, allocator);
+    addChildren(data, ctx);
 }
 
-void renderer::Group::addChildren(model::Group *data, VArenaAlloc *allocator)
+void renderer::Group::addChildren(model::Group *data, BuildContext &ctx)
 {
-    if (!data) return;
+    if (!data || data->mChildren.empty()) return;
 
-    if (!data->mChildren.empty()) mContents.reserve(data->mChildren.size());
+    auto   contents = ctx.mAllocator->makeArrayDefault<renderer::Object *>(
+        data->mChildren.size());
+    size_t count = 0;
 
     // keep the content in back-to-front order.
     // as lottie model keeps it in front-to-back order.
     for (auto it = data->mChildren.crbegin(); it != data->mChildren.rend();
          ++it) {
-        auto content = createContentItem(*it, allocator);
+        auto content = createContentItem(*it, ctx);
         if (content) {
-            mContents.push_back(content);
+            contents[count++] = content;
         }
     }
+    mContents = {contents, count};
 }
 
 void renderer::Group::update(int frameNo, const VMatrix &parentMatrix,
@@ -988,7 +2255,19 @@ void renderer::Group::renderList(std::vector<VDrawable *> &list)
     }
 }
 
-void renderer::Group::processPaintItems(std::vector<renderer::Shape *> &list)
+void renderer::Group::paintList(std::vector<renderer::Paint *> &list)
+{
+    for (const auto &content : mContents) {
+        if (content->type() == renderer::Object::Type::Paint) {
+            list.push_back(static_cast<renderer::Paint *>(content));
+        } else if (content->type() == renderer::Object::Type::Group) {
+            static_cast<renderer::Group *>(content)->paintList(list);
+        }
+    }
+}
+
+void renderer::Group::processPaintItems(std::vector<renderer::Shape *> &list,
+                                        VArenaAlloc *allocator)
 {
     size_t curOpCount = list.size();
     for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
@@ -1001,12 +2280,13 @@ void renderer::Group::processPaintItems(std::vector<renderer::Shape *> &list)
             break;
         }
         case renderer::Object::Type::Paint: {
-            static_cast<renderer::Paint *>(content)->addPathItems(list,
-                                                                  curOpCount);
+            static_cast<renderer::Paint *>(content)->addPathItems(
+                list, curOpCount, allocator);
             break;
         }
         case renderer::Object::Type::Group: {
-            static_cast<renderer::Group *>(content)->processPaintItems(list);
+            static_cast<renderer::Group *>(content)->processPaintItems(
+                list, allocator);
             break;
         }
         default:
@@ -1015,7 +2295,8 @@ void renderer::Group::processPaintItems(std::vector<renderer::Shape *> &list)
     }
 }
 
-void renderer::Group::processTrimItems(std::vector<renderer::Shape *> &list)
+void renderer::Group::processTrimItems(std::vector<renderer::Shape *> &list,
+                                       VArenaAlloc *allocator)
 {
     size_t curOpCount = list.size();
     for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
@@ -1027,12 +2308,13 @@ void renderer::Group::processTrimItems(std::vector<renderer::Shape *> &list)
             break;
         }
         case renderer::Object::Type::Trim: {
-            static_cast<renderer::Trim *>(content)->addPathItems(list,
-                                                                 curOpCount);
+            static_cast<renderer::Trim *>(content)->addPathItems(
+                list, curOpCount, allocator);
             break;
         }
         case renderer::Object::Type::Group: {
-            static_cast<renderer::Group *>(content)->processTrimItems(list);
+            static_cast<renderer::Group *>(content)->processTrimItems(
+                list, allocator);
             break;
         }
         default:
@@ -1069,7 +2351,9 @@ void renderer::Shape::update(int              frameNo, const VMatrix &, float,
         // from the last frame update.
         mTemp = VPath();
 
-        updatePath(mLocalPath, frameNo);
+        // a static path may already be shared from the prototype.
+        if (!mStaticPath || mLocalPath.empty())
+            updatePath(mLocalPath, frameNo);
         mDirtyPath = true;
     }
     // 2. keep a reference path in temp in case there is some
@@ -1173,6 +2457,7 @@ void renderer::Paint::update(int frameNo, const VMatrix &parentMatrix,
 {
     mRenderNodeUpdate = true;
     mContentToRender = updateContent(frameNo, parentMatrix, parentAlpha);
+    mDrawable.shareRaster(nullptr, VPoint());
 }
 
 void renderer::Paint::updateRenderNode()
@@ -1215,11 +2500,43 @@ void renderer::Paint::renderList(std::vector<VDrawable *> &list)
     if (mContentToRender) list.push_back(&mDrawable);
 }
 
+void renderer::Paint::shareRaster(renderer::Paint *source,
+                                  const VPoint &   offset)
+{
+    // nothing to rasterize this frame.
+    if (!(mDrawable.mFlag & VDrawable::DirtyState::Path)) return;
+
+    if (mDrawable.mType != source->mDrawable.mType) return;
+    if (mDrawable.mStrokeInfo &&
+        !vCompare(mDrawable.mStrokeInfo->width,
+                  source->mDrawable.mStrokeInfo->width))
+        return;
+
+    const auto &points = mPath.points();
+    const auto &srcPoints = source->mPath.points();
+    if (points.size() != srcPoints.size() ||
+        mPath.elements() != source->mPath.elements())
+        return;
+
+    for (size_t i = 0; i < points.size(); i++) {
+        if (std::fabs(points[i].x() - srcPoints[i].x() - offset.x()) >
+                1.0f / 256 ||
+            std::fabs(points[i].y() - srcPoints[i].y() - offset.y()) >
+                1.0f / 256)
+            return;
+    }
+
+    mDrawable.shareRaster(&source->mDrawable, offset);
+}
+
 void renderer::Paint::addPathItems(std::vector<renderer::Shape *> &list,
-                                   size_t                          startOffset)
+                                   size_t startOffset, VArenaAlloc *allocator)
 {
-    std::copy(list.begin() + startOffset, list.end(),
-              back_inserter(mPathItems));
+    assert(mPathItems.empty());
+    size_t count = list.size() - startOffset;
+    auto   items = allocator->makeArrayDefault<renderer::Shape *>(count);
+    std::copy(list.begin() + startOffset, list.end(), items);
+    mPathItems = {items, count};
 }
 
 renderer::Fill::Fill(model::Fill *data)
@@ -1417,25 +2734,43 @@ void renderer::Trim::update()
 }
 
 void renderer::Trim::addPathItems(std::vector<renderer::Shape *> &list,
-                                  size_t                          startOffset)
+                                  size_t startOffset, VArenaAlloc *allocator)
 {
-    std::copy(list.begin() + startOffset, list.end(),
-              back_inserter(mPathItems));
+    assert(mPathItems.empty());
+    size_t count = list.size() - startOffset;
+    auto   items = allocator->makeArrayDefault<renderer::Shape *>(count);
+    std::copy(list.begin() + startOffset, list.end(), items);
+    mPathItems = {items, count};
 }
 
-renderer::Repeater::Repeater(model::Repeater *data, VArenaAlloc *allocator)
+renderer::Repeater::Repeater(model::Repeater *data, BuildContext &ctx)
     : mRepeaterData(data)
 {
     assert(mRepeaterData->content());
 
     mCopies = mRepeaterData->maxCopies();
+    if (mCopies <= 0) return;
 
+    auto contents =
+        ctx.mAllocator->makeArrayDefault<renderer::Object *>(mCopies);
     for (int i = 0; i < mCopies; i++) {
-        auto content = allocator->make<renderer::Group>(
-            mRepeaterData->content(), allocator);
+        contents[i] = ctx.mAllocator->make<renderer::Group>(
+            mRepeaterData->content(), ctx);
         // content->setParent(this);
-        mContents.push_back(content);
     }
+    mContents = {contents, size_t(mCopies)};
+
+    std::vector<renderer::Paint *> paints;
+    for (auto content : mContents) {
+        static_cast<renderer::Group *>(content)->paintList(paints);
+    }
+    if (paints.empty()) return;
+
+    auto list = ctx.mAllocator->makeArrayDefault<renderer::Paint *>(
+        paints.size());
+    std::copy(paints.begin(), paints.end(), list);
+    mPaints = {list, paints.size()};
+    mOffsets.resize(size_t(mCopies));
 }
 
 void renderer::Repeater::update(int frameNo, const VMatrix &parentMatrix,
@@ -1461,6 +2796,7 @@ void renderer::Repeater::update(int frameNo, const VMatrix &parentMatrix,
 
     newFlag |= DirtyFlagBit::Alpha;
 
+    VMatrix first;
     for (int i = 0; i < mCopies; ++i) {
         float newAlpha =
             parentAlpha * lerp(startOpacity, endOpacity, i / copies);
@@ -1471,11 +2807,39 @@ void renderer::Repeater::update(int frameNo, const VMatrix &parentMatrix,
         VMatrix result = mRepeaterData->mTransform.matrix(frameNo, i + offset) *
                          parentMatrix;
         mContents[i]->update(frameNo, result, newAlpha, newFlag);
+
+        if (mPaints.empty()) continue;
+        if (i == 0) {
+            first = result;
+        } else {
+            auto &copy = mOffsets[size_t(i)];
+            copy.first = i < visibleCopies &&
+                         pixelOffset(first, result, copy.second);
+        }
     }
 }
 
 void renderer::Repeater::renderList(std::vector<VDrawable *> &list)
 {
     if (mHidden) return;
-    return renderer::Group::renderList(list);
+    renderer::Group::renderList(list);
+    shareRasters();
+}
+
+/*
+ * Copies that only move by whole pixels reuse the raster of the first copy
+ * instead of rasterizing the same shapes again.
+ */
+void renderer::Repeater::shareRasters()
+{
+    if (mPaints.empty()) return;
+
+    size_t count = mPaints.size() / size_t(mCopies);
+    for (size_t i = 1; i < size_t(mCopies); i++) {
+        if (!mOffsets[i].first) continue;
+        for (size_t j = 0; j < count; j++) {
+            mPaints[i * count + j]->shareRaster(mPaints[j],
+                                                mOffsets[i].second);
+        }
+    }
 }
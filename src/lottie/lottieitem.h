@@ -23,8 +23,12 @@
 #ifndef LOTTIEITEM_H
 #define LOTTIEITEM_H
 
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 #include "lottiekeypath.h"
 #include "lottiefiltermodel.h"
@@ -55,6 +59,7 @@ public:
 
     using iterator = pointer;
     using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
 
     VSpan() = default;
     VSpan(pointer data, index_type size) : _data(data), _size(size) {}
@@ -66,6 +71,8 @@ public:
     constexpr iterator       end() const noexcept { return data() + size(); }
     constexpr const_iterator cbegin() const noexcept { return data(); }
     constexpr const_iterator cend() const noexcept { return data() + size(); }
+    reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
     constexpr reference      operator[](index_type idx) const
     {
         return *(data() + idx);
@@ -88,27 +95,20 @@ enum class DirtyFlagBit : uchar {
 };
 typedef vFlag<DirtyFlagBit> DirtyFlag;
 
+/*
+ * Offscreen buffers of a render pass. They are taken from and given back
+ * to a pool that is shared by all the instances and bounded by a byte
+ * budget, see configureSurfaceCacheSize().
+ */
 class SurfaceCache {
 public:
-    SurfaceCache() { mCache.reserve(10); }
-
     VBitmap make_surface(
         size_t width, size_t height,
-        VBitmap::Format format = VBitmap::Format::ARGB32_Premultiplied)
-    {
-        if (mCache.empty()) return {width, height, format};
-
-        auto surface = mCache.back();
-        surface.reset(width, height, format);
+        VBitmap::Format format = VBitmap::Format::ARGB32_Premultiplied);
+    void release_surface(VBitmap &surface);
 
-        mCache.pop_back();
-        return surface;
-    }
-
-    void release_surface(VBitmap &surface) { mCache.push_back(surface); }
-
-private:
-    std::vector<VBitmap> mCache;
+    static void                       configure(size_t budget);
+    static rlottie::SurfaceCacheStats stats();
 };
 
 class Drawable final : public VDrawable {
@@ -133,12 +133,52 @@ struct CApiData {
     std::vector<LOTNode *>      mCNodeList;
 };
 
+class Prototype;
+class CompLayer;
+
+/*
+ * Precomp layers build their children on first activation. This keeps
+ * track of the built ones so that the content of a precomp that went
+ * off screen can be released again, and holds the settings the instance
+ * was created with for the layers built later.
+ */
+struct LazyBuild {
+    const model::ColorVariant *mColorVariant{nullptr};
+    std::vector<CompLayer *>   mBuilt;  // in build order
+    uint                       mTick{0};
+    bool                       mPinned{false};  // nodes are referenced
+    rlottie::LayerCache        mLayerCache{rlottie::LayerCache::None};
+    rlottie::ImageQuality      mImageQuality{rlottie::ImageQuality::Nearest};
+    void                       releaseInactive(size_t delay);
+};
+
+/*
+ * What the construction of a renderer tree needs besides the model: the
+ * arena the nodes are allocated from, the prototype the instance shares
+ * its model derived data with and the lazy build state.
+ */
+struct BuildContext {
+    VArenaAlloc *mAllocator{nullptr};
+    Prototype *  mPrototype{nullptr};
+    LazyBuild *  mLazy{nullptr};
+};
+
+// number of rendered frames a precomp content is kept while not visible,
+// 0 keeps it for the lifetime of the instance.
+void configurePrecompReleaseDelay(size_t frameCount);
+
+// raster cache policy of the instances created afterwards.
+void configureLayerCache(rlottie::LayerCache policy);
+
+// sampling of the image layers of the instances created afterwards.
+void configureImageQuality(rlottie::ImageQuality quality);
+
 class Clipper {
 public:
     explicit Clipper(VSize size) : mSize(size) {}
     void update(const VMatrix &matrix);
     void preprocess(const VRect &clip);
-    VRle rle(const VRle &mask);
+    VRle rle(const VRle &mask, const VRect &clip = {});
 
 public:
     VSize       mSize;
@@ -181,32 +221,86 @@ public:
 public:
     std::vector<Mask> mMasks;
     VRle              mRle;
+    VRect             mClip;  // the inverted masks are bound to it
     bool              mStatic{true};
     bool              mDirty{true};
 };
 
 class Layer;
+class Object;
+
+/*
+ * Lazily built lookup table used by Composition::setValue().
+ * Every object that can take a property override is recorded under its
+ * literal keypath with the object names interned to ids, so a keypath
+ * without globs resolves with a single hash lookup. Keypaths with globs are
+ * resolved by walking the tree once and the result is kept for reuse.
+ */
+class KeyPathIndex {
+public:
+    using ObjectList = std::vector<Object *>;
+
+    const ObjectList &resolve(const std::string &keypath, Layer *root);
+
+    // used while building the index. push() ignores the placeholder
+    // objects we create programatically as they are not part of a keypath.
+    bool push(const char *name)
+    {
+        if (!strcmp(name, "__")) return false;
+        mPath.push_back(intern(name));
+        return true;
+    }
+    void pop() { mPath.pop_back(); }
+    void add(Object *obj) { mLiterals[mPath].push_back(obj); }
+    void add(const char *name, Object *obj);
+
+private:
+    struct PathHash {
+        size_t operator()(const std::vector<uint> &path) const
+        {
+            size_t hash = path.size();
+            for (auto id : path) hash = hash * 31 + id;
+            return hash;
+        }
+    };
+    uint intern(const char *name);
+
+private:
+    std::unordered_map<std::string, uint>                     mNames;
+    std::unordered_map<std::vector<uint>, ObjectList, PathHash> mLiterals;
+    std::unordered_map<std::string, ObjectList>               mGlobs;
+    std::vector<uint>                                         mPath;
+    std::vector<uint>                                         mLookup;
+    const ObjectList                                          mEmpty;
+};
 
 class Composition {
 public:
     explicit Composition(std::shared_ptr<model::Composition> composition);
+    explicit Composition(std::shared_ptr<model::ColorVariant> variant);
     bool  update(int frameNo, const VSize &size, bool keepAspectRatio);
     VSize size() const { return mViewSize; }
     void  buildRenderTree();
     const LOTLayerNode *renderTree() const;
-    bool                render(const rlottie::Surface &surface);
-    void                setValue(const std::string &keypath, LOTVariant &value);
+    bool                render(const rlottie::Surface &surface,
+                               rlottie::PixelFormat      format);
+    bool                render(const rlottie::YuvFrame &frame);
+    void                setValue(const std::string &keypath, LOTVariant &&value);
 
 private:
-    SurfaceCache                        mSurfaceCache;
-    VBitmap                             mSurface;
-    VMatrix                             mScaleMatrix;
-    VSize                               mViewSize;
-    std::shared_ptr<model::Composition> mModel;
-    Layer *                             mRootLayer{nullptr};
-    VArenaAlloc                         mAllocator{2048};
-    int                                 mCurFrameNo;
-    bool                                mKeepAspectRatio{true};
+    SurfaceCache                         mSurfaceCache;
+    VBitmap                              mSurface;
+    VMatrix                              mScaleMatrix;
+    VSize                                mViewSize;
+    std::shared_ptr<model::Composition>  mModel;
+    Prototype *                          mPrototype{nullptr};
+    std::shared_ptr<model::ColorVariant> mColorVariant;
+    Layer *                              mRootLayer{nullptr};
+    std::unique_ptr<KeyPathIndex>        mKeyPathIndex;
+    LazyBuild                            mLazy;
+    VArenaAlloc                          mAllocator;
+    int                                  mCurFrameNo;
+    bool                                 mKeepAspectRatio{true};
 };
 
 class Layer {
@@ -216,6 +310,9 @@ public:
     Layer(model::Layer *layerData);
     int          id() const { return mLayerData->id(); }
     int          parentId() const { return mLayerData->parentId(); }
+    int          inFrame() const { return mLayerData->inFrame(); }
+    int          outFrame() const { return mLayerData->outFrame(); }
+    bool         precompLayer() const { return mLayerData->precompLayer(); }
     void         setParentLayer(Layer *parent) { mParentLayer = parent; }
     void         setComplexContent(bool value) { mComplexContent = value; }
     bool         complexContent() const { return mComplexContent; }
@@ -232,7 +329,22 @@ public:
         return true;
     }
     model::MatteType matteType() const { return mLayerData->mMatteType; }
-    bool             visible() const;
+    bool             hasMask() const { return bool(mLayerMask); }
+    // the content is drawn straight from the render list.
+    bool shapeContent() const
+    {
+        return mLayerData->mLayerType == model::Layer::Type::Shape ||
+               mLayerData->mLayerType == model::Layer::Type::Solid;
+    }
+    // the part of clip the layer draws into.
+    virtual VRect bounds(const VRect &clip);
+    // the pixels in area the layer paints over, whatever lies below.
+    virtual VRle  opaqueArea(const VRect &area);
+    bool          visible() const;
+    bool          skipRendering() const
+    {
+        return (!visible() || vIsZero(combinedAlpha()));
+    }
     virtual void     buildLayerNode();
     LOTLayerNode &   clayer() { return mCApiData->mLayer; }
     std::vector<LOTLayerNode *> &clayers() { return mCApiData->mLayers; }
@@ -240,7 +352,9 @@ public:
     std::vector<LOTNode *> &     cnodes() { return mCApiData->mCNodeList; }
     const char *                 name() const { return mLayerData->name(); }
     virtual bool                 resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                                LOTVariant &value);
+                                                KeyPathIndex::ObjectList &result);
+    virtual void                 buildKeyPathIndex(KeyPathIndex &index);
+    virtual void applyColorVariant(const model::ColorVariant &) {}
 
 protected:
     virtual void   preprocessStage(const VRect &clip) = 0;
@@ -251,10 +365,6 @@ protected:
     inline bool    isStatic() const { return mLayerData->isStatic(); }
     float opacity(int frameNo) const { return mLayerData->opacity(frameNo); }
     inline DirtyFlag flag() const { return mDirtyFlag; }
-    bool             skipRendering() const
-    {
-        return (!visible() || vIsZero(combinedAlpha()));
-    }
 
 protected:
     std::unique_ptr<LayerMask> mLayerMask;
@@ -268,15 +378,79 @@ protected:
     std::unique_ptr<CApiData>  mCApiData;
 };
 
-class CompLayer final : public Layer {
+/*
+ * Keeps the child layers of a precomp bucketed by their [inFrame, outFrame)
+ * range. The timeline is split at every in/out point into segments and each
+ * segment stores the indices (in back-to-front order) of the layers alive in
+ * it, so a frame only visits the layers that contribute to it.
+ */
+class ActiveLayerIndex {
 public:
-    explicit CompLayer(model::Layer *layerData, VArenaAlloc *allocator);
+    static constexpr int InvalidSegment = -2;
 
-    void render(VPainter *painter, const VRle &mask, const VRle &matteRle,
-                SurfaceCache &cache) final;
-    void buildLayerNode() final;
-    bool resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                        LOTVariant &value) override;
+    void              build(const std::vector<Layer *> &layers);
+    int               segment(int frameNo) const;
+    VSpan<const uint> layers(int segment) const
+    {
+        if (segment < 0) return {};
+        return {mIndices.data() + mOffsets[segment],
+                mOffsets[segment + 1] - mOffsets[segment]};
+    }
+
+private:
+    std::vector<int>  mBounds;   // sorted unique in/out points
+    std::vector<uint> mOffsets;  // segment start offsets into mIndices
+    std::vector<uint> mIndices;
+};
+
+enum class MatteRole : uchar { None, Target, Source, Unused };
+
+class Shape;
+
+/*
+ * Renderer data that depends only on the model. All the instances created
+ * from one model share a single prototype owned by that model. The first
+ * instance that needs an entry derives it and the others reuse it. Entries
+ * are never modified once added.
+ */
+class Prototype {
+public:
+    struct CompLayout {
+        std::vector<int>       mParents;  // index of the parent layer or -1
+        std::vector<MatteRole> mMatteRoles;
+        ActiveLayerIndex       mActiveIndex;
+    };
+    static Prototype *shared(model::Composition *model);
+    const CompLayout &layout(const model::Layer *        layerData,
+                             const std::vector<Layer *> &layers);
+    void              shareStaticPath(const model::Object *data, Shape *shape);
+    // arena size that holds the content of a precomp layer, so the
+    // next instances build it into a single block.
+    size_t arenaSize(const model::Layer *layerData);
+    void   recordArenaSize(const model::Layer *layerData, size_t size);
+
+private:
+    std::mutex                                           mMutex;
+    std::unordered_map<const model::Layer *, CompLayout> mLayouts;
+    std::unordered_map<const model::Object *, VPath>     mPaths;
+    std::unordered_map<const model::Layer *, size_t>     mArenaSizes;
+};
+
+class CompLayer final : public Layer {
+public:
+    explicit CompLayer(model::Layer *layerData, BuildContext &ctx);
+
+    void  render(VPainter *painter, const VRle &mask, const VRle &matteRle,
+                 SurfaceCache &cache) final;
+    VRect bounds(const VRect &clip) final;
+    void  buildLayerNode() final;
+    bool  resolveKeyPath(LOTKeyPath &keyPath, uint depth,
+                         KeyPathIndex::ObjectList &result) override;
+    void  buildKeyPathIndex(KeyPathIndex &index) override;
+    void  applyColorVariant(const model::ColorVariant &variant) override;
+    void  buildLayers();
+    void  releaseLayers();
+    uint  lastActive() const { return mLastActive; }
 
 protected:
     void preprocessStage(const VRect &clip) final;
@@ -288,10 +462,50 @@ private:
     void renderMatteLayer(VPainter *painter, const VRle &inheritMask,
                           const VRle &matteRle, Layer *layer, Layer *src,
                           SurfaceCache &cache);
+    bool renderRleMatte(VPainter *painter, const VRle &mask, Layer *layer,
+                        Layer *src, SurfaceCache &cache);
+    void cullOccluded(VSpan<const uint> layers, const VRect &clip,
+                      const VRle &mask);
+    bool sharesPixels(Layer *layer) const;
+    void updateLayer(uint index, int frameNo, float alpha);
+    bool sameContent(const CompLayer *other) const;
+    bool followLeader();
+    void detachInstance();
+    void renderInstance(VPainter *painter, const VRle &mask,
+                        const VPoint &offset);
+
+private:
+    VSpan<const uint> activeLayers() const
+    {
+        if (!mLayout) return {};
+        return mLayout->mActiveIndex.layers(mActiveSegment);
+    }
 
 private:
-    std::vector<Layer *>     mLayers;
-    std::unique_ptr<Clipper> mClipper;
+    std::vector<Layer *>         mLayers;
+    const Prototype::CompLayout *mLayout{nullptr};
+    int                          mActiveSegment{ActiveLayerIndex::InvalidSegment};
+    std::unique_ptr<Clipper>     mClipper;
+    std::unique_ptr<VArenaAlloc> mArena;  // owns the children
+    Prototype *                  mPrototype{nullptr};
+    LazyBuild *                  mLazy{nullptr};
+    uint                         mLastActive{0};
+    CompLayer *                  mLeader{nullptr};  // renders this placement
+    std::vector<CompLayer *>     mLeaders;  // among the child placements
+    VBitmap                      mInstanceBitmap;
+    VPoint                       mInstanceOrigin;  // of the bitmap
+    VPoint                       mInstanceOffset;
+    bool                         mInstancing{false};
+    bool                         mInstanced{false};  // has followers
+    // what the opaque layers above leave of each active layer.
+    enum class Visibility : uchar { Full, Clipped, Hidden };
+    struct Occlusion {
+        VRect      mBounds;
+        VRect      mBelow;  // covers the layers underneath
+        VRle       mUncovered;
+        Visibility mVisibility{Visibility::Full};
+    };
+    std::vector<Occlusion> mOcclusion;
 };
 
 class SolidLayer final : public Layer {
@@ -310,21 +524,55 @@ private:
     VDrawable *mDrawableList{nullptr};  // to work with the Span api
 };
 
+/*
+ * Keeps the raster of a shape layer with static content from one frame to
+ * the next. The coverage is moved along while the layer only translates by
+ * whole pixels, and in bitmap mode the blended pixels are kept as well.
+ */
+class RasterCache {
+public:
+    explicit RasterCache(bool keepBitmap) : mKeepBitmap(keepBitmap) {}
+    bool reuse(const VMatrix &matrix, const DirtyFlag &flag,
+               DrawableList drawables);
+    void rasterized(const VMatrix &matrix, const VRect &clip);
+    bool invalidate();
+    bool render(VPainter *painter, DrawableList drawables);
+    bool keepsBitmap() const { return mKeepBitmap; }
+
+private:
+    VMatrix mMatrix;  // the matrix the raster is valid for
+    VRect   mClip;
+    VBitmap mBitmap;
+    VPoint  mBitmapPos;
+    bool    mValid{false};
+    bool    mMoved{false};
+    bool    mReused{false};
+    bool    mKeepBitmap{false};
+};
+
 class Group;
 
 class ShapeLayer final : public Layer {
 public:
-    explicit ShapeLayer(model::Layer *layerData, VArenaAlloc *allocator);
+    explicit ShapeLayer(model::Layer *layerData, BuildContext &ctx);
     DrawableList renderList() final;
     void         buildLayerNode() final;
     bool         resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                                LOTVariant &value) override;
+                                KeyPathIndex::ObjectList &result) override;
+    void         buildKeyPathIndex(KeyPathIndex &index) override;
+    void         applyColorVariant(
+                const model::ColorVariant &variant) override;
+    void         render(VPainter *painter, const VRle &mask,
+                        const VRle &matteRle, SurfaceCache &cache) final;
+    VRle         opaqueArea(const VRect &area) final;
 
 protected:
-    void                     preprocessStage(const VRect &clip) final;
-    void                     updateContent() final;
-    std::vector<VDrawable *> mDrawableList;
-    Group *                  mRoot{nullptr};
+    void                         preprocessStage(const VRect &clip) final;
+    void                         updateContent() final;
+    void                         dropRasterCache();
+    std::vector<VDrawable *>     mDrawableList;
+    Group *                      mRoot{nullptr};
+    std::unique_ptr<RasterCache> mRasterCache;
 };
 
 class NullLayer final : public Layer {
@@ -338,7 +586,7 @@ protected:
 
 class ImageLayer final : public Layer {
 public:
-    explicit ImageLayer(model::Layer *layerData);
+    explicit ImageLayer(model::Layer *layerData, BuildContext &ctx);
     void         buildLayerNode() final;
     DrawableList renderList() final;
 
@@ -361,25 +609,31 @@ public:
     virtual void update(int frameNo, const VMatrix &parentMatrix,
                         float parentAlpha, const DirtyFlag &flag) = 0;
     virtual void renderList(std::vector<VDrawable *> &) {}
-    virtual bool resolveKeyPath(LOTKeyPath &, uint, LOTVariant &)
+    virtual bool resolveKeyPath(LOTKeyPath &, uint, KeyPathIndex::ObjectList &)
     {
         return false;
     }
+    virtual void buildKeyPathIndex(KeyPathIndex &) {}
+    virtual void setValue(const model::SharedFilterValue &) {}
+    virtual void applyColorVariant(const model::ColorVariant &) {}
     virtual Object::Type type() const { return Object::Type::Unknown; }
 };
 
 class Shape;
+class Paint;
+
 class Group : public Object {
 public:
     Group() = default;
-    explicit Group(model::Group *data, VArenaAlloc *allocator);
-    void addChildren(model::Group *data, VArenaAlloc *allocator);
+    explicit Group(model::Group *data, BuildContext &ctx);
+    void addChildren(model::Group *data, BuildContext &ctx);
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha,
                 const DirtyFlag &flag) override;
     void applyTrim();
-    void processTrimItems(std::vector<Shape *> &list);
-    void processPaintItems(std::vector<Shape *> &list);
+    void processTrimItems(std::vector<Shape *> &list, VArenaAlloc *allocator);
+    void processPaintItems(std::vector<Shape *> &list, VArenaAlloc *allocator);
     void renderList(std::vector<VDrawable *> &list) override;
+    void paintList(std::vector<Paint *> &list);
     Object::Type   type() const final { return Object::Type::Group; }
     const VMatrix &matrix() const { return mMatrix; }
     const char *   name() const
@@ -388,11 +642,14 @@ public:
         return mModel.hasModel() ? mModel.name() : TAG;
     }
     bool resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                        LOTVariant &value) override;
+                        KeyPathIndex::ObjectList &result) override;
+    void buildKeyPathIndex(KeyPathIndex &index) override;
+    void setValue(const model::SharedFilterValue &value) override;
+    void applyColorVariant(const model::ColorVariant &variant) override;
 
 protected:
-    std::vector<Object *> mContents;
-    VMatrix               mMatrix;
+    VSpan<Object *> mContents;
+    VMatrix         mMatrix;
 
 private:
     model::Filter<model::Group> mModel;
@@ -417,6 +674,7 @@ public:
     Group *parent() const { return mParent; }
 
 protected:
+    friend class Prototype;
     virtual void updatePath(VPath &path, int frameNo) = 0;
     virtual bool hasChanged(int prevFrame, int curFrame) = 0;
 
@@ -503,10 +761,12 @@ private:
 class Paint : public Object {
 public:
     Paint(bool staticContent);
-    void addPathItems(std::vector<Shape *> &list, size_t startOffset);
+    void addPathItems(std::vector<Shape *> &list, size_t startOffset,
+                      VArenaAlloc *allocator);
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha,
                 const DirtyFlag &flag) override;
     void renderList(std::vector<VDrawable *> &list) final;
+    void shareRaster(Paint *source, const VPoint &offset);
     Object::Type type() const final { return Object::Type::Paint; }
 
 protected:
@@ -517,13 +777,13 @@ private:
     void updateRenderNode();
 
 protected:
-    std::vector<Shape *> mPathItems;
-    Drawable             mDrawable;
-    VPath                mPath;
-    DirtyFlag            mFlag;
-    bool                 mStaticContent;
-    bool                 mRenderNodeUpdate{true};
-    bool                 mContentToRender{true};
+    VSpan<Shape *> mPathItems;
+    Drawable       mDrawable;
+    VPath          mPath;
+    DirtyFlag      mFlag;
+    bool           mStaticContent;
+    bool           mRenderNodeUpdate{true};
+    bool           mContentToRender{true};
 };
 
 class Fill final : public Paint {
@@ -533,7 +793,10 @@ public:
 protected:
     bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
     bool resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                        LOTVariant &value) final;
+                        KeyPathIndex::ObjectList &result) final;
+    void buildKeyPathIndex(KeyPathIndex &index) final;
+    void setValue(const model::SharedFilterValue &value) final;
+    void applyColorVariant(const model::ColorVariant &variant) final;
 
 private:
     model::Filter<model::Fill> mModel;
@@ -558,7 +821,10 @@ public:
 protected:
     bool updateContent(int frameNo, const VMatrix &matrix, float alpha) final;
     bool resolveKeyPath(LOTKeyPath &keyPath, uint depth,
-                        LOTVariant &value) final;
+                        KeyPathIndex::ObjectList &result) final;
+    void buildKeyPathIndex(KeyPathIndex &index) final;
+    void setValue(const model::SharedFilterValue &value) final;
+    void applyColorVariant(const model::ColorVariant &variant) final;
 
 private:
     model::Filter<model::Stroke> mModel;
@@ -583,7 +849,8 @@ public:
                 const DirtyFlag &flag) final;
     Object::Type type() const final { return Object::Type::Trim; }
     void         update();
-    void         addPathItems(std::vector<Shape *> &list, size_t startOffset);
+    void         addPathItems(std::vector<Shape *> &list, size_t startOffset,
+                              VArenaAlloc *allocator);
 
 private:
     bool pathDirty() const
@@ -597,24 +864,29 @@ private:
         int                  mFrameNo{-1};
         model::Trim::Segment mSegment{};
     };
-    Cache                mCache;
-    std::vector<Shape *> mPathItems;
-    model::Trim *        mData{nullptr};
-    VPathMesure          mPathMesure;
-    bool                 mDirty{true};
+    Cache          mCache;
+    VSpan<Shape *> mPathItems;
+    model::Trim *  mData{nullptr};
+    VPathMesure    mPathMesure;
+    bool           mDirty{true};
 };
 
 class Repeater final : public Group {
 public:
-    explicit Repeater(model::Repeater *data, VArenaAlloc *allocator);
+    explicit Repeater(model::Repeater *data, BuildContext &ctx);
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha,
                 const DirtyFlag &flag) final;
     void renderList(std::vector<VDrawable *> &list) final;
 
 private:
-    model::Repeater *mRepeaterData{nullptr};
-    bool             mHidden{false};
-    int              mCopies{0};
+    void shareRasters();
+
+    model::Repeater *                    mRepeaterData{nullptr};
+    VSpan<Paint *>                       mPaints;
+    // whole pixel offset of each copy from the first one, if it has one.
+    std::vector<std::pair<bool, VPoint>> mOffsets;
+    bool                                 mHidden{false};
+    int                                  mCopies{0};
 };
 
 }  // namespace renderer
@@ -41,6 +41,8 @@ const LOTLayerNode *renderer::Composition::renderTree() const
 
 void renderer::CompLayer::buildLayerNode()
 {
+    if (mLeader) detachInstance();
+    buildLayers();
     renderer::Layer::buildLayerNode();
     if (mClipper) {
         const auto &elm = mClipper->mPath.elements();
@@ -68,6 +70,14 @@ void renderer::CompLayer::buildLayerNode()
 
 void renderer::ShapeLayer::buildLayerNode()
 {
+    // the c api exposes the paths, bring them to the current position.
+    if (mRasterCache) {
+        dropRasterCache();
+        if (flag() & DirtyFlagBit::Matrix) {
+            updateContent();
+            mDirtyFlag = DirtyFlagBit::None;
+        }
+    }
     renderer::Layer::buildLayerNode();
 
     auto renderlist = renderList();
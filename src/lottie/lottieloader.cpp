@@ -167,3 +167,16 @@ std::shared_ptr<model::Composition> model::loadFromData(
     return internal::model::parse(const_cast<char *>(jsonData.c_str()),
                                   std::move(resourcePath), std::move(filter));
 }
+
+std::shared_ptr<model::ColorVariant> model::loadFromData(
+    std::string jsonData, const std::string &key, std::string resourcePath,
+    const model::ColorFilter &filter)
+{
+    // the base model is parsed without the filter so that it can be cached
+    // and shared by every color variant of the same resource.
+    auto obj = loadFromData(std::move(jsonData), key, std::move(resourcePath),
+                            true);
+    if (!obj) return {};
+
+    return std::make_shared<model::ColorVariant>(std::move(obj), filter);
+}
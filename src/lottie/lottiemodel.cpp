@@ -373,6 +373,38 @@ void model::Asset::loadImagePath(std::string path)
     if (!path.empty()) mBitmap = VImageLoader::instance().load(path.c_str());
 }
 
+static model::Property<model::Color> recolor(
+    const model::Property<model::Color> &prop, const model::ColorFilter &filter)
+{
+    auto apply = [&filter](model::Color color) {
+        filter(color.r, color.g, color.b);
+        return color;
+    };
+
+    if (prop.isStatic()) {
+        return model::Property<model::Color>(apply(prop.value()));
+    }
+
+    model::Property<model::Color> result;
+    auto &frames = result.animation().frames_;
+    frames = prop.animation().frames_;
+    for (auto &frame : frames) {
+        frame.value_.start_ = apply(frame.value_.start_);
+        frame.value_.end_ = apply(frame.value_.end_);
+    }
+    return result;
+}
+
+model::ColorVariant::ColorVariant(std::shared_ptr<Composition> base,
+                                  const ColorFilter &          filter)
+    : mBase(std::move(base))
+{
+    mColors.reserve(mBase->mColorProperties.size());
+    for (const auto prop : mBase->mColorProperties) {
+        mColors.emplace(prop, recolor(*prop, filter));
+    }
+}
+
 std::vector<LayerInfo> model::Composition::layerInfoList() const
 {
     if (!mRootLayer || mRootLayer->mChildren.empty()) return {};
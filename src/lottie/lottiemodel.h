@@ -55,6 +55,10 @@ inline T lerp(const T &start, const T &end, float t)
     return start + t * (end - start);
 }
 
+namespace renderer {
+class Prototype;
+}  // namespace renderer
+
 namespace model {
 
 enum class MatteType : uchar { None = 0, Alpha = 1, AlphaInv, Luma, LumaInv };
@@ -565,6 +569,11 @@ public:
     std::vector<Marker> mMarkers;
     VArenaAlloc         mArenaAlloc{2048};
     Stats               mStats;
+    // every color property the parser produced, used to build
+    // recolored variants without reparsing (see ColorVariant).
+    std::vector<Property<Color> *> mColorProperties;
+    // renderer data shared by all the instances of this composition.
+    std::shared_ptr<renderer::Prototype> mPrototype;
 };
 
 class Transform : public Object {
@@ -1117,6 +1126,26 @@ inline Gradient::Data operator*(float m, const Gradient::Data &g)
 
 using ColorFilter = std::function<void(float &, float &, float &)>;
 
+/*
+ * Recolored view of a composition. Only the color properties recorded by
+ * the parser are copied and filtered, the layer tree and every other
+ * property stay shared with the base composition.
+ */
+class ColorVariant {
+public:
+    ColorVariant(std::shared_ptr<Composition> base, const ColorFilter &filter);
+    const std::shared_ptr<Composition> &composition() const { return mBase; }
+    const Property<Color> *             color(const Property<Color> *prop) const
+    {
+        auto search = mColors.find(prop);
+        return (search != mColors.end()) ? &search->second : prop;
+    }
+
+private:
+    std::shared_ptr<Composition>                                 mBase;
+    std::unordered_map<const Property<Color> *, Property<Color>> mColors;
+};
+
 void configureModelCacheSize(size_t cacheSize);
 
 std::shared_ptr<model::Composition> loadFromFile(const std::string &filePath,
@@ -1131,6 +1160,11 @@ std::shared_ptr<model::Composition> loadFromData(std::string jsonData,
                                                  std::string resourcePath,
                                                  ColorFilter filter);
 
+std::shared_ptr<model::ColorVariant> loadFromData(std::string        jsonData,
+                                                  const std::string &key,
+                                                  std::string resourcePath,
+                                                  const ColorFilter &filter);
+
 std::shared_ptr<model::Composition> parse(char *str, std::string dir_path,
                                           ColorFilter filter = {});
 
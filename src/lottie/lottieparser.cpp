@@ -1637,6 +1637,7 @@ model::Fill *LottieParserImpl::parseFillObject()
             obj->setName(GetString());
         } else if (0 == strcmp(key, "c")) {
             parseProperty(obj->mColor);
+            compRef->mColorProperties.push_back(&obj->mColor);
         } else if (0 == strcmp(key, "o")) {
             parseProperty(obj->mOpacity);
         } else if (0 == strcmp(key, "fillEnabled")) {
@@ -1723,6 +1724,7 @@ model::Stroke *LottieParserImpl::parseStrokeObject()
             obj->setName(GetString());
         } else if (0 == strcmp(key, "c")) {
             parseProperty(obj->mColor);
+            compRef->mColorProperties.push_back(&obj->mColor);
         } else if (0 == strcmp(key, "o")) {
             parseProperty(obj->mOpacity);
         } else if (0 == strcmp(key, "w")) {
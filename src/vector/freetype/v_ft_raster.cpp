@@ -70,6 +70,7 @@
 #include <limits.h>
 #include <setjmp.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #define SW_FT_UINT_MAX UINT_MAX
 #define SW_FT_INT_MAX INT_MAX
@@ -104,6 +105,9 @@ typedef ptrdiff_t SW_FT_PtrDist;
 /* to do all of its work.                                                */
 #define SW_FT_RENDER_POOL_SIZE 16384L
 
+/* The largest render pool a raster object grows to.                     */
+#define SW_FT_MAX_RENDER_POOL_SIZE (1L << 20)
+
 typedef int (*SW_FT_Outline_MoveToFunc)(const SW_FT_Vector* to, void* user);
 
 #define SW_FT_Outline_MoveTo_Func SW_FT_Outline_MoveToFunc
@@ -324,6 +328,7 @@ typedef struct gray_TWorker_ {
 
     int band_size;
     int band_shoot;
+    int band_overflow;
 
     ft_jmp_buf jump_buffer;
 
@@ -346,7 +351,8 @@ static gray_TWorker ras;
 #endif
 
 typedef struct gray_TRaster_ {
-    void* memory;
+    void* buffer;
+    long  buffer_size;
 
 } gray_TRaster, *gray_PRaster;
 
@@ -1317,6 +1323,7 @@ static int gray_convert_glyph(RAS_ARG)
             }
 
             if (bottom - top >= ras.band_size) ras.band_shoot++;
+            ras.band_overflow++;
 
             band[1].min = bottom;
             band[1].max = middle;
@@ -1332,17 +1339,36 @@ static int gray_convert_glyph(RAS_ARG)
     return 0;
 }
 
+/* A raster object keeps its render pool across the calls and doubles it */
+/* whenever an outline did not fit, so that the bands are split only     */
+/* until the pool reaches the largest outline seen.                      */
+static void gray_raster_grow(gray_PRaster raster)
+{
+    long  size = raster->buffer_size ? raster->buffer_size * 2
+                                     : SW_FT_RENDER_POOL_SIZE;
+    void* buffer;
+
+    if (size > SW_FT_MAX_RENDER_POOL_SIZE) return;
+
+    buffer = malloc((size_t)size);
+    if (!buffer) return;
+
+    free(raster->buffer);
+    raster->buffer = buffer;
+    raster->buffer_size = size;
+}
+
 static int gray_raster_render(gray_PRaster               raster,
                               const SW_FT_Raster_Params* params)
 {
-    SW_FT_UNUSED(raster);
     const SW_FT_Outline* outline = (const SW_FT_Outline*)params->source;
 
     gray_TWorker worker[1];
 
-    TCell buffer[SW_FT_RENDER_POOL_SIZE / sizeof(TCell)];
-    long  buffer_size = sizeof(buffer);
-    int   band_size = (int)(buffer_size / (long)(sizeof(TCell) * 8));
+    TCell stack_buffer[SW_FT_RENDER_POOL_SIZE / sizeof(TCell)];
+    void* buffer = stack_buffer;
+    long  buffer_size = sizeof(stack_buffer);
+    int   band_size;
 
     if (!outline) return SW_FT_THROW(Invalid_Outline);
 
@@ -1359,6 +1385,13 @@ static int gray_raster_render(gray_PRaster               raster,
     if (!(params->flags & SW_FT_RASTER_FLAG_AA))
         return SW_FT_THROW(Invalid_Mode);
 
+    if (raster && !raster->buffer) gray_raster_grow(raster);
+    if (raster && raster->buffer) {
+        buffer = raster->buffer;
+        buffer_size = raster->buffer_size;
+    }
+    band_size = (int)(buffer_size / (long)(sizeof(TCell) * 8));
+
     if (params->flags & SW_FT_RASTER_FLAG_CLIP)
         ras.clip_box = params->clip_box;
     else {
@@ -1374,6 +1407,7 @@ static int gray_raster_render(gray_PRaster               raster,
     ras.num_cells = 0;
     ras.invalid = 1;
     ras.band_size = band_size;
+    ras.band_overflow = 0;
     ras.num_gray_spans = 0;
 
     ras.render_span = (SW_FT_Raster_Span_Func)params->gray_spans;
@@ -1383,26 +1417,31 @@ static int gray_raster_render(gray_PRaster               raster,
     params->bbox_cb(ras.bound_left, ras.bound_top,
                     ras.bound_right - ras.bound_left,
                     ras.bound_bottom - ras.bound_top + 1, params->user);
+
+    if (raster && ras.band_overflow) gray_raster_grow(raster);
     return 1;
 }
 
-/**** RASTER OBJECT CREATION: In stand-alone mode, we simply use *****/
-/****                         a static object.                   *****/
+/**** RASTER OBJECT CREATION: Each object owns its render pool, a  *****/
+/****                         null raster renders with the stack. *****/
 
 static int gray_raster_new(SW_FT_Raster* araster)
 {
-    static gray_TRaster the_raster;
+    gray_PRaster raster = (gray_PRaster)calloc(1, sizeof(gray_TRaster));
 
-    *araster = (SW_FT_Raster)&the_raster;
-    SW_FT_MEM_ZERO(&the_raster, sizeof(the_raster));
+    *araster = (SW_FT_Raster)raster;
+    if (!raster) return SW_FT_THROW(Memory_Overflow);
 
     return 0;
 }
 
 static void gray_raster_done(SW_FT_Raster raster)
 {
-    /* nothing */
-    SW_FT_UNUSED(raster);
+    gray_PRaster object = (gray_PRaster)raster;
+
+    if (!object) return;
+    free(object->buffer);
+    free(object);
 }
 
 static void gray_raster_reset(SW_FT_Raster raster, char* pool_base,
@@ -0,0 +1,696 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "vraster.h"
+#include "vaccumraster.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+V_BEGIN_NAMESPACE
+
+// the subpixel precision of the gray raster.
+static constexpr int  PixelBits = 8;
+static constexpr long OnePixel = 1L << PixelBits;
+
+// the rows are summed in blocks of this many cells.
+static constexpr int Block = 16;
+
+// the rows of a band hold at most this many cells, the outline is walked
+// once per band.
+static constexpr long BandCells = 1L << 18;
+
+// spans handed to the rle at once.
+static constexpr size_t SpanBatch = 256;
+
+static inline long trunc(long x)
+{
+    return x >> PixelBits;
+}
+
+static inline long subpixels(long x)
+{
+    return x << PixelBits;
+}
+
+static inline long upscale(long x)
+{
+    return x << (PixelBits - 6);
+}
+
+// the exact division of the gray raster, by a multiplication with the
+// reciprocal of the divisor.
+static inline long reciprocal(long b)
+{
+    return long(ULONG_MAX >> PixelBits) / b;
+}
+
+static inline long udiv(long a, long r)
+{
+    using ulong = unsigned long;
+    return long((ulong(a) * ulong(r)) >> (sizeof(long) * CHAR_BIT - PixelBits));
+}
+
+static inline uchar coverageOf(int area, bool evenOdd)
+{
+    int coverage = area >> (PixelBits * 2 + 1 - 8);
+    if (coverage < 0) coverage = -coverage;
+
+    if (evenOdd) {
+        coverage &= 511;
+        if (coverage > 256)
+            coverage = 512 - coverage;
+        else if (coverage == 256)
+            coverage = 255;
+    } else if (coverage >= 256) {
+        coverage = 255;
+    }
+    return uchar(coverage);
+}
+
+// running sum over the cells of a row starting at area, writes the coverage
+// of each cell and clears it. returns the sum at the end.
+#if defined(__SSE2__)
+static int accumulate(int *cells, int count, uchar *coverage, int area,
+                      bool evenOdd)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wrap = _mm_set1_epi32(511);
+    const __m128i period = _mm_set1_epi16(512);
+    __m128i       carry = _mm_set1_epi32(area);
+
+    for (int i = 0; i < count; i += Block) {
+        __m128i v[4];
+        for (int k = 0; k < 4; ++k) {
+            auto    p = reinterpret_cast<__m128i *>(cells + i + 4 * k);
+            __m128i x = _mm_loadu_si128(p);
+            _mm_storeu_si128(p, zero);
+
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi32(x, carry);
+            carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+
+            x = _mm_srai_epi32(x, PixelBits * 2 + 1 - 8);
+            __m128i sign = _mm_srai_epi32(x, 31);
+            x = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+            v[k] = evenOdd ? _mm_and_si128(x, wrap) : x;
+        }
+        // the saturating packs clamp the winding coverage to 255.
+        __m128i lo = _mm_packs_epi32(v[0], v[1]);
+        __m128i hi = _mm_packs_epi32(v[2], v[3]);
+        if (evenOdd) {
+            lo = _mm_min_epi16(lo, _mm_sub_epi16(period, lo));
+            hi = _mm_min_epi16(hi, _mm_sub_epi16(period, hi));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(coverage + i),
+                         _mm_packus_epi16(lo, hi));
+    }
+    return _mm_cvtsi128_si32(carry);
+}
+#else
+static int accumulate(int *cells, int count, uchar *coverage, int area,
+                      bool evenOdd)
+{
+    for (int i = 0; i < count; ++i) {
+        area += cells[i];
+        cells[i] = 0;
+        coverage[i] = coverageOf(area, evenOdd);
+    }
+    return area;
+}
+#endif
+
+void VAccumRaster::render(const SW_FT_Outline &outline, const VRect &clip,
+                          VRle &rle)
+{
+    if (outline.n_points <= 0 || outline.n_contours <= 0) return;
+    if (!outline.contours || !outline.points ||
+        outline.n_points != outline.contours[outline.n_contours - 1] + 1)
+        return;
+
+    // the control box in whole pixels.
+    const SW_FT_Vector *vec = outline.points;
+    const SW_FT_Vector *limit = vec + outline.n_points;
+    TPos                xMin = vec->x, xMax = vec->x;
+    TPos                yMin = vec->y, yMax = vec->y;
+    for (++vec; vec < limit; ++vec) {
+        xMin = std::min(xMin, vec->x);
+        xMax = std::max(xMax, vec->x);
+        yMin = std::min(yMin, vec->y);
+        yMax = std::max(yMax, vec->y);
+    }
+    TPos minEx = xMin >> 6, maxEx = (xMax + 63) >> 6;
+    TPos minEy = yMin >> 6, maxEy = (yMax + 63) >> 6;
+
+    TPos clipLeft = -32768L, clipTop = -32768L;
+    TPos clipRight = 32767L, clipBottom = 32767L;
+    if (!clip.empty()) {
+        clipLeft = clip.left();
+        clipTop = clip.top();
+        clipRight = clip.right();
+        clipBottom = clip.bottom();
+    }
+    if (maxEx <= clipLeft || minEx >= clipRight || maxEy <= clipTop ||
+        minEy >= clipBottom)
+        return;
+
+    mMinEx = std::max(minEx, clipLeft);
+    mMaxEx = std::min(maxEx, clipRight);
+    mCountEx = mMaxEx - mMinEx;
+    minEy = std::max(minEy, clipTop);
+    maxEy = std::min(maxEy, clipBottom);
+
+    // a row keeps the column left of the clip, the pixels, and the column
+    // the area of the last pixel carries into.
+    mStride = int(mCountEx + 2 + Block - 1) & ~(Block - 1);
+    TPos rows = std::max(1L, std::min(maxEy - minEy, BandCells / mStride));
+    if (mCells.size() < size_t(rows * mStride))
+        mCells.resize(size_t(rows * mStride));
+    mBlocks = mStride / Block;
+    if (mTouched.size() < size_t(rows * mBlocks))
+        mTouched.resize(size_t(rows * mBlocks));
+    if (mRowMin.size() < size_t(rows)) {
+        mRowMin.resize(size_t(rows), INT_MAX);
+        mRowMax.resize(size_t(rows), -1);
+    }
+    if (mCoverage.size() < size_t(mStride)) mCoverage.resize(size_t(mStride));
+
+    mEvenOdd = outline.flags & SW_FT_OUTLINE_EVEN_ODD_FILL;
+    mRle = &rle;
+    mSpans.clear();
+    mLeft = mTop = INT_MAX;
+    mRight = mBottom = INT_MIN;
+
+    for (TPos top = minEy; top < maxEy; top += rows) {
+        mMinEy = top;
+        mMaxEy = std::min(top + rows, maxEy);
+        mCountEy = mMaxEy - mMinEy;
+        mInvalid = true;
+
+        walk(outline);
+        if (!mInvalid) recordCell();
+        sweep();
+    }
+
+    if (!mSpans.empty()) {
+        rle.addSpan(mSpans.data(), mSpans.size());
+        rle.setBoundingRect(
+            {mLeft, mTop, mRight - mLeft, mBottom - mTop + 1});
+    }
+    mRle = nullptr;
+}
+
+void VAccumRaster::walk(const SW_FT_Outline &outline)
+{
+    int first = 0;
+    for (int n = 0; n < outline.n_contours; ++n) {
+        int last = outline.contours[n];
+        if (last < first) return;
+
+        const SW_FT_Vector *point = outline.points + first;
+        const SW_FT_Vector *limit = outline.points + last;
+        const char *        tags = outline.tags + first;
+        SW_FT_Vector        start = *point;
+
+        char tag = SW_FT_CURVE_TAG(tags[0]);
+        // a contour cannot start with a cubic control point.
+        if (tag == SW_FT_CURVE_TAG_CUBIC) return;
+
+        if (tag == SW_FT_CURVE_TAG_CONIC) {
+            const SW_FT_Vector &end = outline.points[last];
+            if (SW_FT_CURVE_TAG(outline.tags[last]) == SW_FT_CURVE_TAG_ON) {
+                start = end;
+                limit--;
+            } else {
+                start.x = (start.x + end.x) / 2;
+                start.y = (start.y + end.y) / 2;
+            }
+            point--;
+            tags--;
+        }
+
+        moveTo(start);
+
+        bool closed = false;
+        while (!closed && point < limit) {
+            point++;
+            tags++;
+            tag = SW_FT_CURVE_TAG(tags[0]);
+
+            if (tag == SW_FT_CURVE_TAG_ON) {
+                lineTo(upscale(point->x), upscale(point->y));
+            } else if (tag == SW_FT_CURVE_TAG_CONIC) {
+                SW_FT_Vector control = *point;
+                for (;;) {
+                    if (point == limit) {
+                        conicTo(control, start);
+                        closed = true;
+                        break;
+                    }
+                    point++;
+                    tags++;
+                    tag = SW_FT_CURVE_TAG(tags[0]);
+                    if (tag == SW_FT_CURVE_TAG_ON) {
+                        conicTo(control, *point);
+                        break;
+                    }
+                    if (tag != SW_FT_CURVE_TAG_CONIC) return;
+
+                    SW_FT_Vector middle;
+                    middle.x = (control.x + point->x) / 2;
+                    middle.y = (control.y + point->y) / 2;
+                    conicTo(control, middle);
+                    control = *point;
+                }
+            } else {
+                if (point + 1 > limit ||
+                    SW_FT_CURVE_TAG(tags[1]) != SW_FT_CURVE_TAG_CUBIC)
+                    return;
+                point += 2;
+                tags += 2;
+                if (point <= limit) {
+                    cubicTo(point[-2], point[-1], *point);
+                } else {
+                    cubicTo(point[-2], point[-1], start);
+                    closed = true;
+                }
+            }
+        }
+        // close the contour with a line segment.
+        if (!closed) lineTo(upscale(start.x), upscale(start.y));
+
+        first = last + 1;
+    }
+}
+
+void VAccumRaster::moveTo(const SW_FT_Vector &to)
+{
+    if (!mInvalid) recordCell();
+
+    TPos x = upscale(to.x);
+    TPos y = upscale(to.y);
+    startCell(trunc(x), trunc(y));
+    mX = x;
+    mY = y;
+}
+
+void VAccumRaster::startCell(TPos ex, TPos ey)
+{
+    if (ex > mMaxEx) ex = mMaxEx;
+    if (ex < mMinEx) ex = mMinEx - 1;
+
+    mArea = 0;
+    mCover = 0;
+    mEx = ex - mMinEx;
+    mEy = ey - mMinEy;
+    mInvalid = false;
+
+    setCell(ex, ey);
+}
+
+void VAccumRaster::setCell(TPos ex, TPos ey)
+{
+    // the cells left of the clip all go to the column before it.
+    ey -= mMinEy;
+    if (ex > mMaxEx) ex = mMaxEx;
+    ex -= mMinEx;
+    if (ex < 0) ex = -1;
+
+    if (ex != mEx || ey != mEy) {
+        if (!mInvalid) recordCell();
+        mArea = 0;
+        mCover = 0;
+        mEx = ex;
+        mEy = ey;
+    }
+    mInvalid = (unsigned)ey >= (unsigned)mCountEy || ex >= mCountEx;
+}
+
+// a cell adds its cover minus its area to its own pixel and its area to
+// the next one, the running sum leaves the cover for the pixels after it.
+void VAccumRaster::recordCell()
+{
+    if (!(mArea | mCover)) return;
+
+    int  slot = int(mEx) + 1;
+    int *cells = mCells.data() + mEy * mStride + slot;
+    cells[0] += int(mCover * (OnePixel * 2)) - mArea;
+    cells[1] += mArea;
+
+    uchar *touched = mTouched.data() + mEy * mBlocks;
+    int    first = slot / Block, last = (slot + 1) / Block;
+    touched[first] = touched[last] = 1;
+    mRowMin[mEy] = std::min(mRowMin[mEy], first);
+    mRowMax[mEy] = std::max(mRowMax[mEy], last);
+}
+
+void VAccumRaster::lineTo(TPos toX, TPos toY)
+{
+    TPos ex1 = trunc(mX);
+    TPos ex2 = trunc(toX);
+    TPos ey1 = trunc(mY);
+    TPos ey2 = trunc(toY);
+
+    // outside the band.
+    if ((ey1 >= mMaxEy && ey2 >= mMaxEy) || (ey1 < mMinEy && ey2 < mMinEy)) {
+        mX = toX;
+        mY = toY;
+        return;
+    }
+
+    TPos dx = toX - mX;
+    TPos dy = toY - mY;
+    TPos fx1 = mX - subpixels(ex1);
+    TPos fy1 = mY - subpixels(ey1);
+    TPos fx2, fy2;
+
+    if (ex1 == ex2 && ey1 == ey2) {
+        // inside one cell.
+    } else if (dy == 0) {
+        ex1 = ex2;
+        setCell(ex1, ey1);
+    } else if (dx == 0) {
+        if (dy > 0) {
+            do {
+                fy2 = OnePixel;
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * fx1 * 2;
+                fy1 = 0;
+                ey1++;
+                setCell(ex1, ey1);
+            } while (ey1 != ey2);
+        } else {
+            do {
+                fy2 = 0;
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * fx1 * 2;
+                fy1 = OnePixel;
+                ey1--;
+                setCell(ex1, ey1);
+            } while (ey1 != ey2);
+        }
+    } else {
+        // prod tells on which side and where the line leaves the cell.
+        int        prod = dx * fy1 - dy * fx1;
+        const long dxR = reciprocal(dx);
+        const long dyR = reciprocal(dy);
+        do {
+            if (prod <= 0 && prod - dx * OnePixel > 0) {
+                // left
+                fx2 = 0;
+                fy2 = udiv(-prod, -dxR);
+                prod -= dy * OnePixel;
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * (fx1 + fx2);
+                fx1 = OnePixel;
+                fy1 = fy2;
+                ex1--;
+            } else if (prod - dx * OnePixel <= 0 &&
+                       prod - dx * OnePixel + dy * OnePixel > 0) {
+                // up
+                prod -= dx * OnePixel;
+                fx2 = udiv(-prod, dyR);
+                fy2 = OnePixel;
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * (fx1 + fx2);
+                fx1 = fx2;
+                fy1 = 0;
+                ey1++;
+            } else if (prod - dx * OnePixel + dy * OnePixel <= 0 &&
+                       prod + dy * OnePixel >= 0) {
+                // right
+                prod += dy * OnePixel;
+                fx2 = OnePixel;
+                fy2 = udiv(prod, dxR);
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * (fx1 + fx2);
+                fx1 = 0;
+                fy1 = fy2;
+                ex1++;
+            } else {
+                // down
+                fx2 = udiv(prod, -dyR);
+                fy2 = 0;
+                prod += dx * OnePixel;
+                mCover += (fy2 - fy1);
+                mArea += (fy2 - fy1) * (fx1 + fx2);
+                fx1 = fx2;
+                fy1 = OnePixel;
+                ey1--;
+            }
+            setCell(ex1, ey1);
+        } while (ex1 != ex2 || ey1 != ey2);
+    }
+
+    fx2 = toX - subpixels(ex2);
+    fy2 = toY - subpixels(ey2);
+    mCover += (fy2 - fy1);
+    mArea += (fy2 - fy1) * (fx1 + fx2);
+
+    mX = toX;
+    mY = toY;
+}
+
+static void splitConic(SW_FT_Vector *base)
+{
+    long a, b;
+
+    base[4].x = base[2].x;
+    a = base[0].x + base[1].x;
+    b = base[1].x + base[2].x;
+    base[3].x = b >> 1;
+    base[2].x = (a + b) >> 2;
+    base[1].x = a >> 1;
+
+    base[4].y = base[2].y;
+    a = base[0].y + base[1].y;
+    b = base[1].y + base[2].y;
+    base[3].y = b >> 1;
+    base[2].y = (a + b) >> 2;
+    base[1].y = a >> 1;
+}
+
+void VAccumRaster::conicTo(const SW_FT_Vector &control, const SW_FT_Vector &to)
+{
+    SW_FT_Vector *arc = mBezStack;
+    arc[0].x = upscale(to.x);
+    arc[0].y = upscale(to.y);
+    arc[1].x = upscale(control.x);
+    arc[1].y = upscale(control.y);
+    arc[2].x = mX;
+    arc[2].y = mY;
+
+    TPos dx = std::abs(arc[2].x + arc[0].x - 2 * arc[1].x);
+    TPos dy = std::abs(arc[2].y + arc[0].y - 2 * arc[1].y);
+    if (dx < dy) dx = dy;
+
+    // flat enough, or outside the band.
+    TPos minY = std::min({arc[0].y, arc[1].y, arc[2].y});
+    TPos maxY = std::max({arc[0].y, arc[1].y, arc[2].y});
+    if (dx < OnePixel / 4 || trunc(minY) >= mMaxEy || trunc(maxY) < mMinEy) {
+        lineTo(arc[0].x, arc[0].y);
+        return;
+    }
+
+    int level = 0;
+    do {
+        dx >>= 2;
+        level++;
+    } while (dx > OnePixel / 4);
+
+    int *levels = mLevStack;
+    int  top = 0;
+    levels[0] = level;
+    do {
+        level = levels[top];
+        if (level > 0) {
+            splitConic(arc);
+            arc += 2;
+            top++;
+            levels[top] = levels[top - 1] = level - 1;
+            continue;
+        }
+        lineTo(arc[0].x, arc[0].y);
+        top--;
+        arc -= 2;
+    } while (top >= 0);
+}
+
+static void splitCubic(SW_FT_Vector *base)
+{
+    long a, b, c;
+
+    base[6].x = base[3].x;
+    a = base[0].x + base[1].x;
+    b = base[1].x + base[2].x;
+    c = base[2].x + base[3].x;
+    base[5].x = c >> 1;
+    c += b;
+    base[4].x = c >> 2;
+    base[1].x = a >> 1;
+    a += b;
+    base[2].x = a >> 2;
+    base[3].x = (a + c) >> 3;
+
+    base[6].y = base[3].y;
+    a = base[0].y + base[1].y;
+    b = base[1].y + base[2].y;
+    c = base[2].y + base[3].y;
+    base[5].y = c >> 1;
+    c += b;
+    base[4].y = c >> 2;
+    base[1].y = a >> 1;
+    a += b;
+    base[2].y = a >> 2;
+    base[3].y = (a + c) >> 3;
+}
+
+void VAccumRaster::cubicTo(const SW_FT_Vector &control1,
+                           const SW_FT_Vector &control2,
+                           const SW_FT_Vector &to)
+{
+    SW_FT_Vector *arc = mBezStack;
+    arc[0].x = upscale(to.x);
+    arc[0].y = upscale(to.y);
+    arc[1].x = upscale(control2.x);
+    arc[1].y = upscale(control2.y);
+    arc[2].x = upscale(control1.x);
+    arc[2].y = upscale(control1.y);
+    arc[3].x = mX;
+    arc[3].y = mY;
+
+    // skip the arcs outside the band.
+    TPos minY = std::min({arc[0].y, arc[1].y, arc[2].y, arc[3].y});
+    TPos maxY = std::max({arc[0].y, arc[1].y, arc[2].y, arc[3].y});
+    if (trunc(minY) >= mMaxEy || trunc(maxY) < mMinEy) {
+        mX = arc[0].x;
+        mY = arc[0].y;
+        return;
+    }
+
+    for (;;) {
+        // the control points converge towards the chord trisection points,
+        // the segment is drawn once they are close enough.
+        if (std::abs(2 * arc[0].x - 3 * arc[1].x + arc[3].x) > OnePixel / 2 ||
+            std::abs(2 * arc[0].y - 3 * arc[1].y + arc[3].y) > OnePixel / 2 ||
+            std::abs(arc[0].x - 3 * arc[2].x + 2 * arc[3].x) > OnePixel / 2 ||
+            std::abs(arc[0].y - 3 * arc[2].y + 2 * arc[3].y) > OnePixel / 2) {
+            splitCubic(arc);
+            arc += 3;
+            continue;
+        }
+
+        lineTo(arc[0].x, arc[0].y);
+        if (arc == mBezStack) return;
+        arc -= 3;
+    }
+}
+
+// only the blocks of a row that cells were recorded in are summed, the
+// coverage between them stays that of the cover carried over.
+void VAccumRaster::sweep()
+{
+    const uchar *coverage = mCoverage.data();
+    for (TPos row = 0; row < mCountEy; ++row) {
+        int lo = mRowMin[row];
+        int hi = mRowMax[row];
+        if (lo > hi) continue;
+        mRowMin[row] = INT_MAX;
+        mRowMax[row] = -1;
+
+        int    y = int(mMinEy + row);
+        int *  cells = mCells.data() + row * mStride;
+        uchar *touched = mTouched.data() + row * mBlocks;
+        int    area = 0;
+        int    done = 0;
+        for (int b = lo; b <= hi; ++b) {
+            if (!touched[b]) continue;
+            int e = b;
+            while (e <= hi && touched[e]) touched[e++] = 0;
+
+            int from = b * Block, to = e * Block;
+            if (area) addRun(y, done, from, coverageOf(area, mEvenOdd));
+            area = accumulate(cells + from, to - from, mCoverage.data() + from,
+                              area, mEvenOdd);
+            for (int i = from; i < to;) {
+                int j = i + 1;
+                while (j < to && coverage[j] == coverage[i]) ++j;
+                addRun(y, i, j, coverage[i]);
+                i = j;
+            }
+            done = to;
+            b = e;
+        }
+        // the cover left after the last cell runs to the end of the row.
+        if (area)
+            addRun(y, done, int(mCountEx) + 1, coverageOf(area, mEvenOdd));
+    }
+}
+
+// slot 0 is the column left of the clip, slot i pixel i - 1.
+void VAccumRaster::addRun(int y, int from, int to, uchar coverage)
+{
+    from = std::max(from, 1);
+    to = std::min(to, int(mCountEx) + 1);
+    if (from < to) addSpan(int(mMinEx) + from - 1, y, to - from, coverage);
+}
+
+void VAccumRaster::addSpan(int x, int y, int len, uchar coverage)
+{
+    if (!coverage) return;
+
+    mLeft = std::min(mLeft, x);
+    mTop = std::min(mTop, y);
+    mBottom = std::max(mBottom, y);
+    mRight = std::max(mRight, x + len);
+
+    if (!mSpans.empty()) {
+        VRle::Span &last = mSpans.back();
+        if (last.y == y && last.x + last.len == x &&
+            last.coverage == coverage) {
+            last.len = ushort(last.len + len);
+            return;
+        }
+        if (mSpans.size() == SpanBatch) flush();
+    }
+
+    VRle::Span span;
+    span.x = short(x);
+    span.y = short(y);
+    span.len = ushort(len);
+    span.coverage = coverage;
+    mSpans.push_back(span);
+}
+
+// hands all but the last span to the rle, the next one may still extend it.
+void VAccumRaster::flush()
+{
+    mRle->addSpan(mSpans.data(), mSpans.size() - 1);
+    mSpans.front() = mSpans.back();
+    mSpans.resize(1);
+}
+
+V_END_NAMESPACE
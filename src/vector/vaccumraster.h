@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd. All rights reserved.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef VACCUMRASTER_H
+#define VACCUMRASTER_H
+
+#include <vector>
+#include "v_ft_raster.h"
+#include "vglobal.h"
+#include "vrect.h"
+#include "vrle.h"
+
+V_BEGIN_NAMESPACE
+
+/*
+ * scan converts an outline by accumulating the coverage deltas of its
+ * edges into dense rows, a running sum over a row gives the coverage of its
+ * pixels. only the range of a row that its edges touched is summed and
+ * cleared again. the edges are walked with the cell math of the gray
+ * raster, so both give the same coverage.
+ *
+ * the rows of a band of scanlines are kept at once, the buffers grow to
+ * the largest band seen and are reused by the next outlines. an outline
+ * taller than a band is walked again for every band, the edges outside
+ * the band are skipped.
+ */
+class VAccumRaster {
+public:
+    void render(const SW_FT_Outline &outline, const VRect &clip, VRle &rle);
+
+private:
+    using TPos = long;
+
+    void walk(const SW_FT_Outline &outline);
+    void moveTo(const SW_FT_Vector &to);
+    void lineTo(TPos toX, TPos toY);
+    void conicTo(const SW_FT_Vector &control, const SW_FT_Vector &to);
+    void cubicTo(const SW_FT_Vector &control1, const SW_FT_Vector &control2,
+                 const SW_FT_Vector &to);
+    void startCell(TPos ex, TPos ey);
+    void setCell(TPos ex, TPos ey);
+    void recordCell();
+    void sweep();
+    void addRun(int y, int from, int to, uchar coverage);
+    void addSpan(int x, int y, int len, uchar coverage);
+    void flush();
+
+    TPos mX{0}, mY{0};
+    TPos mEx{0}, mEy{0};
+    TPos mMinEx{0}, mMaxEx{0}, mCountEx{0};
+    TPos mMinEy{0}, mMaxEy{0}, mCountEy{0};
+    int  mArea{0};
+    TPos mCover{0};
+    bool mInvalid{true};
+    bool mEvenOdd{false};
+    int  mStride{0};
+    int  mBlocks{0};
+
+    // the coverage deltas of the band rows, the blocks of each row that
+    // cells were recorded in and the first and last of them.
+    std::vector<int>   mCells;
+    std::vector<uchar> mTouched;
+    std::vector<int>   mRowMin;
+    std::vector<int>   mRowMax;
+    std::vector<uchar> mCoverage;
+
+    SW_FT_Vector mBezStack[32 * 3 + 1];
+    int          mLevStack[32];
+
+    VRle *                  mRle{nullptr};
+    std::vector<VRle::Span> mSpans;
+    int                     mLeft, mTop, mRight, mBottom;
+};
+
+V_END_NAMESPACE
+
+#endif  // VACCUMRASTER_H
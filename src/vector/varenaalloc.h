@@ -130,6 +130,12 @@ public:
     // Destroy all allocated objects, free any heap allocations.
     void reset();
 
+    // Heap bytes taken by the allocations so far. An arena created with this
+    // value as firstHeapAllocation holds the same allocations in one block.
+    size_t usedBytes() const {
+        return fHeapBytes ? fHeapBytes - size_t(fEnd - fCursor) : 0;
+    }
+
 private:
     static void AssertRelease(bool cond) { if (!cond) { ::abort(); } }
     static uint32_t ToU32(size_t v) {
@@ -215,6 +221,7 @@ private:
     // allocated is fFib0 * fFirstHeapAllocationSize. Using 2 ^ n * fFirstHeapAllocationSize
     // had too much slop for Android.
     uint32_t       fFib0 {1}, fFib1 {1};
+    size_t         fHeapBytes {0};
 };
 
 // Helper for defining allocators with inline/reserved storage.
@@ -38,7 +38,13 @@ void VBitmap::Impl::reset(size_t width, size_t height, VBitmap::Format format)
     mDepth = depth(format);
     mStride = ((mWidth * mDepth + 31) >> 5)
                   << 2;  // bytes per scanline (must be multiple of 4)
-    mOwnData = std::make_unique<uchar[]>(mStride * mHeight);
+
+    // keep the current allocation when it is large enough.
+    size_t size = size_t(mStride) * mHeight;
+    if (!mOwnData || mCapacity < size) {
+        mOwnData = std::make_unique<uchar[]>(size);
+        mCapacity = size;
+    }
 }
 
 void VBitmap::Impl::reset(uchar *data, size_t width, size_t height, size_t bytesPerLine,
@@ -51,6 +57,7 @@ void VBitmap::Impl::reset(uchar *data, size_t width, size_t height, size_t bytes
     mFormat = format;
     mDepth = depth(format);
     mOwnData = nullptr;
+    mCapacity = 0;
 }
 
 uchar VBitmap::Impl::depth(VBitmap::Format format)
@@ -62,6 +69,7 @@ uchar VBitmap::Impl::depth(VBitmap::Format format)
         break;
     case VBitmap::Format::ARGB32:
     case VBitmap::Format::ARGB32_Premultiplied:
+    case VBitmap::Format::RGBA32_Premultiplied:
         depth = 32;
         break;
     default:
@@ -81,27 +89,7 @@ void VBitmap::Impl::updateLuma()
     auto dataPtr = data();
     for (uint col = 0; col < mHeight; col++) {
         uint *pixel = (uint *)(dataPtr + mStride * col);
-        for (uint row = 0; row < mWidth; row++) {
-            int alpha = vAlpha(*pixel);
-            if (alpha == 0) {
-                pixel++;
-                continue;
-            }
-
-            int red = vRed(*pixel);
-            int green = vGreen(*pixel);
-            int blue = vBlue(*pixel);
-
-            if (alpha != 255) {
-                // un multiply
-                red = (red * 255) / alpha;
-                green = (green * 255) / alpha;
-                blue = (blue * 255) / alpha;
-            }
-            int luminosity = int(0.299f * red + 0.587f * green + 0.114f * blue);
-            *pixel = luminosity << 24;
-            pixel++;
-        }
+        convertPixels(PixelFunc::Type::Luma, pixel, pixel, int(mWidth));
     }
 }
 
@@ -165,6 +153,11 @@ size_t VBitmap::depth() const
     return mImpl ? mImpl->mDepth : 0;
 }
 
+size_t VBitmap::capacity() const
+{
+    return mImpl ? mImpl->mCapacity : 0;
+}
+
 uchar *VBitmap::data()
 {
     return mImpl ? mImpl->data() : nullptr;
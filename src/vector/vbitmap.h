@@ -34,7 +34,8 @@ public:
         Invalid,
         Alpha8,
         ARGB32,
-        ARGB32_Premultiplied
+        ARGB32_Premultiplied,
+        RGBA32_Premultiplied  // r, g, b, a bytes, only drawn into
     };
 
     VBitmap() = default;
@@ -46,6 +47,7 @@ public:
     size_t          width() const;
     size_t          height() const;
     size_t          depth() const;
+    size_t          capacity() const;  // bytes owned by the bitmap
     VBitmap::Format format() const;
     bool            valid() const;
     uchar *         data();
@@ -61,6 +63,7 @@ private:
         uint            mWidth{0};
         uint            mHeight{0};
         uint            mStride{0};
+        size_t          mCapacity{0};
         uchar           mDepth{0};
         VBitmap::Format mFormat{VBitmap::Format::Invalid};
 
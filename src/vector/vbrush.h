@@ -64,9 +64,13 @@ public:
 };
 
 struct VTexture {
+    // sampling of a transformed bitmap.
+    enum class Filter { Nearest, Bilinear };
+
     VBitmap  mBitmap;
     VMatrix  mMatrix;
     int      mAlpha{255};
+    Filter   mFilter{Filter::Nearest};
 };
 
 class VBrush {
@@ -63,21 +63,70 @@ void VDrawable::applyDashOp()
 
 void VDrawable::preprocess(const VRect &clip)
 {
+    // the shared raster was never picked up, fall back to our own path.
+    if (mSharePending) {
+        mSharePending = false;
+        mFlag |= DirtyState::Path;
+    }
+
     if (mFlag & (DirtyState::Path)) {
-        if (mType == Type::Fill) {
-            mRasterizer.rasterize(std::move(mPath), mFillRule, clip);
-        } else {
-            applyDashOp();
-            mRasterizer.rasterize(std::move(mPath), mStrokeInfo->cap, mStrokeInfo->join,
-                                  mStrokeInfo->width, mStrokeInfo->miterLimit, clip);
+        mClip = clip;
+        // the source is preprocessed before us when it is drawn this frame.
+        if (mRasterSource && !(mRasterSource->mFlag & DirtyState::Path) &&
+            mRasterSource->mClip == clip) {
+            mSharePending = true;
+            mFlag &= ~DirtyFlag(DirtyState::Path);
+            return;
         }
-        mPath = {};
-        mFlag &= ~DirtyFlag(DirtyState::Path);
+        rasterize();
     }
 }
 
+void VDrawable::rasterize()
+{
+    if (mType == Type::Fill) {
+        mRasterizer.rasterize(std::move(mPath), mFillRule, mClip);
+    } else {
+        applyDashOp();
+        mRasterizer.rasterize(std::move(mPath), mStrokeInfo->cap,
+                              mStrokeInfo->join, mStrokeInfo->width,
+                              mStrokeInfo->miterLimit, mClip);
+    }
+    mPath = {};
+    mFlag &= ~DirtyFlag(DirtyState::Path);
+}
+
+void VDrawable::resolveSharedRaster()
+{
+    mSharePending = false;
+    if (!mRasterSource) {
+        rasterize();
+        return;
+    }
+
+    VRle  rle = mRasterSource->rle();
+    VRect box = rle.boundingRect();
+    // only a raster that didn't touch the clip is complete.
+    bool complete = !rle.empty() &&
+                    (mClip.empty() ||
+                     (box.left() > mClip.left() && box.top() > mClip.top() &&
+                      box.right() < mClip.right() &&
+                      box.bottom() < mClip.bottom()));
+    if (!complete) {
+        rasterize();
+        return;
+    }
+
+    rle.translate(mRasterOffset);
+    if (!mClip.empty() && !mClip.contains(rle.boundingRect()))
+        rle = mClip & rle;
+    mRasterizer.setRle(rle);
+    mPath = {};
+}
+
 VRle VDrawable::rle()
 {
+    if (mSharePending) resolveSharedRaster();
     return mRasterizer.rle();
 }
 
@@ -59,6 +59,13 @@ public:
     void preprocess(const VRect &clip);
     void applyDashOp();
     VRle rle();
+    // take the raster of source moved by offset instead of rasterizing our
+    // own path, the caller makes sure both paths only differ by that offset.
+    void shareRaster(VDrawable *source, const VPoint &offset)
+    {
+        mRasterSource = source;
+        mRasterOffset = offset;
+    }
     void setName(const char *name)
     {
         mName = name;
@@ -88,6 +95,15 @@ public:
     VDrawable::Type          mType{Type::Fill};
 
     const char              *mName{nullptr};
+
+private:
+    void rasterize();
+    void resolveSharedRaster();
+
+    VDrawable               *mRasterSource{nullptr};
+    VPoint                   mRasterOffset;
+    VRect                    mClip;
+    bool                     mSharePending{false};
 };
 
 #endif  // VDRAWABLE_H
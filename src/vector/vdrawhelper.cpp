@@ -188,7 +188,7 @@ VBitmap::Format VRasterBuffer::prepare(const VBitmap *image)
     mBuffer = image->data();
     mWidth = image->width();
     mHeight = image->height();
-    mBytesPerPixel = 4;
+    mBytesPerPixel = image->depth() / 8;
     mBytesPerLine = image->stride();
 
     mFormat = image->format();
@@ -209,8 +209,6 @@ void VSpanData::init(VRasterBuffer *image)
  *
  */
 
-#define FIXPT_BITS 8
-#define FIXPT_SIZE (1 << FIXPT_BITS)
 static inline void getLinearGradientValues(LinearGradientValues *v,
                                            const VSpanData *     data)
 {
@@ -242,41 +240,6 @@ static inline void getRadialGradientValues(RadialGradientValues *v,
     v->extended = !vIsZero(gradient.radial.fradius) || v->a <= 0;
 }
 
-static inline int gradientClamp(const VGradientData *grad, int ipos)
-{
-    int limit;
-
-    if (grad->mSpread == VGradient::Spread::Repeat) {
-        ipos = ipos % VGradient::colorTableSize;
-        ipos = ipos < 0 ? VGradient::colorTableSize + ipos : ipos;
-    } else if (grad->mSpread == VGradient::Spread::Reflect) {
-        limit = VGradient::colorTableSize * 2;
-        ipos = ipos % limit;
-        ipos = ipos < 0 ? limit + ipos : ipos;
-        ipos = ipos >= VGradient::colorTableSize ? limit - 1 - ipos : ipos;
-    } else {
-        if (ipos < 0)
-            ipos = 0;
-        else if (ipos >= VGradient::colorTableSize)
-            ipos = VGradient::colorTableSize - 1;
-    }
-    return ipos;
-}
-
-static uint32_t gradientPixelFixed(const VGradientData *grad, int fixed_pos)
-{
-    int ipos = (fixed_pos + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
-
-    return grad->mColorTable[gradientClamp(grad, ipos)];
-}
-
-static inline uint32_t gradientPixel(const VGradientData *grad, float pos)
-{
-    int ipos = (int)(pos * (VGradient::colorTableSize - 1) + (float)(0.5));
-
-    return grad->mColorTable[gradientClamp(grad, ipos)];
-}
-
 void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
                            const VSpanData *data, int y, int x, int length)
 {
@@ -311,13 +274,9 @@ void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
             if (t + inc * length < float(INT_MAX >> (FIXPT_BITS + 1)) &&
                 t + inc * length > float(INT_MIN >> (FIXPT_BITS + 1))) {
                 // we can use fixed point math
-                int t_fixed = int(t * FIXPT_SIZE);
-                int inc_fixed = int(inc * FIXPT_SIZE);
-                while (buffer < end) {
-                    *buffer = gradientPixelFixed(gradient, t_fixed);
-                    t_fixed += inc_fixed;
-                    ++buffer;
-                }
+                RenderTable.gradientLinear()(buffer, length, gradient,
+                                             int(t * FIXPT_SIZE),
+                                             int(inc * FIXPT_SIZE));
             } else {
                 // we have to fall back to float math
                 while (buffer < end) {
@@ -348,6 +307,34 @@ void fetch_linear_gradient(uint32_t *buffer, const Operator *op,
     }
 }
 
+// true when every span of the linear gradient is a single color.
+static bool linearGradientIsSolid(const VSpanData *data)
+{
+    LinearGradientValues v;
+    getLinearGradientValues(&v, data);
+    if (v.l == 0) return true;
+    if (data->m13 || data->m23) return false;
+
+    float inc = v.dx * data->m11 + v.dy * data->m12;
+    inc *= (VGradient::colorTableSize - 1);
+    return inc > float(-1e-5) && inc < float(1e-5);
+}
+
+// the color fetch_linear_gradient() fills a solid span with.
+static inline uint32_t linearGradientColor(const Operator *op,
+                                           const VSpanData *data, int y, int x)
+{
+    if (op->linear.l == 0) return gradientPixelFixed(&data->mGradient, 0);
+
+    float rx =
+        data->m21 * (y + float(0.5)) + data->m11 * (x + float(0.5)) + data->dx;
+    float ry =
+        data->m22 * (y + float(0.5)) + data->m12 * (x + float(0.5)) + data->dy;
+    float t = op->linear.dx * rx + op->linear.dy * ry + op->linear.off;
+    t *= (VGradient::colorTableSize - 1);
+    return gradientPixelFixed(&data->mGradient, int(t * FIXPT_SIZE));
+}
+
 static inline float radialDeterminant(float a, float b, float c)
 {
     return (b * b) - (4 * a * c);
@@ -357,31 +344,23 @@ static void fetch(uint32_t *buffer, uint32_t *end, const Operator *op,
                   const VSpanData *data, float det, float delta_det,
                   float delta_delta_det, float b, float delta_b)
 {
-    if (op->radial.extended) {
-        while (buffer < end) {
-            uint32_t result = 0;
-            if (det >= 0) {
-                float w = std::sqrt(det) - b;
-                if (data->mGradient.radial.fradius + op->radial.dr * w >= 0)
-                    result = gradientPixel(&data->mGradient, w);
-            }
+    // the recurrence stays serial, the lookups run in blocks.
+    constexpr int BlockSize = 64;
+    float         dets[BlockSize], bs[BlockSize];
 
-            *buffer = result;
-
-            det += delta_det;
-            delta_det += delta_delta_det;
-            b += delta_b;
-
-            ++buffer;
-        }
-    } else {
-        while (buffer < end) {
-            *buffer++ = gradientPixel(&data->mGradient, std::sqrt(det) - b);
+    while (buffer < end) {
+        int count = std::min(int(end - buffer), BlockSize);
+        for (int i = 0; i < count; ++i) {
+            dets[i] = det;
+            bs[i] = b;
 
             det += delta_det;
             delta_det += delta_delta_det;
             b += delta_b;
         }
+        RenderTable.gradientRadial()(buffer, count, &data->mGradient,
+                                     &op->radial, dets, bs);
+        buffer += count;
     }
 }
 
@@ -485,36 +464,47 @@ static inline Operator getOperator(const VSpanData *data)
 {
     Operator op;
     bool     solidSource = false;
+    bool     opaqueSource = false;
 
     switch (data->mType) {
     case VSpanData::Type::Solid:
         solidSource = (vAlpha(data->mSolid) == 255);
-        op.srcFetch = nullptr;
         break;
     case VSpanData::Type::LinearGradient:
         solidSource = false;
+        opaqueSource = !data->mGradient.mColorTableAlpha;
         getLinearGradientValues(&op.linear, data);
-        op.srcFetch = &fetch_linear_gradient;
         break;
     case VSpanData::Type::RadialGradient:
         solidSource = false;
         getRadialGradientValues(&op.radial, data);
-        op.srcFetch = &fetch_radial_gradient;
         break;
     default:
-        op.srcFetch = nullptr;
         break;
     }
 
     op.mode = data->mBlendMode;
     if (op.mode == BlendMode::SrcOver && solidSource) op.mode = BlendMode::Src;
+    op.replace = op.mode == BlendMode::Src ||
+                 (op.mode == BlendMode::SrcOver && opaqueSource);
 
     op.funcSolid = RenderTable.color(op.mode);
     op.func = RenderTable.src(op.mode);
+    op.funcAlpha8Solid = RenderTable.alpha8Color(op.mode);
+    op.funcAlpha8 = RenderTable.alpha8Src(op.mode);
+    op.funcMask = RenderTable.mask(op.mode);
 
     return op;
 }
 
+// a surface of r, g, b, a bytes is blended with the argb kernels, the
+// sources are taken with red and blue swapped.
+static inline bool swapsRB(const VSpanData *data)
+{
+    return data->mRasterBuffer && data->mRasterBuffer->format() ==
+                                      VBitmap::Format::RGBA32_Premultiplied;
+}
+
 static void blend_color(size_t size, const VRle::Span *array, void *userData)
 {
     VSpanData *data = (VSpanData *)(userData);
@@ -527,6 +517,22 @@ static void blend_color(size_t size, const VRle::Span *array, void *userData)
     }
 }
 
+static void blend_color_alpha8(size_t size, const VRle::Span *array,
+                               void *userData)
+{
+    VSpanData *data = (VSpanData *)(userData);
+    Operator   op = getOperator(data);
+    const uint color = data->mSolid;
+
+    if (!op.funcAlpha8Solid) return;
+
+    for (size_t i = 0; i < size; ++i) {
+        const auto &span = array[i];
+        op.funcAlpha8Solid(data->alphaBuffer(span.x, span.y), span.len, color,
+                           span.coverage);
+    }
+}
+
 // Signature of Process Object
 //  void Pocess(uint* scratchBuffer, size_t x, size_t y, uchar cov)
 template <class Process>
@@ -547,26 +553,91 @@ static inline void process_in_chunk(const VRle::Span *array, size_t size,
     }
 }
 
+template <SourceFetchProc fetch>
 static void blend_gradient(size_t size, const VRle::Span *array,
                            void *userData)
 {
     VSpanData *data = (VSpanData *)(userData);
     Operator   op = getOperator(data);
 
-    if (!op.srcFetch) return;
-
     process_in_chunk(
         array, size,
         [&](uint *scratch, size_t x, size_t y, size_t len, uchar cov) {
-            op.srcFetch(scratch, &op, data, (int)y, (int)x, (int)len);
+            if (cov == 255 && op.replace) {
+                fetch(data->buffer((int)x, (int)y), &op, data, (int)y, (int)x,
+                      (int)len);
+                return;
+            }
+            fetch(scratch, &op, data, (int)y, (int)x, (int)len);
             op.func(data->buffer((int)x, (int)y), (int)len, scratch, cov);
         });
 }
 
-template <class T>
-constexpr const T &clamp(const T &v, const T &lo, const T &hi)
+template <SourceFetchProc fetch>
+static void fetch_swapped(uint32_t *buffer, const Operator *op,
+                          const VSpanData *data, int y, int x, int length)
+{
+    fetch(buffer, op, data, y, x, length);
+    convertPixels(PixelFunc::Type::SwapRB, buffer, buffer, length);
+}
+
+template <SourceFetchProc fetch>
+static void blend_gradient_alpha8(size_t size, const VRle::Span *array,
+                                  void *userData)
+{
+    VSpanData *data = (VSpanData *)(userData);
+    Operator   op = getOperator(data);
+
+    if (!op.funcAlpha8) return;
+
+    process_in_chunk(
+        array, size,
+        [&](uint *scratch, size_t x, size_t y, size_t len, uchar cov) {
+            fetch(scratch, &op, data, (int)y, (int)x, (int)len);
+            op.funcAlpha8(data->alphaBuffer((int)x, (int)y), (int)len, scratch,
+                          cov);
+        });
+}
+
+// linear gradients that do not change along a span, like the vertical
+// ones, blend the color of the span start without fetching the span. the
+// color kernels of SrcOver, DestIn and DestOut give the pixels of the Src
+// ones but for a clear color at full coverage, which SrcOver skips.
+static void blend_linear_solid(size_t size, const VRle::Span *array,
+                               void *userData)
 {
-    return v < lo ? lo : hi < v ? hi : v;
+    VSpanData *data = (VSpanData *)(userData);
+    Operator   op = getOperator(data);
+    const bool swap = swapsRB(data);
+
+    process_in_chunk(
+        array, size, [&](uint *, size_t x, size_t y, size_t len, uchar cov) {
+            auto color = linearGradientColor(&op, data, (int)y, (int)x);
+            if (swap) color = swap_rb_pixel(color);
+            if (cov == 255 && op.replace)
+                memfill32(data->buffer((int)x, (int)y), color, (int)len);
+            else if (cov != 255 || color || op.mode != BlendMode::SrcOver)
+                op.funcSolid(data->buffer((int)x, (int)y), (int)len, color,
+                             cov);
+        });
+}
+
+static void blend_linear_solid_alpha8(size_t size, const VRle::Span *array,
+                                      void *userData)
+{
+    VSpanData *data = (VSpanData *)(userData);
+    Operator   op = getOperator(data);
+
+    if (!op.funcAlpha8Solid) return;
+
+    // only for SrcOver, the same as the argb one.
+    process_in_chunk(
+        array, size, [&](uint *, size_t x, size_t y, size_t len, uchar cov) {
+            auto color = linearGradientColor(&op, data, (int)y, (int)x);
+            if (cov != 255 || color)
+                op.funcAlpha8Solid(data->alphaBuffer((int)x, (int)y),
+                                   (int)len, color, cov);
+        });
 }
 
 static constexpr inline uchar alpha_mul(uchar a, uchar b)
@@ -574,6 +645,22 @@ static constexpr inline uchar alpha_mul(uchar a, uchar b)
     return ((a * b) >> 8);
 }
 
+static inline void fetch_image_xform(TextureFunc::Fetch fetch, uint *scratch,
+                                     const VSpanData *data, size_t x, size_t y,
+                                     size_t len)
+{
+    const auto &src = data->texture();
+    float       xfactor = y * data->m21 + data->dx + data->m11;
+    float       yfactor = y * data->m22 + data->dy + data->m12;
+    if (src.filter() == VTexture::Filter::Bilinear) {
+        // pixel centers, shifted by half a texel for the interpolation.
+        xfactor = (y + 0.5f) * data->m21 + data->dx + 0.5f * data->m11 - 0.5f;
+        yfactor = (y + 0.5f) * data->m22 + data->dy + 0.5f * data->m12 - 0.5f;
+    }
+    fetch(scratch, int(len), &src, int(x), xfactor, yfactor, data->m11,
+          data->m12);
+}
+
 static void blend_image_xform(size_t size, const VRle::Span *array,
                               void *userData)
 {
@@ -585,27 +672,26 @@ static void blend_image_xform(size_t size, const VRle::Span *array,
         //@TODO other formats not yet handled.
         return;
     }
+    if (src.left > src.right || src.top > src.bottom) return;
 
-    Operator op = getOperator(data);
+    Operator   op = getOperator(data);
+    auto       fetch = RenderTable.texture(src.filter());
+    const bool swap = swapsRB(data);
 
     process_in_chunk(
         array, size,
         [&](uint *scratch, size_t x, size_t y, size_t len, uchar cov) {
-            const auto  coverage = (cov * src.alpha()) >> 8;
-            const float xfactor = y * data->m21 + data->dx + data->m11;
-            const float yfactor = y * data->m22 + data->dy + data->m12;
-            for (size_t i = 0; i < len; i++) {
-                const float fx = (x + i) * data->m11 + xfactor;
-                const float fy = (x + i) * data->m12 + yfactor;
-                const int   px = clamp(int(fx), src.left, src.right);
-                const int   py = clamp(int(fy), src.top, src.bottom);
-                scratch[i] = src.pixel(px, py);
-            }
+            const auto coverage = (cov * src.alpha()) >> 8;
+            fetch_image_xform(fetch, scratch, data, x, y, len);
+            if (swap)
+                convertPixels(PixelFunc::Type::SwapRB, scratch, scratch,
+                              int(len));
             op.func(data->buffer((int)x, (int)y), (int)len, scratch, coverage);
         });
 }
 
-static void blend_image(size_t size, const VRle::Span *array, void *userData)
+static void blend_image_xform_alpha8(size_t size, const VRle::Span *array,
+                                     void *userData)
 {
     const auto  data = reinterpret_cast<const VSpanData *>(userData);
     const auto &src = data->texture();
@@ -615,8 +701,30 @@ static void blend_image(size_t size, const VRle::Span *array, void *userData)
         //@TODO other formats not yet handled.
         return;
     }
+    if (src.left > src.right || src.top > src.bottom) return;
 
     Operator op = getOperator(data);
+    auto     fetch = RenderTable.texture(src.filter());
+
+    if (!op.funcAlpha8) return;
+
+    process_in_chunk(
+        array, size,
+        [&](uint *scratch, size_t x, size_t y, size_t len, uchar cov) {
+            const auto coverage = (cov * src.alpha()) >> 8;
+            fetch_image_xform(fetch, scratch, data, x, y, len);
+            op.funcAlpha8(data->alphaBuffer((int)x, (int)y), (int)len, scratch,
+                          coverage);
+        });
+}
+
+// Signature of Blend Object
+//  void Blend(int x, int y, int length, int sx, int sy, uchar alpha)
+template <class Blend>
+static inline void process_image(const VRle::Span *array, size_t size,
+                                 const VSpanData *data, Blend blend)
+{
+    const auto &src = data->texture();
 
     for (size_t i = 0; i < size; i++) {
         const auto &span = array[i];
@@ -639,11 +747,82 @@ static void blend_image(size_t size, const VRle::Span *array, void *userData)
         // intersecting right edge of image
         if (sx + length > int(src.width())) length = (int)src.width() - sx;
 
-        op.func(data->buffer(x, span.y), length, src.pixelRef(sx, sy),
-                alpha_mul(span.coverage, src.alpha()));
+        blend(x, span.y, length, sx, sy, alpha_mul(span.coverage, src.alpha()));
     }
 }
 
+static void blend_image(size_t size, const VRle::Span *array, void *userData)
+{
+    const auto  data = reinterpret_cast<const VSpanData *>(userData);
+    const auto &src = data->texture();
+
+    Operator op = getOperator(data);
+
+    // a coverage only image is used as a mask.
+    if (src.format() == VBitmap::Format::Alpha8) {
+        if (!op.funcMask) return;
+        process_image(array, size, data,
+                      [&](int x, int y, int length, int sx, int sy, uchar a) {
+                          op.funcMask(data->buffer(x, y), length,
+                                      src.alphaRef(sx, sy), a);
+                      });
+        return;
+    }
+
+    if (src.format() != VBitmap::Format::ARGB32_Premultiplied &&
+        src.format() != VBitmap::Format::ARGB32) {
+        //@TODO other formats not yet handled.
+        return;
+    }
+
+    if (swapsRB(data)) {
+        std::array<uint, 2048> buf;
+        process_image(
+            array, size, data,
+            [&](int x, int y, int length, int sx, int sy, uchar a) {
+                while (length) {
+                    int l = std::min(length, int(buf.size()));
+                    convertPixels(PixelFunc::Type::SwapRB, buf.data(),
+                                  src.pixelRef(sx, sy), l);
+                    op.func(data->buffer(x, y), l, buf.data(), a);
+                    x += l;
+                    sx += l;
+                    length -= l;
+                }
+            });
+        return;
+    }
+
+    process_image(array, size, data,
+                  [&](int x, int y, int length, int sx, int sy, uchar a) {
+                      op.func(data->buffer(x, y), length, src.pixelRef(sx, sy),
+                              a);
+                  });
+}
+
+static void blend_image_alpha8(size_t size, const VRle::Span *array,
+                               void *userData)
+{
+    const auto  data = reinterpret_cast<const VSpanData *>(userData);
+    const auto &src = data->texture();
+
+    if (src.format() != VBitmap::Format::ARGB32_Premultiplied &&
+        src.format() != VBitmap::Format::ARGB32) {
+        //@TODO other formats not yet handled.
+        return;
+    }
+
+    Operator op = getOperator(data);
+
+    if (!op.funcAlpha8) return;
+
+    process_image(array, size, data,
+                  [&](int x, int y, int length, int sx, int sy, uchar a) {
+                      op.funcAlpha8(data->alphaBuffer(x, y), length,
+                                    src.pixelRef(sx, sy), a);
+                  });
+}
+
 void VSpanData::setup(const VBrush &brush, BlendMode /*mode*/, int /*alpha*/)
 {
     transformType = VMatrix::MatrixType::None;
@@ -655,6 +834,7 @@ void VSpanData::setup(const VBrush &brush, BlendMode /*mode*/, int /*alpha*/)
     case VBrush::Type::Solid:
         mType = VSpanData::Type::Solid;
         mSolid = brush.mColor.premulARGB();
+        if (swapsRB(this)) mSolid = swap_rb_pixel(mSolid);
         break;
     case VBrush::Type::LinearGradient: {
         mType = VSpanData::Type::LinearGradient;
@@ -688,6 +868,7 @@ void VSpanData::setup(const VBrush &brush, BlendMode /*mode*/, int /*alpha*/)
         mType = VSpanData::Type::Texture;
         initTexture(&brush.mTexture->mBitmap, brush.mTexture->mAlpha,
                     brush.mTexture->mBitmap.rect());
+        mTexture.setFilter(brush.mTexture->mFilter);
         setupMatrix(brush.mTexture->mMatrix);
         break;
     }
@@ -725,35 +906,82 @@ void VSpanData::initTexture(const VBitmap *bitmap, int alpha,
     mTexture.prepare(bitmap);
     mTexture.setClip(sourceRect);
     mTexture.setAlpha(alpha);
+    mTexture.setFilter(VTexture::Filter::Nearest);
     updateSpanFunc();
 }
 
 void VSpanData::updateSpanFunc()
 {
+    // coverage only surface, keeps just the alpha of the source.
+    const bool alpha8 = mRasterBuffer &&
+                        mRasterBuffer->format() == VBitmap::Format::Alpha8;
+    const bool swap = swapsRB(this);
+    // the modes whose color kernels give the pixels of their Src kernels
+    // for a solid source, the Src ones round the interpolation otherwise.
+    const bool exact = alpha8 ? mBlendMode == BlendMode::SrcOver
+                              : (mBlendMode == BlendMode::SrcOver ||
+                                 mBlendMode == BlendMode::DestIn ||
+                                 mBlendMode == BlendMode::DestOut);
+
     switch (mType) {
     case VSpanData::Type::None:
         mUnclippedBlendFunc = nullptr;
         break;
     case VSpanData::Type::Solid:
-        mUnclippedBlendFunc = &blend_color;
+        mUnclippedBlendFunc = alpha8 ? &blend_color_alpha8 : &blend_color;
         break;
     case VSpanData::Type::LinearGradient:
-    case VSpanData::Type::RadialGradient: {
-        mUnclippedBlendFunc = &blend_gradient;
+        if (exact && linearGradientIsSolid(this)) {
+            mUnclippedBlendFunc =
+                alpha8 ? &blend_linear_solid_alpha8 : &blend_linear_solid;
+        } else {
+            mUnclippedBlendFunc =
+                alpha8 ? &blend_gradient_alpha8<fetch_linear_gradient>
+                : swap ? &blend_gradient<fetch_swapped<fetch_linear_gradient>>
+                       : &blend_gradient<fetch_linear_gradient>;
+        }
+        break;
+    case VSpanData::Type::RadialGradient:
+        mUnclippedBlendFunc =
+            alpha8 ? &blend_gradient_alpha8<fetch_radial_gradient>
+            : swap ? &blend_gradient<fetch_swapped<fetch_radial_gradient>>
+                   : &blend_gradient<fetch_radial_gradient>;
         break;
-    }
     case VSpanData::Type::Texture: {
         //@TODO update proper image function.
         if (transformType <= VMatrix::MatrixType::Translate) {
-            mUnclippedBlendFunc = &blend_image;
+            mUnclippedBlendFunc = alpha8 ? &blend_image_alpha8 : &blend_image;
         } else {
-            mUnclippedBlendFunc = &blend_image_xform;
+            mUnclippedBlendFunc =
+                alpha8 ? &blend_image_xform_alpha8 : &blend_image_xform;
         }
         break;
     }
     }
 }
 
+void convertPixels(PixelFunc::Type type, uint32_t *dest, const uint32_t *src,
+                   int length)
+{
+    RenderTable.convert(type)(dest, src, length);
+}
+
+void convertToRgb565(uint16_t *dest, const uint32_t *src, int length)
+{
+    RenderTable.rgb565()(dest, src, length);
+}
+
+void convertToYuvLuma(uint8_t *dest, const uint32_t *src, int length)
+{
+    RenderTable.yuvLuma()(dest, src, length);
+}
+
+void convertToYuvChroma(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                        const uint32_t *row1, int length)
+{
+    RenderTable.yuvChroma()(u, v, row0, row1, length);
+}
+
 #if !defined(__SSE2__) && (!defined(__ARM_NEON__) || defined(LOTTIE_DISABLE_ARM_NEON))
 void memfill32(uint32_t *dest, uint32_t value, int length)
 {
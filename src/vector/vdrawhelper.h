@@ -24,6 +24,7 @@
 #define VDRAWHELPER_H
 
 #include <memory>
+#include <algorithm>
 #include <array>
 #include "assert.h"
 #include "vbitmap.h"
@@ -35,6 +36,9 @@ V_USE_NAMESPACE
 
 struct VSpanData;
 struct Operator;
+struct VGradientData;
+struct RadialGradientValues;
+struct VTextureData;
 
 struct RenderFunc
 {
@@ -56,10 +60,73 @@ struct RenderFunc
     };
 };
 
+// kernels for Alpha8 surfaces, either as the destination (Color, Src) or
+// as the source of a mask blend into an argb destination (Mask).
+struct Alpha8Func
+{
+    using Color = void (*)(uchar *dest, int length, uint32_t color, uint32_t alpha);
+    using Src   = void (*)(uchar *dest, int length, const uint32_t *src, uint32_t alpha);
+    using Mask  = void (*)(uint32_t *dest, int length, const uchar *src, uint32_t alpha);
+};
+
+// color table lookups of the gradient fetchers.
+struct GradientFunc
+{
+    // pixel i takes the entry at the fixed point position t + i * inc.
+    using Linear = void (*)(uint32_t *buffer, int length,
+                            const VGradientData *grad, int t, int inc);
+    // pixel i takes the entry at sqrt(det[i]) - b[i].
+    using Radial = void (*)(uint32_t *buffer, int length,
+                            const VGradientData *       grad,
+                            const RadialGradientValues *v, const float *det,
+                            const float *b);
+};
+
+// texture fetch of the transformed image blends.
+struct TextureFunc
+{
+    // pixel i samples the texture at ((x + i) * m11 + fx, (x + i) * m12 + fy).
+    using Fetch = void (*)(uint32_t *buffer, int length,
+                           const VTextureData *tex, int x, float fx, float fy,
+                           float m11, float m12);
+};
+
+// whole run pixel conversions, dest may be the same buffer as src.
+struct PixelFunc
+{
+    enum class Type {
+        Luma,           // premultiplied argb to its vLuma() in the alpha
+        Premultiply,    // argb to premultiplied argb
+        Unpremultiply,  // premultiplied argb to argb
+        SwapRB,         // rgba byte order to bgra and back
+        Last
+    };
+    using Convert = void (*)(uint32_t *dest, const uint32_t *src, int length);
+    // premultiplied argb to 16 bit 5-6-5 pixels, as if over black.
+    using Rgb565 = void (*)(uint16_t *dest, const uint32_t *src, int length);
+    // premultiplied argb to bt.601 video range luma, as if over black.
+    using YuvLuma = void (*)(uint8_t *dest, const uint32_t *src, int length);
+    // the chroma of each 2x2 block of two rows into the u and v planes, or
+    // as u, v pairs into u when v is null.
+    using YuvChroma = void (*)(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                               const uint32_t *row1, int length);
+};
+
+// avx2 kernels are built with a target attribute and chosen at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    !defined(LOTTIE_DISABLE_ARM_NEON)
+#define V_HAVE_AVX2
+#endif
+
 class RenderFuncTable
 {
 public:
-    RenderFuncTable();
+    // kernel sets, each level adds to the one below it.
+    enum class Simd { None, Baseline, Avx2 };
+
+    explicit RenderFuncTable(Simd simd = cpuSimd());
+    // best level the running cpu supports.
+    static Simd cpuSimd();
     RenderFunc::Color color(BlendMode mode) const
     {
         return colorTable[uint32_t(mode)].color_;
@@ -68,11 +135,39 @@ public:
     {
         return srcTable[uint32_t(mode)].src_;
     }
+    Alpha8Func::Color alpha8Color(BlendMode mode) const
+    {
+        return alpha8ColorTable[uint32_t(mode)];
+    }
+    Alpha8Func::Src   alpha8Src(BlendMode mode) const
+    {
+        return alpha8SrcTable[uint32_t(mode)];
+    }
+    Alpha8Func::Mask  mask(BlendMode mode) const
+    {
+        return maskTable[uint32_t(mode)];
+    }
+    GradientFunc::Linear gradientLinear() const { return linearGradient; }
+    GradientFunc::Radial gradientRadial() const { return radialGradient; }
+    TextureFunc::Fetch   texture(VTexture::Filter filter) const
+    {
+        return textureTable[uint32_t(filter)];
+    }
+    PixelFunc::Convert   convert(PixelFunc::Type type) const
+    {
+        return convertTable[uint32_t(type)];
+    }
+    PixelFunc::Rgb565    rgb565() const { return rgb565Func; }
+    PixelFunc::YuvLuma   yuvLuma() const { return yuvLumaFunc; }
+    PixelFunc::YuvChroma yuvChroma() const { return yuvChromaFunc; }
 private:
 #if !defined(LOTTIE_DISABLE_ARM_NEON)
     void neon();
     void sse();
 #endif // defined(LOTTIE_DISABLE_ARM_NEON)
+#if defined(V_HAVE_AVX2)
+    void avx2();
+#endif
     void updateColor(BlendMode mode, RenderFunc::Color f)
     {
         colorTable[uint32_t(mode)] = {RenderFunc::Type::Color, f};
@@ -81,9 +176,50 @@ private:
     {
         srcTable[uint32_t(mode)] = {RenderFunc::Type::Src, f};
     }
+    void updateAlpha8(BlendMode mode, Alpha8Func::Color color,
+                      Alpha8Func::Src src)
+    {
+        alpha8ColorTable[uint32_t(mode)] = color;
+        alpha8SrcTable[uint32_t(mode)] = src;
+    }
+    void updateMask(BlendMode mode, Alpha8Func::Mask f)
+    {
+        maskTable[uint32_t(mode)] = f;
+    }
+    void updateGradient(GradientFunc::Linear linear,
+                        GradientFunc::Radial radial)
+    {
+        linearGradient = linear;
+        radialGradient = radial;
+    }
+    void updateTexture(VTexture::Filter filter, TextureFunc::Fetch f)
+    {
+        textureTable[uint32_t(filter)] = f;
+    }
+    void updateConvert(PixelFunc::Type type, PixelFunc::Convert f)
+    {
+        convertTable[uint32_t(type)] = f;
+    }
+    void updateRgb565(PixelFunc::Rgb565 f) { rgb565Func = f; }
+    void updateYuv(PixelFunc::YuvLuma luma, PixelFunc::YuvChroma chroma)
+    {
+        yuvLumaFunc = luma;
+        yuvChromaFunc = chroma;
+    }
 private:
     std::array<RenderFunc, uint32_t(BlendMode::Last)> colorTable;
     std::array<RenderFunc, uint32_t(BlendMode::Last)> srcTable;
+    std::array<Alpha8Func::Color, uint32_t(BlendMode::Last)> alpha8ColorTable{};
+    std::array<Alpha8Func::Src, uint32_t(BlendMode::Last)>   alpha8SrcTable{};
+    std::array<Alpha8Func::Mask, uint32_t(BlendMode::Last)>  maskTable{};
+    GradientFunc::Linear linearGradient{nullptr};
+    GradientFunc::Radial radialGradient{nullptr};
+    std::array<TextureFunc::Fetch, 2> textureTable{};
+    std::array<PixelFunc::Convert, uint32_t(PixelFunc::Type::Last)>
+        convertTable{};
+    PixelFunc::Rgb565    rgb565Func{nullptr};
+    PixelFunc::YuvLuma   yuvLumaFunc{nullptr};
+    PixelFunc::YuvChroma yuvChromaFunc{nullptr};
 };
 
 typedef void (*SourceFetchProc)(uint32_t *buffer, const Operator *o,
@@ -93,6 +229,13 @@ typedef void (*ProcessRleSpan)(size_t count, const VRle::Span *spans,
                                void *userData);
 
 extern void memfill32(uint32_t *dest, uint32_t value, int count);
+// runs the conversion kernel the cpu supports best.
+extern void convertPixels(PixelFunc::Type type, uint32_t *dest,
+                          const uint32_t *src, int length);
+extern void convertToRgb565(uint16_t *dest, const uint32_t *src, int length);
+extern void convertToYuvLuma(uint8_t *dest, const uint32_t *src, int length);
+extern void convertToYuvChroma(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                               const uint32_t *row1, int length);
 
 struct LinearGradientValues {
     float dx;
@@ -113,9 +256,13 @@ struct RadialGradientValues {
 
 struct Operator {
     BlendMode                mode;
-    SourceFetchProc          srcFetch;
     RenderFunc::Color        funcSolid;
     RenderFunc::Src          func;
+    Alpha8Func::Color        funcAlpha8Solid;
+    Alpha8Func::Src          funcAlpha8;
+    Alpha8Func::Mask         funcMask;
+    // full coverage spans overwrite the destination with the source.
+    bool                     replace;
     union {
         LinearGradientValues linear;
         RadialGradientValues radial;
@@ -139,6 +286,10 @@ public:
     {
         return (uint32_t *)(mBuffer + y * mBytesPerLine + x * mBytesPerPixel);
     }
+    uchar *alphaRef(int x, int y) const
+    {
+        return mBuffer + y * mBytesPerLine + x * mBytesPerPixel;
+    }
 
     size_t          width() const { return mWidth; }
     size_t          height() const { return mHeight; }
@@ -171,18 +322,60 @@ struct VGradientData {
     bool            mColorTableAlpha;
 };
 
+#define FIXPT_BITS 8
+#define FIXPT_SIZE (1 << FIXPT_BITS)
+
+static inline int gradientClamp(const VGradientData *grad, int ipos)
+{
+    int limit;
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        ipos = ipos % VGradient::colorTableSize;
+        ipos = ipos < 0 ? VGradient::colorTableSize + ipos : ipos;
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        limit = VGradient::colorTableSize * 2;
+        ipos = ipos % limit;
+        ipos = ipos < 0 ? limit + ipos : ipos;
+        ipos = ipos >= VGradient::colorTableSize ? limit - 1 - ipos : ipos;
+    } else {
+        if (ipos < 0)
+            ipos = 0;
+        else if (ipos >= VGradient::colorTableSize)
+            ipos = VGradient::colorTableSize - 1;
+    }
+    return ipos;
+}
+
+static inline uint32_t gradientPixelFixed(const VGradientData *grad,
+                                          int                  fixed_pos)
+{
+    int ipos = (fixed_pos + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
+
+    return grad->mColorTable[gradientClamp(grad, ipos)];
+}
+
+static inline uint32_t gradientPixel(const VGradientData *grad, float pos)
+{
+    int ipos = (int)(pos * (VGradient::colorTableSize - 1) + (float)(0.5));
+
+    return grad->mColorTable[gradientClamp(grad, ipos)];
+}
+
 struct VTextureData : public VRasterBuffer {
-    uint32_t pixel(int x, int y) const { return *pixelRef(x, y); };
-    uchar    alpha() const { return mAlpha; }
-    void     setAlpha(uchar alpha) { mAlpha = alpha; }
-    void     setClip(const VRect &clip);
+    uint32_t         pixel(int x, int y) const { return *pixelRef(x, y); };
+    uchar            alpha() const { return mAlpha; }
+    void             setAlpha(uchar alpha) { mAlpha = alpha; }
+    void             setClip(const VRect &clip);
+    VTexture::Filter filter() const { return mFilter; }
+    void             setFilter(VTexture::Filter filter) { mFilter = filter; }
     // clip rect
-    int   left;
-    int   right;
-    int   top;
-    int   bottom;
-    bool  hasAlpha;
-    uchar mAlpha;
+    int              left;
+    int              right;
+    int              top;
+    int              bottom;
+    bool             hasAlpha;
+    uchar            mAlpha;
+    VTexture::Filter mFilter{VTexture::Filter::Nearest};
 };
 
 struct VColorTable {
@@ -199,31 +392,41 @@ struct VSpanData {
                int alpha = 255);
     void setupMatrix(const VMatrix &matrix);
 
-    VRect clipRect() const
-    {
-        return VRect(0, 0, mDrawableSize.width(), mDrawableSize.height());
-    }
+    VRect clipRect() const { return VRect(mOrigin, mDrawableSize); }
 
     void setDrawRegion(const VRect &region)
     {
         mOffset = VPoint(region.left(), region.top());
+        mOrigin = VPoint();
         mDrawableSize = VSize(region.width(), region.height());
     }
 
+    // the buffer holds the part of the canvas that starts at origin.
+    void setDrawOrigin(const VPoint &origin)
+    {
+        mOffset = VPoint(-origin.x(), -origin.y());
+        mOrigin = origin;
+    }
+
     uint *buffer(int x, int y) const
     {
         return mRasterBuffer->pixelRef(x + mOffset.x(), y + mOffset.y());
     }
+    uchar *alphaBuffer(int x, int y) const
+    {
+        return mRasterBuffer->alphaRef(x + mOffset.x(), y + mOffset.y());
+    }
     void initTexture(const VBitmap *image, int alpha, const VRect &sourceRect);
     const VTextureData &texture() const { return mTexture; }
 
     BlendMode                          mBlendMode{BlendMode::SrcOver};
-    VRasterBuffer *                    mRasterBuffer;
+    VRasterBuffer *                    mRasterBuffer{nullptr};
     ProcessRleSpan                     mBlendFunc;
     ProcessRleSpan                     mUnclippedBlendFunc;
     VSpanData::Type                    mType;
     std::shared_ptr<const VColorTable> mColorTable{nullptr};
     VPoint                             mOffset;  // offset to the subsurface
+    VPoint                             mOrigin;  // canvas origin of the buffer
     VSize                              mDrawableSize;  // suburface size
     uint32_t                           mSolid;
     VGradientData                      mGradient;
@@ -258,6 +461,26 @@ inline constexpr int vAlpha(uint32_t c)
     return c >> 24;
 }
 
+// luminosity of a premultiplied pixel, transparent pixels have none.
+inline int vLuma(uint32_t c)
+{
+    int alpha = vAlpha(c);
+    if (alpha == 0) return 0;
+
+    int red = vRed(c);
+    int green = vGreen(c);
+    int blue = vBlue(c);
+
+    if (alpha != 255) {
+        // un multiply
+        red = (red * 255) / alpha;
+        green = (green * 255) / alpha;
+        blue = (blue * 255) / alpha;
+    }
+    int luma = int(0.299f * red + 0.587f * green + 0.114f * blue);
+    return luma > 255 ? 255 : luma;
+}
+
 static inline uint32_t interpolate_pixel(uint x, uint a, uint y, uint b)
 {
     uint t = (x & 0xff00ff) * a + (y & 0xff00ff) * b;
@@ -269,4 +492,76 @@ static inline uint32_t interpolate_pixel(uint x, uint a, uint y, uint b)
     return x;
 }
 
+// a * (256 - w) + b * w in 1/256 steps, w is at most 255.
+static inline uint32_t lerp_pixel(uint32_t a, uint32_t b, uint32_t w)
+{
+    uint iw = 256 - w;
+    uint t = ((a & 0xff00ff) * iw + (b & 0xff00ff) * w) >> 8;
+    uint x = ((a >> 8) & 0xff00ff) * iw + ((b >> 8) & 0xff00ff) * w;
+    return (x & 0xff00ff00) | (t & 0xff00ff);
+}
+
+// c * a / 255 of each color channel.
+static inline uint32_t premultiply_pixel(uint32_t c)
+{
+    uint a = vAlpha(c);
+    return (a << 24) | ((vRed(c) * a / 255) << 16) |
+           ((vGreen(c) * a / 255) << 8) | (vBlue(c) * a / 255);
+}
+
+// c * 255 / a of each color channel, saturated to 255.
+static inline uint32_t unpremultiply_pixel(uint32_t c)
+{
+    uint a = vAlpha(c);
+    if (a == 0) return 0;
+    uint r = std::min(vRed(c) * 255 / a, 255u);
+    uint g = std::min(vGreen(c) * 255 / a, 255u);
+    uint b = std::min(vBlue(c) * 255 / a, 255u);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static inline uint32_t swap_rb_pixel(uint32_t c)
+{
+    return (c & 0xff00ff00) | ((c >> 16) & 0xff) | ((c & 0xff) << 16);
+}
+
+// the high bits of each color channel, the alpha is dropped.
+static inline uint16_t rgb565_pixel(uint32_t c)
+{
+    return uint16_t(((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) |
+                    ((c >> 3) & 0x001f));
+}
+
+// bt.601 video range luma of a pixel over black.
+static inline uint8_t yuv_luma_pixel(uint32_t c)
+{
+    return uint8_t((66 * vRed(c) + 129 * vGreen(c) + 25 * vBlue(c) + 0x1080) >>
+                   8);
+}
+
+// the u and v of the rounded average of a 2x2 block from pixel x on, the
+// last pixel of an odd length is paired with itself.
+static inline void yuv_chroma_block(uint8_t *u, uint8_t *v,
+                                    const uint32_t *row0,
+                                    const uint32_t *row1, int x, int length)
+{
+    int next = std::min(x + 1, length - 1);
+    int r = (vRed(row0[x]) + vRed(row0[next]) + vRed(row1[x]) +
+             vRed(row1[next]) + 2) >> 2;
+    int g = (vGreen(row0[x]) + vGreen(row0[next]) + vGreen(row1[x]) +
+             vGreen(row1[next]) + 2) >> 2;
+    int b = (vBlue(row0[x]) + vBlue(row0[next]) + vBlue(row1[x]) +
+             vBlue(row1[next]) + 2) >> 2;
+    // never negative, the offset outweighs the negative terms.
+    auto cu = uint8_t((112 * b - 74 * g - 38 * r + 0x8080) >> 8);
+    auto cv = uint8_t((112 * r - 94 * g - 18 * b + 0x8080) >> 8);
+    if (v) {
+        u[x / 2] = cu;
+        v[x / 2] = cv;
+    } else {
+        u[x] = cu;
+        u[x + 1] = cv;
+    }
+}
+
 #endif  // QDRAWHELPER_P_H
@@ -0,0 +1,974 @@
+#include "vdrawhelper.h"
+
+#if defined(V_HAVE_AVX2)
+
+#include <immintrin.h>
+#include <cstring>
+
+/*
+ * The kernels are built for avx2 through the target attribute, so the rest
+ * of the library keeps the baseline flags. RenderFuncTable only installs
+ * them when the cpu supports avx2, on top of the sse2 ones. Each kernel
+ * gives the same pixels as the one it replaces, bit for bit.
+ */
+#define V_AVX2 __attribute__((target("avx2")))
+
+// the factor of each pixel in both 16 bit halves, 0x00AA00AA.
+V_AVX2 static inline __m256i v8_spread(__m256i a)
+{
+    return _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+}
+
+V_AVX2 static inline __m256i v8_alpha(__m256i c)
+{
+    return _mm256_srli_epi32(c, 24);
+}
+
+// BYTE_MUL() of 8 pixels, a holds the factors as 0x00AA00AA.
+V_AVX2 static inline __m256i v8_byte_mul(__m256i c, __m256i a)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+
+    __m256i ag = _mm256_mullo_epi16(_mm256_srli_epi16(c, 8), a);
+    __m256i rb = _mm256_mullo_epi16(_mm256_and_si256(c, rb_mask), a);
+    return _mm256_or_si256(_mm256_and_si256(ag, ag_mask),
+                           _mm256_srli_epi16(rb, 8));
+}
+
+// x * a + y * (255 - a) of 8 pixels, rounded as v4_interpolate_color_sse2()
+// so the output does not change from the sse2 kernel.
+V_AVX2 static inline __m256i v8_interpolate(__m256i a, __m256i x, __m256i y)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+
+    __m256i y_rb = _mm256_and_si256(y, rb_mask);
+    __m256i y_ag = _mm256_srli_epi16(y, 8);
+    __m256i rb = _mm256_sub_epi16(_mm256_and_si256(x, rb_mask), y_rb);
+    __m256i ag = _mm256_sub_epi16(_mm256_srli_epi16(x, 8), y_ag);
+    rb = _mm256_add_epi16(_mm256_mullo_epi16(rb, a),
+                          _mm256_slli_epi16(y_rb, 8));
+    ag = _mm256_add_epi16(_mm256_mullo_epi16(ag, a),
+                          _mm256_slli_epi16(y_ag, 8));
+    return _mm256_or_si256(_mm256_and_si256(ag, ag_mask),
+                           _mm256_srli_epi16(rb, 8));
+}
+
+// (v * alpha >> 8) + cia of values up to 255, as the scalar code scales a
+// factor by the const alpha.
+V_AVX2 static inline __m256i v8_scale(__m256i v, __m256i alpha, __m256i cia)
+{
+    return _mm256_add_epi32(_mm256_srli_epi32(_mm256_mullo_epi16(v, alpha), 8),
+                            cia);
+}
+
+// vLuma() of 8 pixels, the float math runs in the same order.
+V_AVX2 static inline __m256i v8_luma(__m256i c)
+{
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+
+    __m256i a = v8_alpha(c);
+    __m256  fa = _mm256_cvtepi32_ps(a);
+    __m256  fr = _mm256_cvtepi32_ps(_mm256_mullo_epi16(
+        _mm256_and_si256(_mm256_srli_epi32(c, 16), byte_mask),
+        _mm256_set1_epi32(255)));
+    __m256  fg = _mm256_cvtepi32_ps(_mm256_mullo_epi16(
+        _mm256_and_si256(_mm256_srli_epi32(c, 8), byte_mask),
+        _mm256_set1_epi32(255)));
+    __m256  fb = _mm256_cvtepi32_ps(_mm256_mullo_epi16(
+        _mm256_and_si256(c, byte_mask), _mm256_set1_epi32(255)));
+
+    // the quotients stay far enough from the next integer for the
+    // truncated float division to match the integer one.
+    fr = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(fr, fa)));
+    fg = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(fg, fa)));
+    fb = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_div_ps(fb, fa)));
+
+    __m256 l = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.299f), fr),
+                      _mm256_mul_ps(_mm256_set1_ps(0.587f), fg)),
+        _mm256_mul_ps(_mm256_set1_ps(0.114f), fb));
+    __m256i luma = _mm256_min_epi32(_mm256_cvttps_epi32(l), byte_mask);
+
+    // transparent pixels have none.
+    __m256i clear = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+    return _mm256_andnot_si256(clear, luma);
+}
+
+// dest = color + dest * ialpha
+V_AVX2 static void color_helper(uint32_t *dest, int length, uint32_t color,
+                                uint32_t ialpha)
+{
+    const __m256i v_color = _mm256_set1_epi32(int(color));
+    const __m256i v_ia = _mm256_set1_epi16(short(ialpha));
+
+    for (; length >= 8; length -= 8, dest += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)dest);
+        d = _mm256_add_epi32(v8_byte_mul(d, v_ia), v_color);
+        _mm256_storeu_si256((__m256i *)dest, d);
+    }
+    for (int i = 0; i < length; ++i)
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+}
+
+V_AVX2 static void color_Source(uint32_t *dest, int length, uint32_t color,
+                                uint32_t alpha)
+{
+    if (alpha == 255) {
+        memfill32(dest, color, length);
+    } else {
+        color_helper(dest, length, BYTE_MUL(color, alpha), 255 - alpha);
+    }
+}
+
+V_AVX2 static void color_SourceOver(uint32_t *dest, int length,
+                                    uint32_t color, uint32_t alpha)
+{
+    if (alpha != 255) color = BYTE_MUL(color, alpha);
+    color_helper(dest, length, color, 255 - vAlpha(color));
+}
+
+V_AVX2 static void color_DestinationIn(uint *dest, int length, uint color,
+                                       uint alpha)
+{
+    uint a = vAlpha(color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    color_helper(dest, length, 0, a);
+}
+
+V_AVX2 static void color_DestinationOut(uint *dest, int length, uint color,
+                                        uint alpha)
+{
+    uint a = vAlpha(~color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    color_helper(dest, length, 0, a);
+}
+
+V_AVX2 static void color_DestinationInLuma(uint *dest, int length, uint color,
+                                           uint alpha)
+{
+    uint a = vLuma(color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    color_helper(dest, length, 0, a);
+}
+
+V_AVX2 static void color_DestinationOutLuma(uint *dest, int length,
+                                            uint color, uint alpha)
+{
+    uint a = 255 - vLuma(color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    color_helper(dest, length, 0, a);
+}
+
+V_AVX2 static void src_Source(uint32_t *dest, int length, const uint32_t *src,
+                              uint32_t alpha)
+{
+    if (alpha == 255) {
+        memcpy(dest, src, size_t(length) * sizeof(uint));
+        return;
+    }
+
+    // the sse2 kernel blends the pixels before the first 16 byte boundary
+    // and the last 1-3 ones in scalar code, the same split keeps the output.
+    uint ialpha = 255 - alpha;
+    while (length && (uintptr_t(dest) & 0xF)) {
+        *dest = interpolate_pixel(*src++, alpha, *dest, ialpha);
+        dest++;
+        length--;
+    }
+
+    const __m256i v_a = _mm256_set1_epi16(short(alpha));
+    for (; length >= 8; length -= 8, dest += 8, src += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)src);
+        __m256i d = _mm256_loadu_si256((const __m256i *)dest);
+        _mm256_storeu_si256((__m256i *)dest, v8_interpolate(v_a, s, d));
+    }
+    if (length >= 4) {
+        __m128i s4 = _mm_loadu_si128((const __m128i *)src);
+        __m128i d4 = _mm_load_si128((const __m128i *)dest);
+        __m256i s = _mm256_castsi128_si256(s4);
+        __m256i d = _mm256_castsi128_si256(d4);
+        _mm_store_si128((__m128i *)dest,
+                        _mm256_castsi256_si128(v8_interpolate(v_a, s, d)));
+        dest += 4;
+        src += 4;
+        length -= 4;
+    }
+    for (int i = 0; i < length; ++i)
+        dest[i] = interpolate_pixel(src[i], alpha, dest[i], ialpha);
+}
+
+V_AVX2 static void src_SourceOver(uint32_t *dest, int length,
+                                  const uint32_t *src, uint32_t alpha)
+{
+    const __m256i full = _mm256_set1_epi32(0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i v_a = _mm256_set1_epi16(short(alpha));
+    int           i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dest + i));
+        if (alpha != 255) s = v8_byte_mul(s, v_a);
+        __m256i sia = v8_spread(_mm256_sub_epi32(full, v8_alpha(s)));
+        __m256i r = _mm256_add_epi32(s, v8_byte_mul(d, sia));
+        // a transparent source leaves the pixel untouched.
+        if (alpha == 255)
+            r = _mm256_blendv_epi8(r, d, _mm256_cmpeq_epi32(s, zero));
+        _mm256_storeu_si256((__m256i *)(dest + i), r);
+    }
+    for (; i < length; ++i) {
+        uint s = src[i];
+        if (alpha != 255)
+            s = BYTE_MUL(s, alpha);
+        else if (s == 0)
+            continue;
+        dest[i] = s + BYTE_MUL(dest[i], vAlpha(~s));
+    }
+}
+
+// the factor the DestinationIn/Out kernels take from the source.
+enum class Factor { Alpha, InvAlpha, Luma, InvLuma };
+
+template <Factor F>
+V_AVX2 static inline __m256i v8_factor(__m256i s)
+{
+    const __m256i full = _mm256_set1_epi32(0xFF);
+
+    switch (F) {
+    case Factor::Alpha:
+        return v8_alpha(s);
+    case Factor::InvAlpha:
+        return _mm256_sub_epi32(full, v8_alpha(s));
+    case Factor::Luma:
+        return v8_luma(s);
+    case Factor::InvLuma:
+        return _mm256_sub_epi32(full, v8_luma(s));
+    }
+    return full;
+}
+
+// dest = dest * f(src)
+template <Factor F>
+V_AVX2 static inline void src_scale(uint *dest, int length, const uint *src,
+                                    uint alpha)
+{
+    const __m256i v_a = _mm256_set1_epi32(int(alpha));
+    const __m256i v_cia = _mm256_set1_epi32(int(255 - alpha));
+    int           i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dest + i));
+        __m256i a = v8_factor<F>(s);
+        if (alpha != 255) a = v8_scale(a, v_a, v_cia);
+        d = v8_byte_mul(d, v8_spread(a));
+        _mm256_storeu_si256((__m256i *)(dest + i), d);
+    }
+    if (i == length) return;
+
+    // the tail goes through the same vector math in a padded block.
+    uint s[8] = {}, d[8] = {};
+    memcpy(s, src + i, size_t(length - i) * sizeof(uint));
+    memcpy(d, dest + i, size_t(length - i) * sizeof(uint));
+    src_scale<F>(d, 8, s, alpha);
+    memcpy(dest + i, d, size_t(length - i) * sizeof(uint));
+}
+
+V_AVX2 static void src_DestinationIn(uint *dest, int length, const uint *src,
+                                     uint alpha)
+{
+    src_scale<Factor::Alpha>(dest, length, src, alpha);
+}
+
+V_AVX2 static void src_DestinationOut(uint *dest, int length, const uint *src,
+                                      uint alpha)
+{
+    src_scale<Factor::InvAlpha>(dest, length, src, alpha);
+}
+
+V_AVX2 static void src_DestinationInLuma(uint *dest, int length,
+                                         const uint *src, uint alpha)
+{
+    src_scale<Factor::Luma>(dest, length, src, alpha);
+}
+
+V_AVX2 static void src_DestinationOutLuma(uint *dest, int length,
+                                          const uint *src, uint alpha)
+{
+    src_scale<Factor::InvLuma>(dest, length, src, alpha);
+}
+
+/*
+ * Alpha8 destination, 16 bit math on 32 pixels per round.
+ */
+
+// dest = a + (dest * ialpha >> 8)
+V_AVX2 static void alpha8_helper(uchar *dest, int length, uint a, uint ialpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i v_a = _mm256_set1_epi16(short(a));
+    const __m256i v_ia = _mm256_set1_epi16(short(ialpha));
+
+    for (; length >= 32; length -= 32, dest += 32) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)dest);
+        __m256i lo = _mm256_unpacklo_epi8(d, zero);
+        __m256i hi = _mm256_unpackhi_epi8(d, zero);
+        lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, v_ia), 8);
+        hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, v_ia), 8);
+        lo = _mm256_add_epi16(lo, v_a);
+        hi = _mm256_add_epi16(hi, v_a);
+        _mm256_storeu_si256((__m256i *)dest, _mm256_packus_epi16(lo, hi));
+    }
+    for (int i = 0; i < length; ++i)
+        dest[i] = uchar(a + ((dest[i] * ialpha) >> 8));
+}
+
+V_AVX2 static void color_Source_alpha8(uchar *dest, int length, uint32_t color,
+                                       uint32_t alpha)
+{
+    uint a = vAlpha(color);
+
+    if (alpha == 255) {
+        memset(dest, int(a), size_t(length));
+    } else {
+        alpha8_helper(dest, length, (a * alpha) >> 8, 255 - alpha);
+    }
+}
+
+V_AVX2 static void color_SourceOver_alpha8(uchar *dest, int length,
+                                           uint32_t color, uint32_t alpha)
+{
+    uint a = vAlpha(color);
+
+    if (alpha != 255) a = (a * alpha) >> 8;
+    alpha8_helper(dest, length, a, 255 - a);
+}
+
+// the 16 bit values of two 8 pixel blocks, in order.
+V_AVX2 static inline __m256i v16_pack32(__m256i a, __m256i b)
+{
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+}
+
+// 16 bytes of 16 bit values up to 255, in order.
+V_AVX2 static inline __m128i v16_pack16(__m256i v)
+{
+    __m256i p = _mm256_packus_epi16(v, v);
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(p, 0x08));
+}
+
+V_AVX2 static void src_Source_alpha8(uchar *dest, int length,
+                                     const uint32_t *src, uint32_t alpha)
+{
+    const __m256i v_a = _mm256_set1_epi16(short(alpha));
+    const __m256i v_ia = _mm256_set1_epi16(short(255 - alpha));
+    int           i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i sa = v16_pack32(v8_alpha(s0), v8_alpha(s1));
+        if (alpha != 255) {
+            __m256i d = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i *)(dest + i)));
+            sa = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(sa, v_a),
+                                 _mm256_mullo_epi16(d, v_ia)),
+                8);
+        }
+        _mm_storeu_si128((__m128i *)(dest + i), v16_pack16(sa));
+    }
+    uint ialpha = 255 - alpha;
+    for (; i < length; ++i) {
+        if (alpha == 255)
+            dest[i] = uchar(vAlpha(src[i]));
+        else
+            dest[i] = uchar((vAlpha(src[i]) * alpha + dest[i] * ialpha) >> 8);
+    }
+}
+
+V_AVX2 static void src_SourceOver_alpha8(uchar *dest, int length,
+                                         const uint32_t *src, uint32_t alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(0xFF);
+    const __m256i v_a = _mm256_set1_epi16(short(alpha));
+    int           i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i d = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(dest + i)));
+        __m256i sa = v16_pack32(v8_alpha(s0), v8_alpha(s1));
+        if (alpha != 255)
+            sa = _mm256_srli_epi16(_mm256_mullo_epi16(sa, v_a), 8);
+        __m256i r = _mm256_add_epi16(
+            sa, _mm256_srli_epi16(
+                    _mm256_mullo_epi16(d, _mm256_sub_epi16(full, sa)), 8));
+        // a transparent source leaves the pixel untouched.
+        if (alpha == 255) {
+            __m256i clear = v16_pack32(_mm256_cmpeq_epi32(s0, zero),
+                                       _mm256_cmpeq_epi32(s1, zero));
+            r = _mm256_blendv_epi8(r, d, clear);
+        }
+        _mm_storeu_si128((__m128i *)(dest + i), v16_pack16(r));
+    }
+    for (; i < length; ++i) {
+        uint sa;
+        if (alpha == 255) {
+            if (src[i] == 0) continue;
+            sa = vAlpha(src[i]);
+        } else {
+            sa = (vAlpha(src[i]) * alpha) >> 8;
+        }
+        dest[i] = uchar(sa + ((dest[i] * (255 - sa)) >> 8));
+    }
+}
+
+/*
+ * Alpha8 source used as a mask.
+ */
+template <bool Invert>
+V_AVX2 static inline void mask_scale(uint *dest, int length, const uchar *src,
+                                     uint alpha)
+{
+    const __m256i full = _mm256_set1_epi32(0xFF);
+    const __m256i v_a = _mm256_set1_epi32(int(alpha));
+    const __m256i v_cia = _mm256_set1_epi32(int(255 - alpha));
+    int           i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256i a = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)(src + i)));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dest + i));
+        if (Invert) a = _mm256_sub_epi32(full, a);
+        if (alpha != 255) a = v8_scale(a, v_a, v_cia);
+        d = v8_byte_mul(d, v8_spread(a));
+        _mm256_storeu_si256((__m256i *)(dest + i), d);
+    }
+    for (; i < length; ++i) {
+        uint a = Invert ? 255 - src[i] : src[i];
+        if (alpha != 255) a = ((a * alpha) >> 8) + 255 - alpha;
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+V_AVX2 static void mask_DestinationIn(uint *dest, int length, const uchar *src,
+                                      uint alpha)
+{
+    mask_scale<false>(dest, length, src, alpha);
+}
+
+V_AVX2 static void mask_DestinationOut(uint *dest, int length,
+                                       const uchar *src, uint alpha)
+{
+    mask_scale<true>(dest, length, src, alpha);
+}
+
+/*
+ * Gradient color table lookups, 8 positions per round.
+ */
+
+// table indices, the same as gradientClamp().
+V_AVX2 static inline __m256i v8_gradient_clamp(const VGradientData *grad,
+                                               __m256i              ipos)
+{
+    const __m256i last = _mm256_set1_epi32(VGradient::colorTableSize - 1);
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        return _mm256_and_si256(ipos, last);
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        // the second half of each period runs backwards.
+        const __m256i limit =
+            _mm256_set1_epi32(VGradient::colorTableSize * 2 - 1);
+        ipos = _mm256_and_si256(ipos, limit);
+        __m256i back = _mm256_cmpgt_epi32(ipos, last);
+        return _mm256_xor_si256(ipos, _mm256_and_si256(back, limit));
+    } else {
+        ipos = _mm256_max_epi32(ipos, _mm256_setzero_si256());
+        return _mm256_min_epi32(ipos, last);
+    }
+}
+
+V_AVX2 static inline __m256i v8_gradient_fetch(const VGradientData *grad,
+                                               __m256i              index)
+{
+    return _mm256_i32gather_epi32((const int *)grad->mColorTable, index, 4);
+}
+
+V_AVX2 static void gradient_Linear(uint32_t *buffer, int length,
+                                   const VGradientData *grad, int t, int inc)
+{
+    const __m256i v_inc = _mm256_set1_epi32(8 * inc);
+    const __m256i v_half = _mm256_set1_epi32(FIXPT_SIZE / 2);
+    __m256i       v_t = _mm256_add_epi32(
+        _mm256_set1_epi32(t),
+        _mm256_mullo_epi32(_mm256_set1_epi32(inc),
+                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+
+    for (; length >= 8; length -= 8, buffer += 8) {
+        __m256i ipos =
+            _mm256_srai_epi32(_mm256_add_epi32(v_t, v_half), FIXPT_BITS);
+        ipos = v8_gradient_clamp(grad, ipos);
+        _mm256_storeu_si256((__m256i *)buffer, v8_gradient_fetch(grad, ipos));
+        v_t = _mm256_add_epi32(v_t, v_inc);
+    }
+
+    t = _mm256_cvtsi256_si32(v_t);
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = gradientPixelFixed(grad, t);
+        t += inc;
+    }
+}
+
+V_AVX2 static void gradient_Radial(uint32_t *buffer, int length,
+                                   const VGradientData *       grad,
+                                   const RadialGradientValues *v,
+                                   const float *det, const float *b)
+{
+    const __m256 v_scale = _mm256_set1_ps(VGradient::colorTableSize - 1);
+    const __m256 v_half = _mm256_set1_ps(0.5f);
+    const __m256 v_fr = _mm256_set1_ps(grad->radial.fradius);
+    const __m256 v_dr = _mm256_set1_ps(v->dr);
+    const __m256 zero = _mm256_setzero_ps();
+    int          i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        __m256  d = _mm256_loadu_ps(det + i);
+        __m256  w = _mm256_sub_ps(_mm256_sqrt_ps(d), _mm256_loadu_ps(b + i));
+        __m256i ipos = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(w, v_scale), v_half));
+        __m256i c = v8_gradient_fetch(grad, v8_gradient_clamp(grad, ipos));
+        if (v->extended) {
+            // no color where there is no circle for the position.
+            __m256 r = _mm256_add_ps(v_fr, _mm256_mul_ps(v_dr, w));
+            __m256 keep = _mm256_and_ps(_mm256_cmp_ps(d, zero, _CMP_GE_OQ),
+                                        _mm256_cmp_ps(r, zero, _CMP_GE_OQ));
+            c = _mm256_and_si256(c, _mm256_castps_si256(keep));
+        }
+        _mm256_storeu_si256((__m256i *)(buffer + i), c);
+    }
+    if (i == length) return;
+
+    // the tail goes through the same vector math in a padded block.
+    float    d[8] = {}, bb[8] = {};
+    uint32_t c[8];
+    memcpy(d, det + i, size_t(length - i) * sizeof(float));
+    memcpy(bb, b + i, size_t(length - i) * sizeof(float));
+    gradient_Radial(c, 8, grad, v, d, bb);
+    memcpy(buffer + i, c, size_t(length - i) * sizeof(uint32_t));
+}
+
+/*
+ * Transformed image fetch, 8 samples per round gathered from the texture.
+ */
+
+V_AVX2 static inline __m256i v8_clamp(__m256i v, __m256i lo, __m256i hi)
+{
+    return _mm256_max_epi32(_mm256_min_epi32(v, hi), lo);
+}
+
+V_AVX2 static inline __m256i v8_texels(const uchar *base, __m256i offset)
+{
+    return _mm256_i32gather_epi32((const int *)base, offset, 1);
+}
+
+V_AVX2 static void texture_Nearest(uint32_t *buffer, int length,
+                                   const VTextureData *tex, int x, float fx,
+                                   float fy, float m11, float m12)
+{
+    const __m256i left = _mm256_set1_epi32(tex->left);
+    const __m256i right = _mm256_set1_epi32(tex->right);
+    const __m256i top = _mm256_set1_epi32(tex->top);
+    const __m256i bottom = _mm256_set1_epi32(tex->bottom);
+    const __m256i stride = _mm256_set1_epi32(int(tex->bytesPerLine()));
+    const __m256  v_fx = _mm256_set1_ps(fx);
+    const __m256  v_fy = _mm256_set1_ps(fy);
+    const __m256  v_m11 = _mm256_set1_ps(m11);
+    const __m256  v_m12 = _mm256_set1_ps(m12);
+    const uchar * base = (const uchar *)tex->pixelRef(0, 0);
+    __m256i       pos = _mm256_add_epi32(_mm256_set1_epi32(x),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    for (; length >= 8; length -= 8, buffer += 8) {
+        __m256  p = _mm256_cvtepi32_ps(pos);
+        __m256i px = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(p, v_m11), v_fx));
+        __m256i py = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(p, v_m12), v_fy));
+        px = v8_clamp(px, left, right);
+        py = v8_clamp(py, top, bottom);
+        __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(py, stride),
+                                          _mm256_slli_epi32(px, 2));
+        _mm256_storeu_si256((__m256i *)buffer, v8_texels(base, offset));
+        pos = _mm256_add_epi32(pos, _mm256_set1_epi32(8));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[8];
+    texture_Nearest(c, 8, tex, _mm256_cvtsi256_si32(pos), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+// texel pairs around 8 positions and the weights of the second ones, the
+// same as bilinearTexels().
+V_AVX2 static inline void v8_bilinear_texels(__m256 u, int lo, int hi,
+                                             __m256i &t0, __m256i &t1,
+                                             __m256i &w)
+{
+    const __m256i v_lo = _mm256_set1_epi32(lo);
+    const __m256i v_hi = _mm256_set1_epi32(hi);
+
+    u = _mm256_max_ps(_mm256_min_ps(u, _mm256_set1_ps(float(hi + 1))),
+                      _mm256_set1_ps(float(lo - 1)));
+    __m256i p = _mm256_cvttps_epi32(u);
+    // truncation rounds negative positions up.
+    __m256 up = _mm256_cmp_ps(_mm256_cvtepi32_ps(p), u, _CMP_GT_OQ);
+    p = _mm256_add_epi32(p, _mm256_castps_si256(up));
+    __m256 frac = _mm256_sub_ps(u, _mm256_cvtepi32_ps(p));
+    w = _mm256_cvttps_epi32(_mm256_mul_ps(frac, _mm256_set1_ps(256)));
+    w = v8_spread(w);
+    t0 = v8_clamp(p, v_lo, v_hi);
+    t1 = v8_clamp(_mm256_add_epi32(p, _mm256_set1_epi32(1)), v_lo, v_hi);
+}
+
+// lerp_pixel() of 8 pixels, w holds the weights as 0x00WW00WW.
+V_AVX2 static inline __m256i v8_lerp(__m256i a, __m256i b, __m256i w)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+    const __m256i iw = _mm256_sub_epi16(_mm256_set1_epi16(256), w);
+
+    __m256i rb = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_and_si256(a, rb_mask), iw),
+        _mm256_mullo_epi16(_mm256_and_si256(b, rb_mask), w));
+    __m256i ag = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_srli_epi16(a, 8), iw),
+        _mm256_mullo_epi16(_mm256_srli_epi16(b, 8), w));
+    return _mm256_or_si256(_mm256_and_si256(ag, ag_mask),
+                           _mm256_srli_epi16(rb, 8));
+}
+
+V_AVX2 static void texture_Bilinear(uint32_t *buffer, int length,
+                                    const VTextureData *tex, int x, float fx,
+                                    float fy, float m11, float m12)
+{
+    const __m256i stride = _mm256_set1_epi32(int(tex->bytesPerLine()));
+    const __m256  v_fx = _mm256_set1_ps(fx);
+    const __m256  v_fy = _mm256_set1_ps(fy);
+    const __m256  v_m11 = _mm256_set1_ps(m11);
+    const __m256  v_m12 = _mm256_set1_ps(m12);
+    const uchar * base = (const uchar *)tex->pixelRef(0, 0);
+    __m256i       pos = _mm256_add_epi32(_mm256_set1_epi32(x),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i       x0, x1, y0, y1, wx, wy;
+
+    // a scale only matrix keeps the rows of the whole span.
+    const bool scaleOnly = (m12 == 0);
+    if (scaleOnly) {
+        v8_bilinear_texels(v_fy, tex->top, tex->bottom, y0, y1, wy);
+        y0 = _mm256_mullo_epi32(y0, stride);
+        y1 = _mm256_mullo_epi32(y1, stride);
+    }
+
+    for (; length >= 8; length -= 8, buffer += 8) {
+        __m256 p = _mm256_cvtepi32_ps(pos);
+        v8_bilinear_texels(_mm256_add_ps(_mm256_mul_ps(p, v_m11), v_fx),
+                           tex->left, tex->right, x0, x1, wx);
+        if (!scaleOnly) {
+            v8_bilinear_texels(_mm256_add_ps(_mm256_mul_ps(p, v_m12), v_fy),
+                               tex->top, tex->bottom, y0, y1, wy);
+            y0 = _mm256_mullo_epi32(y0, stride);
+            y1 = _mm256_mullo_epi32(y1, stride);
+        }
+        __m256i c0 = _mm256_slli_epi32(x0, 2);
+        __m256i c1 = _mm256_slli_epi32(x1, 2);
+
+        __m256i t = v8_lerp(v8_texels(base, _mm256_add_epi32(y0, c0)),
+                            v8_texels(base, _mm256_add_epi32(y0, c1)), wx);
+        __m256i b = v8_lerp(v8_texels(base, _mm256_add_epi32(y1, c0)),
+                            v8_texels(base, _mm256_add_epi32(y1, c1)), wx);
+        _mm256_storeu_si256((__m256i *)buffer, v8_lerp(t, b, wy));
+        pos = _mm256_add_epi32(pos, _mm256_set1_epi32(8));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[8];
+    texture_Bilinear(c, 8, tex, _mm256_cvtsi256_si32(pos), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+V_AVX2 static void convert_Luma(uint32_t *dest, const uint32_t *src,
+                                 int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)src);
+        _mm256_storeu_si256((__m256i *)dest,
+                            _mm256_slli_epi32(v8_luma(c), 24));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = uint32_t(vLuma(src[i])) << 24;
+}
+
+// exact x / 255 of 16 bit products of two bytes.
+V_AVX2 static inline __m256i v8_div255(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_add_epi16(_mm256_srli_epi16(x, 8),
+                                             _mm256_set1_epi16(1)));
+    return _mm256_srli_epi16(x, 8);
+}
+
+V_AVX2 static void convert_Premultiply(uint32_t *dest, const uint32_t *src,
+                                       int length)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i a_mask = _mm256_set1_epi32(0xFF000000);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)src);
+        __m256i a = v8_spread(v8_alpha(c));
+
+        __m256i rb = _mm256_mullo_epi16(_mm256_and_si256(c, rb_mask), a);
+        __m256i g = _mm256_mullo_epi16(
+            _mm256_and_si256(_mm256_srli_epi32(c, 8), _mm256_set1_epi32(0xFF)),
+            a);
+        rb = v8_div255(rb);
+        g = _mm256_slli_epi32(v8_div255(g), 8);
+        _mm256_storeu_si256((__m256i *)dest,
+                            _mm256_or_si256(_mm256_or_si256(rb, g),
+                                            _mm256_and_si256(c, a_mask)));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = premultiply_pixel(src[i]);
+}
+
+// c * 255 / a of the channel at the given shift of 8 pixels, saturated and
+// truncated as the integer division.
+template <int Shift>
+V_AVX2 static inline __m256i v8_unmultiply(__m256i c, __m256 a)
+{
+    __m256i v = _mm256_and_si256(_mm256_srli_epi32(c, Shift),
+                                 _mm256_set1_epi32(0xFF));
+    __m256  f = _mm256_cvtepi32_ps(
+        _mm256_mullo_epi16(v, _mm256_set1_epi32(255)));
+    return _mm256_cvttps_epi32(
+        _mm256_min_ps(_mm256_div_ps(f, a), _mm256_set1_ps(255)));
+}
+
+V_AVX2 static void convert_Unpremultiply(uint32_t *dest, const uint32_t *src,
+                                         int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)src);
+        __m256i a = v8_alpha(c);
+        __m256  fa = _mm256_cvtepi32_ps(a);
+        __m256i p = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(a, 24),
+                            _mm256_slli_epi32(v8_unmultiply<16>(c, fa), 16)),
+            _mm256_or_si256(_mm256_slli_epi32(v8_unmultiply<8>(c, fa), 8),
+                            v8_unmultiply<0>(c, fa)));
+
+        // transparent pixels have no color.
+        __m256i clear = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+        _mm256_storeu_si256((__m256i *)dest, _mm256_andnot_si256(clear, p));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = unpremultiply_pixel(src[i]);
+}
+
+V_AVX2 static void convert_SwapRB(uint32_t *dest, const uint32_t *src,
+                                   int length)
+{
+    const __m256i order = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5,
+        4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)src);
+        _mm256_storeu_si256((__m256i *)dest, _mm256_shuffle_epi8(c, order));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = swap_rb_pixel(src[i]);
+}
+
+// rgb565_pixel() of 8 pixels, in the low half of each 32 bit lane.
+V_AVX2 static inline __m256i v8_rgb565(__m256i c)
+{
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(c, 8),
+                                 _mm256_set1_epi32(0xF800));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(c, 5),
+                                 _mm256_set1_epi32(0x07E0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(c, 3),
+                                 _mm256_set1_epi32(0x001F));
+    return _mm256_or_si256(_mm256_or_si256(r, g), b);
+}
+
+V_AVX2 static void convert_Rgb565(uint16_t *dest, const uint32_t *src,
+                                   int length)
+{
+    for (; length >= 16; length -= 16, src += 16, dest += 16) {
+        __m256i lo = v8_rgb565(_mm256_loadu_si256((const __m256i *)src));
+        __m256i hi =
+            v8_rgb565(_mm256_loadu_si256((const __m256i *)(src + 8)));
+        // the pack works per 128 bit lane, the permute restores the order.
+        __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi),
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)dest, p);
+    }
+    for (int i = 0; i < length; ++i) dest[i] = rgb565_pixel(src[i]);
+}
+
+// the r, g and b of 16 pixels in 16 bit lanes, in the order the pack leaves
+// them: 0-3, 8-11, 4-7, 12-15.
+V_AVX2 static inline void v16_rgb(const uint32_t *src, __m256i &r,
+                                  __m256i &g, __m256i &b)
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    __m256i       lo = _mm256_loadu_si256((const __m256i *)src);
+    __m256i       hi = _mm256_loadu_si256((const __m256i *)(src + 8));
+    r = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 16), mask),
+                           _mm256_and_si256(_mm256_srli_epi32(hi, 16), mask));
+    g = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 8), mask),
+                           _mm256_and_si256(_mm256_srli_epi32(hi, 8), mask));
+    b = _mm256_packs_epi32(_mm256_and_si256(lo, mask),
+                           _mm256_and_si256(hi, mask));
+}
+
+// yuv_luma_pixel() of 16 pixels, the sums fit unsigned 16 bit lanes.
+V_AVX2 static inline __m256i v16_yuv_luma(const uint32_t *src)
+{
+    __m256i r, g, b;
+    v16_rgb(src, r, g, b);
+    __m256i y = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(66)),
+                         _mm256_mullo_epi16(g, _mm256_set1_epi16(129))),
+        _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(25)),
+                         _mm256_set1_epi16(0x1080)));
+    return _mm256_srli_epi16(y, 8);
+}
+
+V_AVX2 static void yuv_Luma(uint8_t *dest, const uint32_t *src, int length)
+{
+    // the packs leave groups of 4 pixels in the order 0, 2, 4, 6, 1, 3, 5, 7.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    for (; length >= 32; length -= 32, src += 32, dest += 32) {
+        __m256i y =
+            _mm256_packus_epi16(v16_yuv_luma(src), v16_yuv_luma(src + 16));
+        _mm256_storeu_si256((__m256i *)dest,
+                            _mm256_permutevar8x32_epi32(y, order));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = yuv_luma_pixel(src[i]);
+}
+
+// the channel sums of the 8 2x2 blocks of 16 pixels of two rows, in 32 bit
+// lanes.
+V_AVX2 static inline void v8_block_sums(const uint32_t *row0,
+                                        const uint32_t *row1, __m256i &r,
+                                        __m256i &g, __m256i &b)
+{
+    // the pack leaves the blocks in the order 0, 1, 4, 5, 2, 3, 6, 7.
+    const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    const __m256i one = _mm256_set1_epi16(1);
+    __m256i       r0, g0, b0, r1, g1, b1;
+    v16_rgb(row0, r0, g0, b0);
+    v16_rgb(row1, r1, g1, b1);
+    r = _mm256_permutevar8x32_epi32(
+        _mm256_madd_epi16(_mm256_add_epi16(r0, r1), one), order);
+    g = _mm256_permutevar8x32_epi32(
+        _mm256_madd_epi16(_mm256_add_epi16(g0, g1), one), order);
+    b = _mm256_permutevar8x32_epi32(
+        _mm256_madd_epi16(_mm256_add_epi16(b0, b1), one), order);
+}
+
+// u and v of yuv_chroma_block() wrap around in 16 bit lanes, but the
+// results are positive and fit.
+V_AVX2 static void yuv_Chroma(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                              const uint32_t *row1, int length)
+{
+    const __m256i round = _mm256_set1_epi16(2);
+    const __m256i offset = _mm256_set1_epi16(short(0x8080));
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int x = 0;
+    for (; x + 32 <= length; x += 32) {
+        __m256i rl, gl, bl, rh, gh, bh;
+        v8_block_sums(row0 + x, row1 + x, rl, gl, bl);
+        v8_block_sums(row0 + x + 16, row1 + x + 16, rh, gh, bh);
+        // blocks 0-3, 8-11, 4-7, 12-15.
+        __m256i r = _mm256_srli_epi16(
+            _mm256_add_epi16(_mm256_packs_epi32(rl, rh), round), 2);
+        __m256i g = _mm256_srli_epi16(
+            _mm256_add_epi16(_mm256_packs_epi32(gl, gh), round), 2);
+        __m256i b = _mm256_srli_epi16(
+            _mm256_add_epi16(_mm256_packs_epi32(bl, bh), round), 2);
+
+        __m256i cu = _mm256_sub_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(112)),
+                             offset),
+            _mm256_add_epi16(_mm256_mullo_epi16(g, _mm256_set1_epi16(74)),
+                             _mm256_mullo_epi16(r, _mm256_set1_epi16(38))));
+        __m256i cv = _mm256_sub_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(112)),
+                             offset),
+            _mm256_add_epi16(_mm256_mullo_epi16(g, _mm256_set1_epi16(94)),
+                             _mm256_mullo_epi16(b, _mm256_set1_epi16(18))));
+        cu = _mm256_srli_epi16(cu, 8);
+        cv = _mm256_srli_epi16(cv, 8);
+
+        if (v) {
+            __m256i p = _mm256_permutevar8x32_epi32(
+                _mm256_packus_epi16(cu, cv), order);
+            _mm_storeu_si128((__m128i *)(u + x / 2),
+                             _mm256_castsi256_si128(p));
+            _mm_storeu_si128((__m128i *)(v + x / 2),
+                             _mm256_extracti128_si256(p, 1));
+        } else {
+            // the byte lanes of the even words are the u, v pairs.
+            __m256i p = _mm256_or_si256(cu, _mm256_slli_epi16(cv, 8));
+            _mm256_storeu_si256(
+                (__m256i *)(u + x),
+                _mm256_permute4x64_epi64(p, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    }
+    for (; x < length; x += 2) yuv_chroma_block(u, v, row0, row1, x, length);
+}
+
+void RenderFuncTable::avx2()
+{
+    updateColor(BlendMode::Src, color_Source);
+    updateColor(BlendMode::SrcOver, color_SourceOver);
+    updateColor(BlendMode::DestIn, color_DestinationIn);
+    updateColor(BlendMode::DestOut, color_DestinationOut);
+    updateColor(BlendMode::DestInLuma, color_DestinationInLuma);
+    updateColor(BlendMode::DestOutLuma, color_DestinationOutLuma);
+
+    updateSrc(BlendMode::Src, src_Source);
+    updateSrc(BlendMode::SrcOver, src_SourceOver);
+    updateSrc(BlendMode::DestIn, src_DestinationIn);
+    updateSrc(BlendMode::DestOut, src_DestinationOut);
+    updateSrc(BlendMode::DestInLuma, src_DestinationInLuma);
+    updateSrc(BlendMode::DestOutLuma, src_DestinationOutLuma);
+
+    updateAlpha8(BlendMode::Src, color_Source_alpha8, src_Source_alpha8);
+    updateAlpha8(BlendMode::SrcOver, color_SourceOver_alpha8,
+                 src_SourceOver_alpha8);
+
+    updateMask(BlendMode::DestIn, mask_DestinationIn);
+    updateMask(BlendMode::DestOut, mask_DestinationOut);
+
+    updateGradient(gradient_Linear, gradient_Radial);
+
+    updateTexture(VTexture::Filter::Nearest, texture_Nearest);
+    updateTexture(VTexture::Filter::Bilinear, texture_Bilinear);
+
+    updateConvert(PixelFunc::Type::Luma, convert_Luma);
+    updateConvert(PixelFunc::Type::Premultiply, convert_Premultiply);
+    updateConvert(PixelFunc::Type::Unpremultiply, convert_Unpremultiply);
+    updateConvert(PixelFunc::Type::SwapRB, convert_SwapRB);
+    updateRgb565(convert_Rgb565);
+    updateYuv(yuv_Luma, yuv_Chroma);
+}
+
+#endif  // V_HAVE_AVX2
@@ -20,6 +20,8 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include "vdrawhelper.h"
 
@@ -168,17 +170,326 @@ static void src_DestinationOut(uint *dest, int length, const uint *src,
     }
 }
 
-RenderFuncTable::RenderFuncTable()
+/*
+  luma mattes take the luminosity of the source instead of its alpha.
+*/
+static void color_DestinationInLuma(uint *dest, int length, uint color,
+                                    uint alpha)
+{
+    uint a = vLuma(color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    for (int i = 0; i < length; ++i) {
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+static void color_DestinationOutLuma(uint *dest, int length, uint color,
+                                     uint alpha)
+{
+    uint a = 255 - vLuma(color);
+    if (alpha != 255) a = BYTE_MUL(a, alpha) + 255 - alpha;
+    for (int i = 0; i < length; ++i) {
+        dest[i] = BYTE_MUL(dest[i], a);
+    }
+}
+
+static void src_DestinationInLuma(uint *dest, int length, const uint *src,
+                                  uint alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) {
+            dest[i] = BYTE_MUL(dest[i], uint(vLuma(src[i])));
+        }
+    } else {
+        uint cia = 255 - alpha;
+        for (int i = 0; i < length; ++i) {
+            uint a = BYTE_MUL(uint(vLuma(src[i])), alpha) + cia;
+            dest[i] = BYTE_MUL(dest[i], a);
+        }
+    }
+}
+
+static void src_DestinationOutLuma(uint *dest, int length, const uint *src,
+                                   uint alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) {
+            dest[i] = BYTE_MUL(dest[i], 255 - uint(vLuma(src[i])));
+        }
+    } else {
+        uint cia = 255 - alpha;
+        for (int i = 0; i < length; ++i) {
+            uint sia = BYTE_MUL(255 - uint(vLuma(src[i])), alpha) + cia;
+            dest[i] = BYTE_MUL(dest[i], sia);
+        }
+    }
+}
+
+/*
+  Alpha8 destination, only the alpha channel of the argb operators above is
+  computed, with the same rounding.
+*/
+static void color_Source_alpha8(uchar *dest, int length, uint32_t color,
+                                uint32_t alpha)
+{
+    uint a = vAlpha(color);
+
+    if (alpha == 255) {
+        memset(dest, int(a), size_t(length));
+    } else {
+        uint ialpha = 255 - alpha;
+        a = (a * alpha) >> 8;
+        for (int i = 0; i < length; ++i)
+            dest[i] = uchar(a + ((dest[i] * ialpha) >> 8));
+    }
+}
+
+static void color_SourceOver_alpha8(uchar *dest, int length, uint32_t color,
+                                    uint32_t alpha)
+{
+    uint a = vAlpha(color);
+
+    if (alpha != 255) a = (a * alpha) >> 8;
+    uint ialpha = 255 - a;
+    for (int i = 0; i < length; ++i)
+        dest[i] = uchar(a + ((dest[i] * ialpha) >> 8));
+}
+
+static void src_Source_alpha8(uchar *dest, int length, const uint32_t *src,
+                              uint32_t alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) dest[i] = uchar(vAlpha(src[i]));
+    } else {
+        uint ialpha = 255 - alpha;
+        for (int i = 0; i < length; ++i)
+            dest[i] = uchar((vAlpha(src[i]) * alpha + dest[i] * ialpha) >> 8);
+    }
+}
+
+static void src_SourceOver_alpha8(uchar *dest, int length,
+                                  const uint32_t *src, uint32_t alpha)
+{
+    uint s, sa;
+
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) {
+            s = src[i];
+            if (s >= 0xff000000)
+                dest[i] = 255;
+            else if (s != 0) {
+                sa = vAlpha(s);
+                dest[i] = uchar(sa + ((dest[i] * (255 - sa)) >> 8));
+            }
+        }
+    } else {
+        for (int i = 0; i < length; ++i) {
+            sa = (vAlpha(src[i]) * alpha) >> 8;
+            dest[i] = uchar(sa + ((dest[i] * (255 - sa)) >> 8));
+        }
+    }
+}
+
+/*
+  Alpha8 source used as a mask, same as the argb DestinationIn/Out.
+*/
+static void mask_DestinationIn(uint *dest, int length, const uchar *src,
+                               uint alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) {
+            dest[i] = BYTE_MUL(dest[i], src[i]);
+        }
+    } else {
+        uint cia = 255 - alpha;
+        for (int i = 0; i < length; ++i) {
+            uint a = ((src[i] * alpha) >> 8) + cia;
+            dest[i] = BYTE_MUL(dest[i], a);
+        }
+    }
+}
+
+static void mask_DestinationOut(uint *dest, int length, const uchar *src,
+                                uint alpha)
+{
+    if (alpha == 255) {
+        for (int i = 0; i < length; ++i) {
+            dest[i] = BYTE_MUL(dest[i], 255 - src[i]);
+        }
+    } else {
+        uint cia = 255 - alpha;
+        for (int i = 0; i < length; ++i) {
+            uint sia = (((255 - src[i]) * alpha) >> 8) + cia;
+            dest[i] = BYTE_MUL(dest[i], sia);
+        }
+    }
+}
+
+/*
+  gradient color table lookups.
+*/
+static void gradient_Linear(uint32_t *buffer, int length,
+                            const VGradientData *grad, int t, int inc)
+{
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = gradientPixelFixed(grad, t);
+        t += inc;
+    }
+}
+
+static void gradient_Radial(uint32_t *buffer, int length,
+                            const VGradientData *       grad,
+                            const RadialGradientValues *v, const float *det,
+                            const float *b)
+{
+    if (v->extended) {
+        for (int i = 0; i < length; ++i) {
+            uint32_t result = 0;
+            if (det[i] >= 0) {
+                float w = std::sqrt(det[i]) - b[i];
+                if (grad->radial.fradius + v->dr * w >= 0)
+                    result = gradientPixel(grad, w);
+            }
+            buffer[i] = result;
+        }
+    } else {
+        for (int i = 0; i < length; ++i)
+            buffer[i] = gradientPixel(grad, std::sqrt(det[i]) - b[i]);
+    }
+}
+
+/*
+  transformed image fetch, the texture clip rect is not empty.
+*/
+static void texture_Nearest(uint32_t *buffer, int length,
+                            const VTextureData *tex, int x, float fx, float fy,
+                            float m11, float m12)
+{
+    for (int i = 0; i < length; ++i) {
+        const float sx = float(x + i) * m11 + fx;
+        const float sy = float(x + i) * m12 + fy;
+        const int   px = std::max(std::min(int(sx), tex->right), tex->left);
+        const int   py = std::max(std::min(int(sy), tex->bottom), tex->top);
+        buffer[i] = tex->pixel(px, py);
+    }
+}
+
+// the texel pair around u and the weight of the second one.
+static inline void bilinearTexels(float u, int lo, int hi, int &t0, int &t1,
+                                  uint &w)
+{
+    u = std::max(std::min(u, float(hi + 1)), float(lo - 1));
+    int p = int(u);
+    if (float(p) > u) p -= 1;
+    w = uint((u - float(p)) * 256);
+    t0 = std::max(std::min(p, hi), lo);
+    t1 = std::max(std::min(p + 1, hi), lo);
+}
+
+// the sample positions are shifted by half a texel, the weights are in
+// 1/256 steps.
+static void texture_Bilinear(uint32_t *buffer, int length,
+                             const VTextureData *tex, int x, float fx,
+                             float fy, float m11, float m12)
+{
+    for (int i = 0; i < length; ++i) {
+        int  x0, x1, y0, y1;
+        uint wx, wy;
+        bilinearTexels(float(x + i) * m11 + fx, tex->left, tex->right, x0, x1,
+                       wx);
+        bilinearTexels(float(x + i) * m12 + fy, tex->top, tex->bottom, y0, y1,
+                       wy);
+        uint32_t top = lerp_pixel(tex->pixel(x0, y0), tex->pixel(x1, y0), wx);
+        uint32_t bottom =
+            lerp_pixel(tex->pixel(x0, y1), tex->pixel(x1, y1), wx);
+        buffer[i] = lerp_pixel(top, bottom, wy);
+    }
+}
+
+static void convert_Luma(uint32_t *dest, const uint32_t *src, int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = uint32_t(vLuma(src[i])) << 24;
+}
+
+static void convert_Premultiply(uint32_t *dest, const uint32_t *src,
+                                int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = premultiply_pixel(src[i]);
+}
+
+static void convert_Unpremultiply(uint32_t *dest, const uint32_t *src,
+                                  int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = unpremultiply_pixel(src[i]);
+}
+
+static void convert_SwapRB(uint32_t *dest, const uint32_t *src, int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = swap_rb_pixel(src[i]);
+}
+
+static void convert_Rgb565(uint16_t *dest, const uint32_t *src, int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = rgb565_pixel(src[i]);
+}
+
+static void yuv_Luma(uint8_t *dest, const uint32_t *src, int length)
+{
+    for (int i = 0; i < length; ++i) dest[i] = yuv_luma_pixel(src[i]);
+}
+
+static void yuv_Chroma(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                       const uint32_t *row1, int length)
+{
+    for (int x = 0; x < length; x += 2)
+        yuv_chroma_block(u, v, row0, row1, x, length);
+}
+
+RenderFuncTable::Simd RenderFuncTable::cpuSimd()
+{
+#if defined(V_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Simd::Avx2;
+#endif
+    return Simd::Baseline;
+}
+
+RenderFuncTable::RenderFuncTable(Simd simd)
 {
     updateColor(BlendMode::Src, color_Source);
     updateColor(BlendMode::SrcOver, color_SourceOver);
     updateColor(BlendMode::DestIn, color_DestinationIn);
     updateColor(BlendMode::DestOut, color_DestinationOut);
+    updateColor(BlendMode::DestInLuma, color_DestinationInLuma);
+    updateColor(BlendMode::DestOutLuma, color_DestinationOutLuma);
 
     updateSrc(BlendMode::Src, src_Source);
     updateSrc(BlendMode::SrcOver, src_SourceOver);
     updateSrc(BlendMode::DestIn, src_DestinationIn);
     updateSrc(BlendMode::DestOut, src_DestinationOut);
+    updateSrc(BlendMode::DestInLuma, src_DestinationInLuma);
+    updateSrc(BlendMode::DestOutLuma, src_DestinationOutLuma);
+
+    updateAlpha8(BlendMode::Src, color_Source_alpha8, src_Source_alpha8);
+    updateAlpha8(BlendMode::SrcOver, color_SourceOver_alpha8,
+                 src_SourceOver_alpha8);
+
+    updateMask(BlendMode::DestIn, mask_DestinationIn);
+    updateMask(BlendMode::DestOut, mask_DestinationOut);
+
+    updateGradient(gradient_Linear, gradient_Radial);
+
+    updateTexture(VTexture::Filter::Nearest, texture_Nearest);
+    updateTexture(VTexture::Filter::Bilinear, texture_Bilinear);
+
+    updateConvert(PixelFunc::Type::Luma, convert_Luma);
+    updateConvert(PixelFunc::Type::Premultiply, convert_Premultiply);
+    updateConvert(PixelFunc::Type::Unpremultiply, convert_Unpremultiply);
+    updateConvert(PixelFunc::Type::SwapRB, convert_SwapRB);
+    updateRgb565(convert_Rgb565);
+    updateYuv(yuv_Luma, yuv_Chroma);
+
+    if (simd == Simd::None) return;
 
 #if defined(__ARM_NEON__) && !defined(LOTTIE_DISABLE_ARM_NEON)
     neon();
@@ -186,4 +497,7 @@ RenderFuncTable::RenderFuncTable()
 #if defined(__SSE2__) && !defined(LOTTIE_DISABLE_ARM_NEON)
     sse();
 #endif
+#if defined(V_HAVE_AVX2)
+    if (simd == Simd::Avx2) avx2();
+#endif
 }
@@ -1,5 +1,8 @@
 #if defined(__ARM_NEON__) && !defined(LOTTIE_DISABLE_ARM_NEON)
 
+#include <arm_neon.h>
+#include <cmath>
+#include <cstring>
 #include "vdrawhelper.h"
 
 extern "C" void pixman_composite_src_n_8888_asm_neon(int32_t w, int32_t h,
@@ -26,8 +29,283 @@ static void color_SourceOver(uint32_t *dest, int length,
     pixman_composite_over_n_8888_asm_neon(length, 1, dest, length, color);
 }
 
+// table indices of 4 positions, the same as gradientClamp().
+static inline int32x4_t v4_gradient_clamp_neon(const VGradientData *grad,
+                                               int32x4_t            ipos)
+{
+    const int32x4_t last = vdupq_n_s32(VGradient::colorTableSize - 1);
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        return vandq_s32(ipos, last);
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        // the second half of each period runs backwards.
+        const int32x4_t limit = vdupq_n_s32(VGradient::colorTableSize * 2 - 1);
+        ipos = vandq_s32(ipos, limit);
+        int32x4_t back = vreinterpretq_s32_u32(vcgtq_s32(ipos, last));
+        return veorq_s32(ipos, vandq_s32(back, limit));
+    } else {
+        return vminq_s32(vmaxq_s32(ipos, vdupq_n_s32(0)), last);
+    }
+}
+
+static inline uint32x4_t v4_gradient_fetch_neon(const VGradientData *grad,
+                                                int32x4_t            index)
+{
+    const uint32_t *table = grad->mColorTable;
+    uint32x4_t      c = vdupq_n_u32(0);
+
+    c = vsetq_lane_u32(table[vgetq_lane_s32(index, 0)], c, 0);
+    c = vsetq_lane_u32(table[vgetq_lane_s32(index, 1)], c, 1);
+    c = vsetq_lane_u32(table[vgetq_lane_s32(index, 2)], c, 2);
+    c = vsetq_lane_u32(table[vgetq_lane_s32(index, 3)], c, 3);
+    return c;
+}
+
+static void gradient_Linear(uint32_t *buffer, int length,
+                            const VGradientData *grad, int t, int inc)
+{
+    static const int32_t steps[4] = {0, 1, 2, 3};
+    const int32x4_t      v_inc = vdupq_n_s32(4 * inc);
+    const int32x4_t      v_half = vdupq_n_s32(FIXPT_SIZE / 2);
+    int32x4_t            v_t =
+        vmlaq_s32(vdupq_n_s32(t), vld1q_s32(steps), vdupq_n_s32(inc));
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        int32x4_t ipos = vshrq_n_s32(vaddq_s32(v_t, v_half), FIXPT_BITS);
+        ipos = v4_gradient_clamp_neon(grad, ipos);
+        vst1q_u32(buffer, v4_gradient_fetch_neon(grad, ipos));
+        v_t = vaddq_s32(v_t, v_inc);
+    }
+
+    t = vgetq_lane_s32(v_t, 0);
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = gradientPixelFixed(grad, t);
+        t += inc;
+    }
+}
+
+static void gradient_Radial(uint32_t *buffer, int length,
+                            const VGradientData *       grad,
+                            const RadialGradientValues *v, const float *det,
+                            const float *b)
+{
+    const float32x4_t v_scale = vdupq_n_f32(VGradient::colorTableSize - 1);
+    const float32x4_t v_half = vdupq_n_f32(0.5f);
+    const float32x4_t v_fr = vdupq_n_f32(grad->radial.fradius);
+    const float32x4_t v_dr = vdupq_n_f32(v->dr);
+    const float32x4_t zero = vdupq_n_f32(0);
+    int               i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        // armv7 neon has no square root, only an estimate.
+        float root[4] = {std::sqrt(det[i]), std::sqrt(det[i + 1]),
+                         std::sqrt(det[i + 2]), std::sqrt(det[i + 3])};
+        float32x4_t d = vld1q_f32(det + i);
+        float32x4_t w = vsubq_f32(vld1q_f32(root), vld1q_f32(b + i));
+        int32x4_t   ipos =
+            vcvtq_s32_f32(vaddq_f32(vmulq_f32(w, v_scale), v_half));
+        uint32x4_t c =
+            v4_gradient_fetch_neon(grad, v4_gradient_clamp_neon(grad, ipos));
+        if (v->extended) {
+            // no color where there is no circle for the position.
+            float32x4_t r = vaddq_f32(v_fr, vmulq_f32(v_dr, w));
+            c = vandq_u32(c, vandq_u32(vcgeq_f32(d, zero), vcgeq_f32(r, zero)));
+        }
+        vst1q_u32(buffer + i, c);
+    }
+    if (i == length) return;
+
+    // the tail goes through the same vector math in a padded block.
+    float    d[4] = {}, bb[4] = {};
+    uint32_t c[4];
+    memcpy(d, det + i, size_t(length - i) * sizeof(float));
+    memcpy(bb, b + i, size_t(length - i) * sizeof(float));
+    gradient_Radial(c, 4, grad, v, d, bb);
+    memcpy(buffer + i, c, size_t(length - i) * sizeof(uint32_t));
+}
+
+static inline int32x4_t v4_clamp_neon(int32x4_t v, int lo, int hi)
+{
+    return vmaxq_s32(vminq_s32(v, vdupq_n_s32(hi)), vdupq_n_s32(lo));
+}
+
+static inline int32x4_t v4_positions_neon(int x)
+{
+    static const int32_t steps[4] = {0, 1, 2, 3};
+    return vaddq_s32(vdupq_n_s32(x), vld1q_s32(steps));
+}
+
+static void texture_Nearest(uint32_t *buffer, int length,
+                            const VTextureData *tex, int x, float fx, float fy,
+                            float m11, float m12)
+{
+    const float32x4_t v_fx = vdupq_n_f32(fx);
+    const float32x4_t v_fy = vdupq_n_f32(fy);
+    const float32x4_t v_m11 = vdupq_n_f32(m11);
+    const float32x4_t v_m12 = vdupq_n_f32(m12);
+    int32x4_t         pos = v4_positions_neon(x);
+    int32_t           px[4], py[4];
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        float32x4_t p = vcvtq_f32_s32(pos);
+        int32x4_t   sx = vcvtq_s32_f32(vaddq_f32(vmulq_f32(p, v_m11), v_fx));
+        int32x4_t   sy = vcvtq_s32_f32(vaddq_f32(vmulq_f32(p, v_m12), v_fy));
+        vst1q_s32(px, v4_clamp_neon(sx, tex->left, tex->right));
+        vst1q_s32(py, v4_clamp_neon(sy, tex->top, tex->bottom));
+        for (int i = 0; i < 4; ++i) buffer[i] = tex->pixel(px[i], py[i]);
+        pos = vaddq_s32(pos, vdupq_n_s32(4));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[4];
+    texture_Nearest(c, 4, tex, vgetq_lane_s32(pos, 0), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+// texel pairs around 4 positions and the weights of the second ones, the
+// same as bilinearTexels().
+static inline void v4_bilinear_texels_neon(float32x4_t u, int lo, int hi,
+                                           int32_t *t0, int32_t *t1,
+                                           uint16x8_t &w)
+{
+    u = vmaxq_f32(vminq_f32(u, vdupq_n_f32(float(hi + 1))),
+                  vdupq_n_f32(float(lo - 1)));
+    int32x4_t p = vcvtq_s32_f32(u);
+    // truncation rounds negative positions up.
+    uint32x4_t up = vcgtq_f32(vcvtq_f32_s32(p), u);
+    p = vaddq_s32(p, vreinterpretq_s32_u32(up));
+    float32x4_t frac = vsubq_f32(u, vcvtq_f32_s32(p));
+    uint32x4_t  w32 = vcvtq_u32_f32(vmulq_f32(frac, vdupq_n_f32(256)));
+    w = vreinterpretq_u16_u32(vorrq_u32(w32, vshlq_n_u32(w32, 16)));
+    vst1q_s32(t0, v4_clamp_neon(p, lo, hi));
+    vst1q_s32(t1, v4_clamp_neon(vaddq_s32(p, vdupq_n_s32(1)), lo, hi));
+}
+
+// lerp_pixel() of 4 pixels, w holds the weights in both 16 bit halves.
+static inline uint32x4_t v4_lerp_neon(uint32x4_t a, uint32x4_t b,
+                                      uint16x8_t w)
+{
+    const uint32x4_t rb_mask = vdupq_n_u32(0x00FF00FF);
+    const uint32x4_t ag_mask = vdupq_n_u32(0xFF00FF00);
+    const uint16x8_t iw = vsubq_u16(vdupq_n_u16(256), w);
+
+    uint16x8_t a_rb = vreinterpretq_u16_u32(vandq_u32(a, rb_mask));
+    uint16x8_t b_rb = vreinterpretq_u16_u32(vandq_u32(b, rb_mask));
+    uint16x8_t a_ag = vshrq_n_u16(vreinterpretq_u16_u32(a), 8);
+    uint16x8_t b_ag = vshrq_n_u16(vreinterpretq_u16_u32(b), 8);
+
+    uint16x8_t rb = vshrq_n_u16(vmlaq_u16(vmulq_u16(a_rb, iw), b_rb, w), 8);
+    uint16x8_t ag = vmlaq_u16(vmulq_u16(a_ag, iw), b_ag, w);
+    return vorrq_u32(vandq_u32(vreinterpretq_u32_u16(ag), ag_mask),
+                     vreinterpretq_u32_u16(rb));
+}
+
+static inline uint32x4_t v4_texels_neon(const VTextureData *tex,
+                                        const int32_t *x, const int32_t *y)
+{
+    uint32_t c[4] = {tex->pixel(x[0], y[0]), tex->pixel(x[1], y[1]),
+                     tex->pixel(x[2], y[2]), tex->pixel(x[3], y[3])};
+    return vld1q_u32(c);
+}
+
+static void texture_Bilinear(uint32_t *buffer, int length,
+                             const VTextureData *tex, int x, float fx,
+                             float fy, float m11, float m12)
+{
+    const float32x4_t v_fx = vdupq_n_f32(fx);
+    const float32x4_t v_fy = vdupq_n_f32(fy);
+    const float32x4_t v_m11 = vdupq_n_f32(m11);
+    const float32x4_t v_m12 = vdupq_n_f32(m12);
+    int32x4_t         pos = v4_positions_neon(x);
+    int32_t           px0[4], px1[4], py0[4], py1[4];
+    uint16x8_t        wx, wy;
+
+    // a scale only matrix keeps the rows of the whole span.
+    const bool scaleOnly = (m12 == 0);
+    if (scaleOnly)
+        v4_bilinear_texels_neon(v_fy, tex->top, tex->bottom, py0, py1, wy);
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        float32x4_t p = vcvtq_f32_s32(pos);
+        v4_bilinear_texels_neon(vaddq_f32(vmulq_f32(p, v_m11), v_fx),
+                                tex->left, tex->right, px0, px1, wx);
+        if (!scaleOnly)
+            v4_bilinear_texels_neon(vaddq_f32(vmulq_f32(p, v_m12), v_fy),
+                                    tex->top, tex->bottom, py0, py1, wy);
+
+        uint32x4_t t = v4_lerp_neon(v4_texels_neon(tex, px0, py0),
+                                    v4_texels_neon(tex, px1, py0), wx);
+        uint32x4_t b = v4_lerp_neon(v4_texels_neon(tex, px0, py1),
+                                    v4_texels_neon(tex, px1, py1), wx);
+        vst1q_u32(buffer, v4_lerp_neon(t, b, wy));
+        pos = vaddq_s32(pos, vdupq_n_s32(4));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[4];
+    texture_Bilinear(c, 4, tex, vgetq_lane_s32(pos, 0), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+// exact x / 255 of the products of two bytes.
+static inline uint8x8_t v8_div255_neon(uint16x8_t x)
+{
+    x = vaddq_u16(x, vaddq_u16(vshrq_n_u16(x, 8), vdupq_n_u16(1)));
+    return vshrn_n_u16(x, 8);
+}
+
+static void convert_Premultiply(uint32_t *dest, const uint32_t *src,
+                                int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        // the channels of 8 pixels in b, g, r, a order.
+        uint8x8x4_t c = vld4_u8((const uint8_t *)src);
+        c.val[0] = v8_div255_neon(vmull_u8(c.val[0], c.val[3]));
+        c.val[1] = v8_div255_neon(vmull_u8(c.val[1], c.val[3]));
+        c.val[2] = v8_div255_neon(vmull_u8(c.val[2], c.val[3]));
+        vst4_u8((uint8_t *)dest, c);
+    }
+    for (int i = 0; i < length; ++i) dest[i] = premultiply_pixel(src[i]);
+}
+
+static void convert_SwapRB(uint32_t *dest, const uint32_t *src, int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        uint8x8x4_t c = vld4_u8((const uint8_t *)src);
+        uint8x8_t   b = c.val[0];
+        c.val[0] = c.val[2];
+        c.val[2] = b;
+        vst4_u8((uint8_t *)dest, c);
+    }
+    for (int i = 0; i < length; ++i) dest[i] = swap_rb_pixel(src[i]);
+}
+
+static void convert_Rgb565(uint16_t *dest, const uint32_t *src, int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        uint8x8x4_t c = vld4_u8((const uint8_t *)src);
+        uint16x8_t  p = vshll_n_u8(c.val[2], 8);
+        p = vsriq_n_u16(p, vshll_n_u8(c.val[1], 8), 5);
+        p = vsriq_n_u16(p, vshll_n_u8(c.val[0], 8), 11);
+        vst1q_u16(dest, p);
+    }
+    for (int i = 0; i < length; ++i) dest[i] = rgb565_pixel(src[i]);
+}
+
 void RenderFuncTable::neon()
 {
     updateColor(BlendMode::Src , color_SourceOver);
+
+    updateGradient(gradient_Linear, gradient_Radial);
+
+    updateTexture(VTexture::Filter::Nearest, texture_Nearest);
+    updateTexture(VTexture::Filter::Bilinear, texture_Bilinear);
+
+    // luma and unpremultiply divide, which this neon can not do exactly.
+    updateConvert(PixelFunc::Type::Premultiply, convert_Premultiply);
+    updateConvert(PixelFunc::Type::SwapRB, convert_SwapRB);
+    updateRgb565(convert_Rgb565);
 }
 #endif
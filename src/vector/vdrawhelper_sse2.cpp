@@ -250,6 +250,470 @@ static void src_Source(uint32_t* dest, int length, const uint32_t* src,
     }
 }
 
+// table indices of 4 positions, the same as gradientClamp().
+static inline __m128i v4_gradient_clamp_sse2(const VGradientData *grad,
+                                             __m128i              ipos)
+{
+    const __m128i last = _mm_set1_epi32(VGradient::colorTableSize - 1);
+
+    if (grad->mSpread == VGradient::Spread::Repeat) {
+        return _mm_and_si128(ipos, last);
+    } else if (grad->mSpread == VGradient::Spread::Reflect) {
+        // the second half of each period runs backwards.
+        const __m128i limit = _mm_set1_epi32(VGradient::colorTableSize * 2 - 1);
+        ipos = _mm_and_si128(ipos, limit);
+        __m128i back = _mm_cmpgt_epi32(ipos, last);
+        return _mm_xor_si128(ipos, _mm_and_si128(back, limit));
+    } else {
+        ipos = _mm_and_si128(ipos, _mm_cmpgt_epi32(ipos, _mm_setzero_si128()));
+        __m128i over = _mm_cmpgt_epi32(ipos, last);
+        return _mm_or_si128(_mm_andnot_si128(over, ipos),
+                            _mm_and_si128(over, last));
+    }
+}
+
+static inline __m128i v4_gradient_fetch_sse2(const VGradientData *grad,
+                                             __m128i              index)
+{
+    alignas(16) int i[4];
+    _mm_store_si128((__m128i *)i, index);
+
+    const uint32_t *table = grad->mColorTable;
+    return _mm_setr_epi32(int(table[i[0]]), int(table[i[1]]),
+                          int(table[i[2]]), int(table[i[3]]));
+}
+
+static void gradient_Linear(uint32_t *buffer, int length,
+                            const VGradientData *grad, int t, int inc)
+{
+    const __m128i v_inc = _mm_set1_epi32(4 * inc);
+    const __m128i v_half = _mm_set1_epi32(FIXPT_SIZE / 2);
+    __m128i v_t = _mm_setr_epi32(t, t + inc, t + 2 * inc, t + 3 * inc);
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        __m128i ipos = _mm_srai_epi32(_mm_add_epi32(v_t, v_half), FIXPT_BITS);
+        ipos = v4_gradient_clamp_sse2(grad, ipos);
+        _mm_storeu_si128((__m128i *)buffer, v4_gradient_fetch_sse2(grad, ipos));
+        v_t = _mm_add_epi32(v_t, v_inc);
+    }
+
+    t = _mm_cvtsi128_si32(v_t);
+    for (int i = 0; i < length; ++i) {
+        buffer[i] = gradientPixelFixed(grad, t);
+        t += inc;
+    }
+}
+
+static void gradient_Radial(uint32_t *buffer, int length,
+                            const VGradientData *       grad,
+                            const RadialGradientValues *v, const float *det,
+                            const float *b)
+{
+    const __m128 v_scale = _mm_set1_ps(VGradient::colorTableSize - 1);
+    const __m128 v_half = _mm_set1_ps(0.5f);
+    const __m128 v_fr = _mm_set1_ps(grad->radial.fradius);
+    const __m128 v_dr = _mm_set1_ps(v->dr);
+    const __m128 zero = _mm_setzero_ps();
+    int          i = 0;
+
+    for (; i + 4 <= length; i += 4) {
+        __m128  d = _mm_loadu_ps(det + i);
+        __m128  w = _mm_sub_ps(_mm_sqrt_ps(d), _mm_loadu_ps(b + i));
+        __m128i ipos = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, v_scale),
+                                                   v_half));
+        __m128i c = v4_gradient_fetch_sse2(grad,
+                                           v4_gradient_clamp_sse2(grad, ipos));
+        if (v->extended) {
+            // no color where there is no circle for the position.
+            __m128 r = _mm_add_ps(v_fr, _mm_mul_ps(v_dr, w));
+            __m128 keep = _mm_and_ps(_mm_cmpge_ps(d, zero),
+                                     _mm_cmpge_ps(r, zero));
+            c = _mm_and_si128(c, _mm_castps_si128(keep));
+        }
+        _mm_storeu_si128((__m128i *)(buffer + i), c);
+    }
+    if (i == length) return;
+
+    // the tail goes through the same vector math in a padded block.
+    float    d[4] = {}, bb[4] = {};
+    uint32_t c[4];
+    memcpy(d, det + i, size_t(length - i) * sizeof(float));
+    memcpy(bb, b + i, size_t(length - i) * sizeof(float));
+    gradient_Radial(c, 4, grad, v, d, bb);
+    memcpy(buffer + i, c, size_t(length - i) * sizeof(uint32_t));
+}
+
+// max(min(v, hi), lo) of 4 ints.
+static inline __m128i v4_clamp_sse2(__m128i v, __m128i lo, __m128i hi)
+{
+    __m128i over = _mm_cmpgt_epi32(v, hi);
+    v = _mm_or_si128(_mm_andnot_si128(over, v), _mm_and_si128(over, hi));
+    __m128i under = _mm_cmplt_epi32(v, lo);
+    return _mm_or_si128(_mm_andnot_si128(under, v), _mm_and_si128(under, lo));
+}
+
+static void texture_Nearest(uint32_t *buffer, int length,
+                            const VTextureData *tex, int x, float fx, float fy,
+                            float m11, float m12)
+{
+    const __m128i left = _mm_set1_epi32(tex->left);
+    const __m128i right = _mm_set1_epi32(tex->right);
+    const __m128i top = _mm_set1_epi32(tex->top);
+    const __m128i bottom = _mm_set1_epi32(tex->bottom);
+    const __m128  v_fx = _mm_set1_ps(fx);
+    const __m128  v_fy = _mm_set1_ps(fy);
+    const __m128  v_m11 = _mm_set1_ps(m11);
+    const __m128  v_m12 = _mm_set1_ps(m12);
+    __m128i       pos = _mm_setr_epi32(x, x + 1, x + 2, x + 3);
+    alignas(16) int px[4], py[4];
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        __m128  p = _mm_cvtepi32_ps(pos);
+        __m128i sx = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(p, v_m11), v_fx));
+        __m128i sy = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(p, v_m12), v_fy));
+        _mm_store_si128((__m128i *)px, v4_clamp_sse2(sx, left, right));
+        _mm_store_si128((__m128i *)py, v4_clamp_sse2(sy, top, bottom));
+        for (int i = 0; i < 4; ++i) buffer[i] = tex->pixel(px[i], py[i]);
+        pos = _mm_add_epi32(pos, _mm_set1_epi32(4));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[4];
+    texture_Nearest(c, 4, tex, _mm_cvtsi128_si32(pos), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+// texel pairs around 4 positions and the weights of the second ones, the
+// same as bilinearTexels().
+static inline void v4_bilinear_texels_sse2(__m128 u, int lo, int hi,
+                                           __m128i &t0, __m128i &t1,
+                                           __m128i &w)
+{
+    const __m128i v_lo = _mm_set1_epi32(lo);
+    const __m128i v_hi = _mm_set1_epi32(hi);
+
+    u = _mm_max_ps(_mm_min_ps(u, _mm_set1_ps(float(hi + 1))),
+                   _mm_set1_ps(float(lo - 1)));
+    __m128i p = _mm_cvttps_epi32(u);
+    // truncation rounds negative positions up.
+    p = _mm_add_epi32(
+        p, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(p), u)));
+    __m128 frac = _mm_sub_ps(u, _mm_cvtepi32_ps(p));
+    w = _mm_cvttps_epi32(_mm_mul_ps(frac, _mm_set1_ps(256)));
+    t0 = v4_clamp_sse2(p, v_lo, v_hi);
+    t1 = v4_clamp_sse2(_mm_add_epi32(p, _mm_set1_epi32(1)), v_lo, v_hi);
+}
+
+// lerp_pixel() of 4 pixels, w holds the weights as 0x00WW00WW.
+static inline __m128i v4_lerp_sse2(__m128i a, __m128i b, __m128i w)
+{
+    const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i ag_mask = _mm_set1_epi32(0xFF00FF00);
+    const __m128i iw = _mm_sub_epi16(_mm_set1_epi16(256), w);
+
+    __m128i rb = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(a, rb_mask), iw),
+                               _mm_mullo_epi16(_mm_and_si128(b, rb_mask), w));
+    __m128i ag = _mm_add_epi16(_mm_mullo_epi16(_mm_srli_epi16(a, 8), iw),
+                               _mm_mullo_epi16(_mm_srli_epi16(b, 8), w));
+    return _mm_or_si128(_mm_and_si128(ag, ag_mask), _mm_srli_epi16(rb, 8));
+}
+
+static inline __m128i v4_texels_sse2(const VTextureData *tex, const int *x,
+                                     const int *y)
+{
+    return _mm_setr_epi32(
+        int(tex->pixel(x[0], y[0])), int(tex->pixel(x[1], y[1])),
+        int(tex->pixel(x[2], y[2])), int(tex->pixel(x[3], y[3])));
+}
+
+static void texture_Bilinear(uint32_t *buffer, int length,
+                             const VTextureData *tex, int x, float fx,
+                             float fy, float m11, float m12)
+{
+    const __m128 v_fx = _mm_set1_ps(fx);
+    const __m128 v_fy = _mm_set1_ps(fy);
+    const __m128 v_m11 = _mm_set1_ps(m11);
+    const __m128 v_m12 = _mm_set1_ps(m12);
+    __m128i      pos = _mm_setr_epi32(x, x + 1, x + 2, x + 3);
+    __m128i      x0, x1, y0, y1, wx, wy;
+    alignas(16) int px0[4], px1[4], py0[4], py1[4];
+
+    // a scale only matrix keeps the rows of the whole span.
+    const bool scaleOnly = (m12 == 0);
+    if (scaleOnly) {
+        v4_bilinear_texels_sse2(v_fy, tex->top, tex->bottom, y0, y1, wy);
+        wy = _mm_or_si128(wy, _mm_slli_epi32(wy, 16));
+        _mm_store_si128((__m128i *)py0, y0);
+        _mm_store_si128((__m128i *)py1, y1);
+    }
+
+    for (; length >= 4; length -= 4, buffer += 4) {
+        __m128 p = _mm_cvtepi32_ps(pos);
+        v4_bilinear_texels_sse2(_mm_add_ps(_mm_mul_ps(p, v_m11), v_fx),
+                                tex->left, tex->right, x0, x1, wx);
+        if (!scaleOnly) {
+            v4_bilinear_texels_sse2(_mm_add_ps(_mm_mul_ps(p, v_m12), v_fy),
+                                    tex->top, tex->bottom, y0, y1, wy);
+            wy = _mm_or_si128(wy, _mm_slli_epi32(wy, 16));
+            _mm_store_si128((__m128i *)py0, y0);
+            _mm_store_si128((__m128i *)py1, y1);
+        }
+        wx = _mm_or_si128(wx, _mm_slli_epi32(wx, 16));
+        _mm_store_si128((__m128i *)px0, x0);
+        _mm_store_si128((__m128i *)px1, x1);
+
+        __m128i t = v4_lerp_sse2(v4_texels_sse2(tex, px0, py0),
+                                 v4_texels_sse2(tex, px1, py0), wx);
+        __m128i b = v4_lerp_sse2(v4_texels_sse2(tex, px0, py1),
+                                 v4_texels_sse2(tex, px1, py1), wx);
+        _mm_storeu_si128((__m128i *)buffer, v4_lerp_sse2(t, b, wy));
+        pos = _mm_add_epi32(pos, _mm_set1_epi32(4));
+    }
+    if (!length) return;
+
+    // the tail samples a full block, the extra positions are clamped too.
+    uint32_t c[4];
+    texture_Bilinear(c, 4, tex, _mm_cvtsi128_si32(pos), fx, fy, m11, m12);
+    memcpy(buffer, c, size_t(length) * sizeof(uint32_t));
+}
+
+// channel of 4 pixels at the given shift times 255, as floats.
+static inline __m128 v4_channel255_sse2(__m128i c, int shift)
+{
+    __m128i v = _mm_and_si128(_mm_srl_epi32(c, _mm_cvtsi32_si128(shift)),
+                              _mm_set1_epi32(0xFF));
+    return _mm_cvtepi32_ps(_mm_mullo_epi16(v, _mm_set1_epi32(255)));
+}
+
+// c * 255 / a of 4 channels truncated as the integer division, the
+// quotients below 255 stay far enough from the next integer.
+static inline __m128 v4_unmultiply_sse2(__m128 c, __m128 a)
+{
+    return _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_min_ps(_mm_div_ps(c, a), _mm_set1_ps(255))));
+}
+
+// vLuma() of 4 pixels, the float math runs in the same order.
+static inline __m128i v4_luma_sse2(__m128i c)
+{
+    __m128i a = _mm_srli_epi32(c, 24);
+    __m128  fa = _mm_cvtepi32_ps(a);
+    __m128  fr = _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_div_ps(v4_channel255_sse2(c, 16), fa)));
+    __m128  fg = _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_div_ps(v4_channel255_sse2(c, 8), fa)));
+    __m128  fb = _mm_cvtepi32_ps(_mm_cvttps_epi32(
+        _mm_div_ps(v4_channel255_sse2(c, 0), fa)));
+
+    __m128 l = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.299f), fr),
+                                     _mm_mul_ps(_mm_set1_ps(0.587f), fg)),
+                          _mm_mul_ps(_mm_set1_ps(0.114f), fb));
+    __m128i luma = _mm_cvttps_epi32(_mm_min_ps(l, _mm_set1_ps(255)));
+
+    // transparent pixels have none.
+    __m128i clear = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+    return _mm_andnot_si128(clear, luma);
+}
+
+static void convert_Luma(uint32_t *dest, const uint32_t *src, int length)
+{
+    for (; length >= 4; length -= 4, src += 4, dest += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)src);
+        _mm_storeu_si128((__m128i *)dest,
+                         _mm_slli_epi32(v4_luma_sse2(c), 24));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = uint32_t(vLuma(src[i])) << 24;
+}
+
+// exact x / 255 of 16 bit products of two bytes.
+static inline __m128i v4_div255_sse2(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_add_epi16(_mm_srli_epi16(x, 8),
+                                       _mm_set1_epi16(1)));
+    return _mm_srli_epi16(x, 8);
+}
+
+static void convert_Premultiply(uint32_t *dest, const uint32_t *src,
+                                int length)
+{
+    const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i a_mask = _mm_set1_epi32(0xFF000000);
+
+    for (; length >= 4; length -= 4, src += 4, dest += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)src);
+        __m128i a = _mm_srli_epi32(c, 24);
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+        __m128i rb = _mm_mullo_epi16(_mm_and_si128(c, rb_mask), a);
+        __m128i g = _mm_mullo_epi16(
+            _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xFF)), a);
+        rb = v4_div255_sse2(rb);
+        g = _mm_slli_epi32(v4_div255_sse2(g), 8);
+        _mm_storeu_si128((__m128i *)dest,
+                         _mm_or_si128(_mm_or_si128(rb, g),
+                                      _mm_and_si128(c, a_mask)));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = premultiply_pixel(src[i]);
+}
+
+static void convert_Unpremultiply(uint32_t *dest, const uint32_t *src,
+                                  int length)
+{
+    for (; length >= 4; length -= 4, src += 4, dest += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)src);
+        __m128i a = _mm_srli_epi32(c, 24);
+        __m128  fa = _mm_cvtepi32_ps(a);
+        __m128i r = _mm_cvttps_epi32(
+            v4_unmultiply_sse2(v4_channel255_sse2(c, 16), fa));
+        __m128i g = _mm_cvttps_epi32(
+            v4_unmultiply_sse2(v4_channel255_sse2(c, 8), fa));
+        __m128i b = _mm_cvttps_epi32(
+            v4_unmultiply_sse2(v4_channel255_sse2(c, 0), fa));
+        __m128i p = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16)),
+            _mm_or_si128(_mm_slli_epi32(g, 8), b));
+
+        // transparent pixels have no color.
+        __m128i clear = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+        _mm_storeu_si128((__m128i *)dest, _mm_andnot_si128(clear, p));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = unpremultiply_pixel(src[i]);
+}
+
+static void convert_SwapRB(uint32_t *dest, const uint32_t *src, int length)
+{
+    const __m128i ag_mask = _mm_set1_epi32(0xFF00FF00);
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+
+    for (; length >= 4; length -= 4, src += 4, dest += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)src);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(c, 16), byte_mask);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(c, byte_mask), 16);
+        _mm_storeu_si128((__m128i *)dest,
+                         _mm_or_si128(_mm_and_si128(c, ag_mask),
+                                      _mm_or_si128(r, b)));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = swap_rb_pixel(src[i]);
+}
+
+// rgb565_pixel() of 4 pixels, in the low half of each 32 bit lane.
+static inline __m128i v4_rgb565_sse2(__m128i c)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(c, 3), _mm_set1_epi32(0x001F));
+    __m128i p = _mm_or_si128(_mm_or_si128(r, g), b);
+    // sign extended, so the saturating pack keeps the bits.
+    return _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+}
+
+static void convert_Rgb565(uint16_t *dest, const uint32_t *src, int length)
+{
+    for (; length >= 8; length -= 8, src += 8, dest += 8) {
+        __m128i lo = v4_rgb565_sse2(_mm_loadu_si128((const __m128i *)src));
+        __m128i hi =
+            v4_rgb565_sse2(_mm_loadu_si128((const __m128i *)(src + 4)));
+        _mm_storeu_si128((__m128i *)dest, _mm_packs_epi32(lo, hi));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = rgb565_pixel(src[i]);
+}
+
+// the r, g and b of 8 pixels in 16 bit lanes.
+static inline void v8_rgb_sse2(const uint32_t *src, __m128i &r, __m128i &g,
+                               __m128i &b)
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i       lo = _mm_loadu_si128((const __m128i *)src);
+    __m128i       hi = _mm_loadu_si128((const __m128i *)(src + 4));
+    r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask),
+                        _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+    g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask),
+                        _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+    b = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+}
+
+// yuv_luma_pixel() of 8 pixels, the sums fit unsigned 16 bit lanes.
+static inline __m128i v8_yuv_luma_sse2(const uint32_t *src)
+{
+    __m128i r, g, b;
+    v8_rgb_sse2(src, r, g, b);
+    __m128i y = _mm_add_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                      _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)),
+                      _mm_set1_epi16(0x1080)));
+    return _mm_srli_epi16(y, 8);
+}
+
+static void yuv_Luma(uint8_t *dest, const uint32_t *src, int length)
+{
+    for (; length >= 16; length -= 16, src += 16, dest += 16) {
+        __m128i lo = v8_yuv_luma_sse2(src);
+        __m128i hi = v8_yuv_luma_sse2(src + 8);
+        _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(lo, hi));
+    }
+    for (int i = 0; i < length; ++i) dest[i] = yuv_luma_pixel(src[i]);
+}
+
+// the channel sums of the 4 2x2 blocks of 8 pixels of two rows, in 32 bit
+// lanes.
+static inline void v4_block_sums_sse2(const uint32_t *row0,
+                                      const uint32_t *row1, __m128i &r,
+                                      __m128i &g, __m128i &b)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i       r0, g0, b0, r1, g1, b1;
+    v8_rgb_sse2(row0, r0, g0, b0);
+    v8_rgb_sse2(row1, r1, g1, b1);
+    r = _mm_madd_epi16(_mm_add_epi16(r0, r1), one);
+    g = _mm_madd_epi16(_mm_add_epi16(g0, g1), one);
+    b = _mm_madd_epi16(_mm_add_epi16(b0, b1), one);
+}
+
+// u and v of yuv_chroma_block() wrap around in 16 bit lanes, but the
+// results are positive and fit.
+static void yuv_Chroma(uint8_t *u, uint8_t *v, const uint32_t *row0,
+                       const uint32_t *row1, int length)
+{
+    const __m128i round = _mm_set1_epi16(2);
+    const __m128i offset = _mm_set1_epi16(short(0x8080));
+
+    int x = 0;
+    for (; x + 16 <= length; x += 16) {
+        __m128i rl, gl, bl, rh, gh, bh;
+        v4_block_sums_sse2(row0 + x, row1 + x, rl, gl, bl);
+        v4_block_sums_sse2(row0 + x + 8, row1 + x + 8, rh, gh, bh);
+        __m128i r = _mm_srli_epi16(
+            _mm_add_epi16(_mm_packs_epi32(rl, rh), round), 2);
+        __m128i g = _mm_srli_epi16(
+            _mm_add_epi16(_mm_packs_epi32(gl, gh), round), 2);
+        __m128i b = _mm_srli_epi16(
+            _mm_add_epi16(_mm_packs_epi32(bl, bh), round), 2);
+
+        __m128i cu = _mm_sub_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), offset),
+            _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(74)),
+                          _mm_mullo_epi16(r, _mm_set1_epi16(38))));
+        __m128i cv = _mm_sub_epi16(
+            _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)), offset),
+            _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(94)),
+                          _mm_mullo_epi16(b, _mm_set1_epi16(18))));
+        cu = _mm_srli_epi16(cu, 8);
+        cv = _mm_srli_epi16(cv, 8);
+
+        if (v) {
+            _mm_storel_epi64((__m128i *)(u + x / 2), _mm_packus_epi16(cu, cu));
+            _mm_storel_epi64((__m128i *)(v + x / 2), _mm_packus_epi16(cv, cv));
+        } else {
+            // the byte lanes of the even words are the u, v pairs.
+            _mm_storeu_si128((__m128i *)(u + x),
+                             _mm_or_si128(cu, _mm_slli_epi16(cv, 8)));
+        }
+    }
+    for (; x < length; x += 2) yuv_chroma_block(u, v, row0, row1, x, length);
+}
+
 #if !defined(LOTTIE_DISABLE_ARM_NEON)
 void RenderFuncTable::sse()
 {
@@ -257,6 +721,18 @@ void RenderFuncTable::sse()
     updateColor(BlendMode::SrcOver , color_SourceOver);
 
     updateSrc(BlendMode::Src , src_Source);
+
+    updateGradient(gradient_Linear, gradient_Radial);
+
+    updateTexture(VTexture::Filter::Nearest, texture_Nearest);
+    updateTexture(VTexture::Filter::Bilinear, texture_Bilinear);
+
+    updateConvert(PixelFunc::Type::Luma, convert_Luma);
+    updateConvert(PixelFunc::Type::Premultiply, convert_Premultiply);
+    updateConvert(PixelFunc::Type::Unpremultiply, convert_Unpremultiply);
+    updateConvert(PixelFunc::Type::SwapRB, convert_SwapRB);
+    updateRgb565(convert_Rgb565);
+    updateYuv(yuv_Luma, yuv_Chroma);
 }
 #endif // !defined(LOTTIE_DISABLE_ARM_NEON)
 
@@ -285,6 +285,8 @@ enum class BlendMode {
     SrcOver,
     DestIn,
     DestOut,
+    DestInLuma,
+    DestOutLuma,
     Last,
 };
 
@@ -1,6 +1,7 @@
 #include "vimageloader.h"
 #include "config.h"
 #include "vdebug.h"
+#include "vdrawhelper.h"
 #include <cstring>
 
 #ifdef _WIN32
@@ -180,18 +181,21 @@ struct VImageLoader::Impl {
     VBitmap createBitmap(unsigned char *data, int width, int height,
                          int channel)
     {
-        // premultiply alpha
-        if (channel == 4)
-            convertToBGRAPremul(data, width, height);
-        else
-            convertToBGRA(data, width, height);
-
         // create a bitmap of same size.
         VBitmap result =
             VBitmap(width, height, VBitmap::Format::ARGB32_Premultiplied);
 
-        // copy the data to bitmap buffer
-        memcpy(result.data(), data, width * height * 4);
+        // convert the rgba rows straight into the bitmap buffer.
+        auto src = reinterpret_cast<const uint32_t *>(data);
+        for (int y = 0; y < height; ++y) {
+            auto dest = reinterpret_cast<uint32_t *>(result.data() +
+                                                     y * result.stride());
+            convertPixels(PixelFunc::Type::SwapRB, dest, src + y * width,
+                          width);
+            // premultiply alpha
+            if (channel == 4)
+                convertPixels(PixelFunc::Type::Premultiply, dest, dest, width);
+        }
 
         // free the image data
         imageFree(data);
@@ -233,45 +237,6 @@ struct VImageLoader::Impl {
 
         return createBitmap(data, width, height, n);
     }
-    /*
-     * convert from RGBA to BGRA and premultiply
-     */
-    void convertToBGRAPremul(unsigned char *bits, int width, int height)
-    {
-        int            pixelCount = width * height;
-        unsigned char *pix = bits;
-        for (int i = 0; i < pixelCount; i++) {
-            unsigned char r = pix[0];
-            unsigned char g = pix[1];
-            unsigned char b = pix[2];
-            unsigned char a = pix[3];
-
-            r = (r * a) / 255;
-            g = (g * a) / 255;
-            b = (b * a) / 255;
-
-            pix[0] = b;
-            pix[1] = g;
-            pix[2] = r;
-
-            pix += 4;
-        }
-    }
-    /*
-     * convert from RGBA to BGRA
-     */
-    void convertToBGRA(unsigned char *bits, int width, int height)
-    {
-        int            pixelCount = width * height;
-        unsigned char *pix = bits;
-        for (int i = 0; i < pixelCount; i++) {
-            unsigned char r = pix[0];
-            unsigned char b = pix[2];
-            pix[0] = b;
-            pix[2] = r;
-            pix += 4;
-        }
-    }
 };
 
 VImageLoader::VImageLoader() : mImpl(std::make_unique<VImageLoader::Impl>()) {}
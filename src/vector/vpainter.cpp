@@ -45,15 +45,27 @@ void VPainter::drawRle(const VRle &rle, const VRle &clip)
 
     if (!mSpanData.mUnclippedBlendFunc) return;
 
+    // the buffer may cover only a part of the canvas, a band of it most
+    // of the drawables miss, so the clip is cut to what both can reach.
+    VRect clipRect = mSpanData.clipRect();
+    if (!clipRect.contains(clip.boundingRect())) {
+        VRect area = clipRect & rle.boundingRect() & clip.boundingRect();
+        if (area.empty()) return;
+        rle.intersect(area & clip, mSpanData.mUnclippedBlendFunc,
+                      &mSpanData);
+        return;
+    }
+
     rle.intersect(clip, mSpanData.mUnclippedBlendFunc, &mSpanData);
 }
 
 static void fillRect(const VRect &r, VSpanData *data)
 {
-    auto x1 = std::max(r.x(), 0);
-    auto x2 = std::min(r.x() + r.width(), data->mDrawableSize.width());
-    auto y1 = std::max(r.y(), 0);
-    auto y2 = std::min(r.y() + r.height(), data->mDrawableSize.height());
+    VRect clip = data->clipRect();
+    auto  x1 = std::max(r.x(), clip.left());
+    auto  x2 = std::min(r.x() + r.width(), clip.right());
+    auto  y1 = std::max(r.y(), clip.top());
+    auto  y2 = std::min(r.y() + r.height(), clip.bottom());
 
     if (x2 <= x1 || y2 <= y1) return;
 
@@ -111,6 +123,11 @@ void VPainter::setDrawRegion(const VRect &region)
     mSpanData.setDrawRegion(region);
 }
 
+void VPainter::setDrawOrigin(const VPoint &origin)
+{
+    mSpanData.setDrawOrigin(origin);
+}
+
 void VPainter::setBrush(const VBrush &brush)
 {
     mSpanData.setup(brush);
@@ -118,7 +135,9 @@ void VPainter::setBrush(const VBrush &brush)
 
 void VPainter::setBlendMode(BlendMode mode)
 {
+    // the span functions are picked by the mode as well.
     mSpanData.mBlendMode = mode;
+    mSpanData.updateSpanFunc();
 }
 
 VRect VPainter::clipBoundingRect() const
@@ -20,6 +20,7 @@
  * SOFTWARE.
  */
 #include "vpath.h"
+#include <algorithm>
 #include <cassert>
 #include <iterator>
 #include <vector>
@@ -71,6 +72,21 @@ float VPath::VPathData::length() const
     return mLength;
 }
 
+VRectF VPath::VPathData::controlBox() const
+{
+    if (m_points.empty()) return {};
+
+    float left = m_points[0].x(), right = left;
+    float top = m_points[0].y(), bottom = top;
+    for (auto &i : m_points) {
+        left = std::min(left, i.x());
+        right = std::max(right, i.x());
+        top = std::min(top, i.y());
+        bottom = std::max(bottom, i.y());
+    }
+    return {left, top, right - left, bottom - top};
+}
+
 void VPath::VPathData::checkNewSegment()
 {
     if (mNewSegment) {
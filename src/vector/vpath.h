@@ -70,6 +70,8 @@ public:
     void  addPath(const VPath &path, const VMatrix &m);
     void  transform(const VMatrix &m);
     float length() const;
+    // bounds of the points, the curves stay inside their control points.
+    VRectF controlBox() const;
     const std::vector<VPath::Element> &elements() const;
     const std::vector<VPointF> &       points() const;
     void  clone(const VPath &srcPath);
@@ -90,6 +92,7 @@ private:
         size_t segments() const;
         void  transform(const VMatrix &m);
         float length() const;
+        VRectF controlBox() const;
         void  addRoundRect(const VRectF &, float, float, VPath::Direction);
         void  addRoundRect(const VRectF &, float, VPath::Direction);
         void  addRect(const VRectF &, VPath::Direction);
@@ -170,6 +173,11 @@ inline float VPath::length() const
     return d->length();
 }
 
+inline VRectF VPath::controlBox() const
+{
+    return d->controlBox();
+}
+
 inline void VPath::cubicTo(const VPointF &c1, const VPointF &c2,
                            const VPointF &e)
 {
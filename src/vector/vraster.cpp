@@ -20,12 +20,15 @@
  * SOFTWARE.
  */
 #include "vraster.h"
+#include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cstring>
 #include <memory>
 #include "config.h"
 #include "v_ft_raster.h"
 #include "v_ft_stroker.h"
+#include "vaccumraster.h"
 #include "vdebug.h"
 #include "vmatrix.h"
 #include "vpath.h"
@@ -42,7 +45,7 @@ public:
     }
     void reserve(size_t size)
     {
-        if (mCapacity > size) return;
+        if (mCapacity >= size) return;
         mCapacity = size;
         mData = std::make_unique<T[]>(mCapacity);
     }
@@ -311,16 +314,45 @@ private:
     bool                    _pending{false};
 };
 
+/*
+ * the scratch of one rasterizer thread. the buffers are kept across the
+ * tasks and only grow, up to the largest path seen, so the steady state
+ * rasterization doesn't allocate.
+ */
+struct RasterWorkspace {
+    RasterWorkspace()
+    {
+        SW_FT_Stroker_New(&stroker);
+        sw_ft_grays_raster.raster_new(&raster);
+    }
+    ~RasterWorkspace()
+    {
+        sw_ft_grays_raster.raster_done(raster);
+        SW_FT_Stroker_Done(stroker);
+    }
+    RasterWorkspace(const RasterWorkspace &) = delete;
+    RasterWorkspace &operator=(const RasterWorkspace &) = delete;
+
+    FTOutline     outline;
+    SW_FT_Stroker stroker{nullptr};
+    SW_FT_Raster  raster{nullptr};
+    VAccumRaster  accumRaster;
+};
+
+static std::atomic<VRasterizer::Backend> Raster_Backend{
+    VRasterizer::Backend::Cells};
+
 struct VRleTask {
-    SharedRle mRle;
-    VPath     mPath;
-    float     mStrokeWidth;
-    float     mMiterLimit;
-    VRect     mClip;
-    FillRule  mFillRule;
-    CapStyle  mCap;
-    JoinStyle mJoin;
-    bool      mGenerateStroke;
+    SharedRle            mRle;
+    VPath                mPath;
+    float                mStrokeWidth;
+    float                mMiterLimit;
+    VRect                mClip;
+    FillRule             mFillRule;
+    CapStyle             mCap;
+    JoinStyle            mJoin;
+    bool                 mGenerateStroke;
+    VRasterizer::Backend mBackend;
 
     VRle &rle() { return mRle.get(); }
 
@@ -331,6 +363,7 @@ struct VRleTask {
         mFillRule = fillRule;
         mClip = clip;
         mGenerateStroke = false;
+        mBackend = Raster_Backend.load();
     }
 
     void update(VPath path, CapStyle cap, JoinStyle join, float width,
@@ -344,13 +377,20 @@ struct VRleTask {
         mMiterLimit = miterLimit;
         mClip = clip;
         mGenerateStroke = true;
+        mBackend = Raster_Backend.load();
     }
-    void render(FTOutline &outRef)
+    void render(RasterWorkspace &ws)
     {
         SW_FT_Raster_Params params;
+        FTOutline &         outRef = ws.outline;
 
         mRle.unsafe().reset();
 
+        if (mBackend == VRasterizer::Backend::Accumulation) {
+            ws.accumRaster.render(outRef.ft, mClip, mRle.unsafe());
+            return;
+        }
+
         params.flags = SW_FT_RASTER_FLAG_DIRECT | SW_FT_RASTER_FLAG_AA;
         params.gray_spans = &rleGenerationCb;
         params.bbox_cb = &bboxCb;
@@ -366,11 +406,14 @@ struct VRleTask {
             params.clip_box.yMax = mClip.bottom();
         }
         // compute rle
-        sw_ft_grays_raster.raster_render(nullptr, &params);
+        sw_ft_grays_raster.raster_render(ws.raster, &params);
     }
 
-    void operator()(FTOutline &outRef, SW_FT_Stroker &stroker)
+    void operator()(RasterWorkspace &ws)
     {
+        FTOutline &   outRef = ws.outline;
+        SW_FT_Stroker stroker = ws.stroker;
+
         if (mPath.points().size() > SHRT_MAX ||
             mPath.points().size() + mPath.segments() > SHRT_MAX) {
             return;
@@ -405,7 +448,7 @@ struct VRleTask {
             outRef.ft.flags = fillRuleFlag;
         }
 
-        render(outRef);
+        render(ws);
 
         mPath = VPath();
 
@@ -431,9 +474,7 @@ class RleTaskScheduler {
         /*
          * initalize  per thread objects.
          */
-        FTOutline     outlineRef;
-        SW_FT_Stroker stroker;
-        SW_FT_Stroker_New(&stroker);
+        RasterWorkspace workspace;
 
         // Task Loop
         VTask task;
@@ -449,11 +490,8 @@ class RleTaskScheduler {
 
             if (!success && !_q[i].pop(task)) break;
 
-            (*task)(outlineRef, stroker);
+            (*task)(workspace);
         }
-
-        // cleanup
-        SW_FT_Stroker_Done(stroker);
     }
 
     RleTaskScheduler()
@@ -496,8 +534,7 @@ public:
 class RleTaskScheduler {
 public:
 #ifndef LOTTIE_THREAD_SAFE
-    FTOutline     outlineRef{};
-    SW_FT_Stroker stroker;
+    RasterWorkspace workspace;
 #endif // LOTTIE_THREAD_SAFE
 public:
     static RleTaskScheduler &instance()
@@ -506,28 +543,12 @@ public:
         return singleton;
     }
 
-    RleTaskScheduler() {
-#ifndef LOTTIE_THREAD_SAFE
-        SW_FT_Stroker_New(&stroker);
-#endif // LOTTIE_THREAD_SAFE
-    }
-
-    ~RleTaskScheduler() {
-#ifndef LOTTIE_THREAD_SAFE
-        SW_FT_Stroker_Done(stroker);
-#endif // LOTTIE_THREAD_SAFE
-    }
-
     void process(VTask task) {
 #ifdef LOTTIE_THREAD_SAFE
-        FTOutline     outlineRef{};
-        SW_FT_Stroker stroker;
-        SW_FT_Stroker_New(&stroker);
-#endif // LOTTIE_THREAD_SAFE
-        (*task)(outlineRef, stroker);
-#ifdef LOTTIE_THREAD_SAFE
-        SW_FT_Stroker_Done(stroker);
+        // each calling thread keeps its own workspace.
+        static thread_local RasterWorkspace workspace;
 #endif // LOTTIE_THREAD_SAFE
+        (*task)(workspace);
     }
 };
 #endif
@@ -545,6 +566,23 @@ VRle VRasterizer::rle()
     return d->rle();
 }
 
+void VRasterizer::translate(const VPoint &offset)
+{
+    if (!d) return;
+    d->rle().translate(offset);
+}
+
+void VRasterizer::setRle(const VRle &rle)
+{
+    init();
+    d->rle() = rle;
+}
+
+void VRasterizer::setBackend(Backend backend)
+{
+    Raster_Backend.store(backend);
+}
+
 void VRasterizer::init()
 {
     if (!d) d = std::make_shared<VRasterizerImpl>();
@@ -556,10 +594,23 @@ void VRasterizer::updateRequest()
     RleTaskScheduler::instance().process(std::move(taskObj));
 }
 
+// the coverage of a path stays within margin of its control points, so
+// a path that keeps that far from the clip leaves nothing to draw.
+static bool outsideClip(const VPath &path, float margin, const VRect &clip)
+{
+    if (clip.empty()) return false;
+
+    VRectF box = path.controlBox();
+    return box.right() + margin < clip.left() ||
+           box.left() - margin > clip.right() ||
+           box.bottom() + margin < clip.top() ||
+           box.top() - margin > clip.bottom();
+}
+
 void VRasterizer::rasterize(VPath path, FillRule fillRule, const VRect &clip)
 {
     init();
-    if (path.empty()) {
+    if (path.empty() || outsideClip(path, 1, clip)) {
         d->rle().reset();
         return;
     }
@@ -571,7 +622,9 @@ void VRasterizer::rasterize(VPath path, CapStyle cap, JoinStyle join,
                             float width, float miterLimit, const VRect &clip)
 {
     init();
-    if (path.empty() || vIsZero(width)) {
+    // the joins reach out up to the miter limit, the caps up to the width.
+    float margin = width * std::max(miterLimit, 1.5f) + 1;
+    if (path.empty() || vIsZero(width) || outsideClip(path, margin, clip)) {
         d->rle().reset();
         return;
     }
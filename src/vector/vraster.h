@@ -34,10 +34,17 @@ class VRle;
 class VRasterizer
 {
 public:
+    // the scan converter of the paths rasterized afterwards, the
+    // accumulation one gives the same coverage as the cell one.
+    enum class Backend { Cells, Accumulation };
+    static void setBackend(Backend backend);
+
     void rasterize(VPath path, FillRule fillRule = FillRule::Winding, const VRect &clip = VRect());
     void rasterize(VPath path, CapStyle cap, JoinStyle join, float width,
                    float miterLimit, const VRect &clip = VRect());
     VRle rle();
+    void translate(const VPoint &offset);
+    void setRle(const VRle &rle);
 private:
     struct VRasterizerImpl;
     void init();
@@ -66,3 +66,16 @@ VRect VRect::operator&(const VRect &r) const
     tmp.y2 = std::min(b1, b2);
     return tmp;
 }
+
+VRect VRect::operator|(const VRect &r) const
+{
+    if (empty()) return r;
+    if (r.empty()) return *this;
+
+    VRect tmp;
+    tmp.x1 = std::min(x1, r.x1);
+    tmp.x2 = std::max(x2, r.x2);
+    tmp.y1 = std::min(y1, r.y1);
+    tmp.y2 = std::max(y2, r.y2);
+    return tmp;
+}
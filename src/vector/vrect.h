@@ -62,6 +62,7 @@ public:
 
     VRect intersected(const VRect &r) const;
     VRect operator&(const VRect &r) const;
+    VRect operator|(const VRect &r) const;
 
 private:
     int x1{0};
@@ -76,7 +76,6 @@ void VRle::Data::reset()
 {
     mSpans.clear();
     mBbox = VRect();
-    mOffset = VPoint();
     mBboxDirty = false;
 }
 
@@ -87,16 +86,15 @@ void VRle::Data::clone(const VRle::Data &o)
 
 void VRle::Data::translate(const VPoint &p)
 {
-    // take care of last offset if applied
-    mOffset = p - mOffset;
-    int x = mOffset.x();
-    int y = mOffset.y();
+    // moves by p from where the spans are now.
+    int x = p.x();
+    int y = p.y();
     for (auto &i : mSpans) {
         i.x = i.x + x;
         i.y = i.y + y;
     }
     updateBbox();
-    mBbox.translate(mOffset.x(), mOffset.y());
+    mBbox.translate(x, y);
 }
 
 void VRle::Data::addRect(const VRect &rect)
@@ -159,7 +157,15 @@ void VRle::Data::opIntersect(const VRect &r, VRle::VRleSpanCb cb,
         return;
     }
 
-    auto   obj = view();
+    auto obj = view();
+    // the spans are sorted by row, the ones above the rect are skipped at
+    // once, as a frame drawn in bands clips every rle to each band.
+    if (r.top() > bbox().top()) {
+        auto first = std::lower_bound(
+            obj.data(), obj.data() + obj.size(), r.top(),
+            [](const VRle::Span &span, int y) { return span.y < y; });
+        obj = {first, size_t(obj.data() + obj.size() - first)};
+    }
     Result result;
     // run till all the spans are processed
     while (obj.size()) {
@@ -278,13 +284,15 @@ static inline V_ALWAYS_INLINE void _opIntersectPrepare(VRle::View &a,
     auto aEnd = a.data() + a.size();
     auto bPtr = b.data();
     auto bEnd = b.data() + b.size();
+    auto above = [](const VRle::Span &span, int y) { return span.y < y; };
 
+    // the spans are sorted by row, a frame drawn in bands intersects many
+    // rles with the small part of another one, so the rows are searched.
     // 1. advance a till it intersects with b
-    while ((aPtr != aEnd) && (aPtr->y < bPtr->y)) aPtr++;
+    if (bPtr != bEnd) aPtr = std::lower_bound(aPtr, aEnd, bPtr->y, above);
 
     // 2. advance b till it intersects with a
-    if (aPtr != aEnd)
-        while ((bPtr != bEnd) && (bPtr->y < aPtr->y)) bPtr++;
+    if (aPtr != aEnd) bPtr = std::lower_bound(bPtr, bEnd, aPtr->y, above);
 
     // update a and b object
     a = {aPtr, size_t(aEnd - aPtr)};
@@ -300,7 +308,7 @@ void VRle::Data::opIntersect(VRle::View a, VRle::View b)
         if (count) copy(result.data(), count, mSpans);
     }
 
-    updateBbox();
+    mBboxDirty = true;
 }
 
 static void _opIntersect(rle_view a, rle_view b, VRle::VRleSpanCb cb,
@@ -100,7 +100,6 @@ public:
         void  clone(const VRle::Data &);
 
         std::vector<VRle::Span> mSpans;
-        VPoint                  mOffset;
         mutable VRect           mBbox;
         mutable bool            mBboxDirty = true;
     };
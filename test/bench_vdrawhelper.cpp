@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "vdrawhelper.h"
+
+/*
+ * Throughput of each blend kernel for every simd level the cpu supports,
+ * in megapixels per second over spans of the given length.
+ * usage: blendBenchmark [span length] [iterations]
+ */
+
+using Simd = RenderFuncTable::Simd;
+
+static const char *name(Simd simd)
+{
+    switch (simd) {
+    case Simd::None:
+        return "scalar";
+    case Simd::Baseline:
+        return "baseline";
+    case Simd::Avx2:
+        return "avx2";
+    }
+    return "";
+}
+
+template <typename Func>
+static double mpixels(int length, int iterations, Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) func();
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+    return double(length) * iterations / secs.count() / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int length = argc > 1 ? atoi(argv[1]) : 256;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    if (length <= 0 || iterations <= 0) return 1;
+
+    auto               count = size_t(length);
+    std::mt19937       rng(1);
+    std::vector<uint>  src(count), dest(count);
+    std::vector<uchar> alpha8(count);
+    for (auto &p : src) p = rng() | 0x80000000;
+    for (auto &p : dest) p = rng();
+    for (auto &p : alpha8) p = uchar(rng());
+
+    const struct {
+        BlendMode   mode;
+        const char *name;
+    } modes[] = {{BlendMode::Src, "Src"},
+                 {BlendMode::SrcOver, "SrcOver"},
+                 {BlendMode::DestIn, "DestIn"},
+                 {BlendMode::DestOut, "DestOut"},
+                 {BlendMode::DestInLuma, "DestInLuma"},
+                 {BlendMode::DestOutLuma, "DestOutLuma"}};
+
+    printf("%-24s %10s %10s %10s\n", "kernel", name(Simd::None),
+           name(Simd::Baseline), name(Simd::Avx2));
+
+    auto row = [&](const char *kernel, const char *mode, uint alpha,
+                   auto &&run) {
+        printf("%-12s%-12s", kernel, mode);
+        for (auto simd : {Simd::None, Simd::Baseline, Simd::Avx2}) {
+            if (simd > RenderFuncTable::cpuSimd()) {
+                printf(" %10s", "-");
+                continue;
+            }
+            RenderFuncTable table(simd);
+            printf(" %10.1f", mpixels(length, iterations,
+                                      [&] { run(table, alpha); }));
+        }
+        printf("  (alpha %u)\n", alpha);
+    };
+
+    for (auto alpha : {255u, 128u}) {
+        for (auto &m : modes) {
+            row("color", m.name, alpha, [&](RenderFuncTable &t, uint a) {
+                t.color(m.mode)(dest.data(), length, src[0], a);
+            });
+            row("src", m.name, alpha, [&](RenderFuncTable &t, uint a) {
+                t.src(m.mode)(dest.data(), length, src.data(), a);
+            });
+        }
+        for (int i = 0; i < 2; ++i) {
+            auto &m = modes[i];
+            row("a8 color", m.name, alpha, [&](RenderFuncTable &t, uint a) {
+                t.alpha8Color(m.mode)(alpha8.data(), length, src[0], a);
+            });
+            row("a8 src", m.name, alpha, [&](RenderFuncTable &t, uint a) {
+                t.alpha8Src(m.mode)(alpha8.data(), length, src.data(), a);
+            });
+        }
+        for (int i = 2; i < 4; ++i) {
+            auto &m = modes[i];
+            row("mask", m.name, alpha, [&](RenderFuncTable &t, uint a) {
+                t.mask(m.mode)(dest.data(), length, alpha8.data(), a);
+            });
+        }
+    }
+
+    // gradient lookups running over a few table periods.
+    std::vector<uint32_t> table(VGradient::colorTableSize);
+    std::vector<float>    det(count), b(count);
+    for (auto &p : table) p = rng();
+    for (size_t i = 0; i < count; ++i) {
+        det[i] = float(i % 97) / 8;
+        b[i] = float(i % 13) / 4;
+    }
+    VGradientData grad{};
+    grad.mColorTable = table.data();
+    RadialGradientValues radial{};
+    radial.dr = 1;
+    radial.extended = true;
+
+    const struct {
+        VGradient::Spread spread;
+        const char *      name;
+    } spreads[] = {{VGradient::Spread::Pad, "Pad"},
+                   {VGradient::Spread::Repeat, "Repeat"},
+                   {VGradient::Spread::Reflect, "Reflect"}};
+    for (auto &sp : spreads) {
+        grad.mSpread = sp.spread;
+        row("linear", sp.name, 255, [&](RenderFuncTable &t, uint) {
+            t.gradientLinear()(dest.data(), length, &grad, -1000 * FIXPT_SIZE,
+                               7 * FIXPT_SIZE);
+        });
+        row("radial", sp.name, 255, [&](RenderFuncTable &t, uint) {
+            t.gradientRadial()(dest.data(), length, &grad, &radial,
+                               det.data(), b.data());
+        });
+    }
+
+    // a rotated and a scaled image, sampled across the whole span.
+    VBitmap bitmap(64, 64, VBitmap::Format::ARGB32_Premultiplied);
+    for (size_t y = 0; y < bitmap.height(); ++y) {
+        auto line =
+            reinterpret_cast<uint *>(bitmap.data() + y * bitmap.stride());
+        for (size_t x = 0; x < bitmap.width(); ++x) line[x] = rng();
+    }
+    VTextureData tex;
+    tex.prepare(&bitmap);
+    tex.setClip(bitmap.rect());
+
+    const struct {
+        VTexture::Filter filter;
+        const char *     name;
+    } filters[] = {{VTexture::Filter::Nearest, "nearest"},
+                   {VTexture::Filter::Bilinear, "bilinear"}};
+    for (auto &f : filters) {
+        row(f.name, "rotate", 255, [&](RenderFuncTable &t, uint) {
+            t.texture(f.filter)(dest.data(), length, &tex, 0, 3.5f, 1.25f,
+                                0.21f, 0.13f);
+        });
+        row(f.name, "scale", 255, [&](RenderFuncTable &t, uint) {
+            t.texture(f.filter)(dest.data(), length, &tex, 0, 3.5f, 1.25f,
+                                0.23f, 0);
+        });
+    }
+
+    const struct {
+        PixelFunc::Type type;
+        const char *    name;
+    } converts[] = {{PixelFunc::Type::Luma, "luma"},
+                    {PixelFunc::Type::Premultiply, "premul"},
+                    {PixelFunc::Type::Unpremultiply, "unpremul"},
+                    {PixelFunc::Type::SwapRB, "swap rb"}};
+    for (auto &c : converts) {
+        row("convert", c.name, 255, [&](RenderFuncTable &t, uint) {
+            t.convert(c.type)(dest.data(), src.data(), length);
+        });
+    }
+    std::vector<uint16_t> rgb565(count);
+    row("convert", "rgb565", 255, [&](RenderFuncTable &t, uint) {
+        t.rgb565()(rgb565.data(), src.data(), length);
+    });
+    std::vector<uint8_t> luma(count), chroma(count + 1);
+    row("yuv", "luma", 255, [&](RenderFuncTable &t, uint) {
+        t.yuvLuma()(luma.data(), src.data(), length);
+    });
+    row("yuv", "chroma", 255, [&](RenderFuncTable &t, uint) {
+        t.yuvChroma()(chroma.data(), nullptr, src.data(), dest.data(),
+                      length);
+    });
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <rlottie.h>
+#include <rlottiecommon.h>
+#include "vpath.h"
+#include "vraster.h"
+#include "vrle.h"
+
+/*
+ * Time per path of each scan converter over a few kinds of paths, from a
+ * handful of large contours to thousands of crossing edges, then over the
+ * paths the bundled example animations draw.
+ * usage: rasterBenchmark [iterations]
+ */
+
+using Backend = VRasterizer::Backend;
+
+struct Shape {
+    std::string name;
+    VPath       path;
+    FillRule    fillRule;
+    float       strokeWidth;
+    CapStyle    cap{CapStyle::Round};
+    JoinStyle   join{JoinStyle::Round};
+    float       miterLimit{4};
+};
+
+static const VRect Clip(0, 0, 512, 512);
+
+template <typename Func>
+static double usecs(int iterations, Func &&func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) func();
+    std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+    return secs.count() * 1e6 / iterations;
+}
+
+static VPath polygon(std::mt19937 &rng, int edges)
+{
+    VPath path;
+    path.moveTo(float(rng() % 512), float(rng() % 512));
+    for (int i = 1; i < edges; ++i)
+        path.lineTo(float(rng() % 5120) / 10, float(rng() % 5120) / 10);
+    path.close();
+    return path;
+}
+
+static VPath curves(std::mt19937 &rng, int count)
+{
+    auto  point = [&] { return VPointF(rng() % 512, rng() % 512); };
+    VPath path;
+    path.moveTo(point());
+    for (int i = 0; i < count; ++i) path.cubicTo(point(), point(), point());
+    path.close();
+    return path;
+}
+
+static VPath toPath(const float *pt, const char *elm, size_t count)
+{
+    VPath path;
+    for (size_t i = 0; i < count; ++i) {
+        switch (VPath::Element(elm[i])) {
+        case VPath::Element::MoveTo:
+            path.moveTo(pt[0], pt[1]);
+            pt += 2;
+            break;
+        case VPath::Element::LineTo:
+            path.lineTo(pt[0], pt[1]);
+            pt += 2;
+            break;
+        case VPath::Element::CubicTo:
+            path.cubicTo(pt[0], pt[1], pt[2], pt[3], pt[4], pt[5]);
+            pt += 6;
+            break;
+        case VPath::Element::Close:
+            path.close();
+            break;
+        }
+    }
+    return path;
+}
+
+// the fills and strokes of a frame, dashes are not applied.
+static void collect(const LOTLayerNode *layer, const std::string &name,
+                    std::vector<Shape> &shapes)
+{
+    for (size_t i = 0; i < layer->mLayerList.size; ++i)
+        collect(layer->mLayerList.ptr[i], name, shapes);
+    for (size_t i = 0; i < layer->mNodeList.size; ++i) {
+        const LOTNode *node = layer->mNodeList.ptr[i];
+        if (!node->mPath.elmCount) continue;
+        Shape s{name,
+                toPath(node->mPath.ptPtr, node->mPath.elmPtr,
+                       node->mPath.elmCount),
+                FillRule(node->mFillRule), 0};
+        if (node->mStroke.enable) {
+            s.strokeWidth = node->mStroke.width;
+            s.cap = CapStyle(node->mStroke.cap);
+            s.join = JoinStyle(node->mStroke.join);
+            s.miterLimit = node->mStroke.miterLimit;
+        }
+        shapes.push_back(std::move(s));
+    }
+}
+
+// the paths of a few frames of every example animation.
+static std::vector<std::vector<Shape>> corpus(const std::string &dirName)
+{
+    std::vector<std::vector<Shape>> files;
+    DIR *                           d = opendir(dirName.c_str());
+    if (!d) return files;
+
+    std::vector<std::string> names;
+    while (struct dirent *dir = readdir(d)) {
+        const char *ext = strrchr(dir->d_name, '.');
+        if (ext && !strcmp(ext, ".json")) names.push_back(dir->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+
+    for (auto &name : names) {
+        auto animation = rlottie::Animation::loadFromFile(dirName + name);
+        if (!animation) continue;
+        std::vector<Shape> shapes;
+        size_t             frames = animation->totalFrame();
+        for (size_t f = 0; f < frames; f += std::max<size_t>(1, frames / 4))
+            collect(animation->renderTree(f, Clip.width(), Clip.height()),
+                    name, shapes);
+        if (!shapes.empty()) files.push_back(std::move(shapes));
+    }
+    return files;
+}
+
+// the time to rasterize all the shapes with each backend, false when the
+// two give different coverage.
+static bool timeShapes(const std::vector<Shape> &shapes, int iterations,
+                       double time[2])
+{
+    size_t area[2];
+    for (auto backend : {Backend::Cells, Backend::Accumulation}) {
+        VRasterizer::setBackend(backend);
+        VRasterizer raster;
+        int         i = backend == Backend::Cells ? 0 : 1;
+        auto        run = [&](size_t *sum) {
+            for (auto &s : shapes) {
+                if (s.strokeWidth > 0)
+                    raster.rasterize(s.path, s.cap, s.join, s.strokeWidth,
+                                     s.miterLimit, Clip);
+                else
+                    raster.rasterize(s.path, s.fillRule, Clip);
+                auto rle = raster.rle();
+                if (!sum) continue;
+                rle.intersect(Clip, [](size_t count, const VRle::Span *spans,
+                                       void *user) {
+                    for (size_t n = 0; n < count; ++n)
+                        *static_cast<size_t *>(user) +=
+                            spans[n].len * spans[n].coverage;
+                }, sum);
+            }
+        };
+        // both should give the same coverage.
+        area[i] = 0;
+        run(&area[i]);
+        time[i] = usecs(iterations, [&] { run(nullptr); });
+    }
+    VRasterizer::setBackend(Backend::Cells);
+    return area[0] == area[1];
+}
+
+static void print(const std::string &name, double time[2], bool same)
+{
+    printf("%-40.40s %10.1f %10.1f %8.2f%s\n", name.c_str(), time[0],
+           time[1], time[0] / time[1], same ? "" : "  (differs)");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    if (iterations <= 0) return 1;
+
+    std::mt19937 rng(1);
+    Shape        shapes[] = {
+        {"rect", VPath(), FillRule::Winding, 0},
+        {"circles", VPath(), FillRule::Winding, 0},
+        {"polystar", VPath(), FillRule::Winding, 0},
+        {"curves", curves(rng, 200), FillRule::Winding, 0},
+        {"polygon 300", polygon(rng, 300), FillRule::EvenOdd, 0},
+        {"polygon 3000", polygon(rng, 3000), FillRule::EvenOdd, 0},
+        {"stroke", VPath(), FillRule::Winding, 6}};
+
+    shapes[0].path.addRect(VRectF(-100, 20, 800, 460));
+    for (int i = 0; i < 200; ++i)
+        shapes[1].path.addCircle(float(rng() % 512), float(rng() % 512),
+                                 float(4 + rng() % 28));
+    shapes[2].path.addPolystar(400, 120, 250, 0, 0, 0, 256, 256);
+    shapes[6].path.moveTo(0, 256);
+    for (int x = 4; x <= 512; x += 4)
+        shapes[6].path.lineTo(float(x), float(256 + (x % 64) * 3));
+
+    printf("%-40s %10s %10s %8s\n", "usec/path", "cells", "accum", "ratio");
+    for (auto &s : shapes) {
+        double time[2];
+        bool   same = timeShapes({s}, iterations, time);
+        print(s.name, time, same);
+    }
+
+    // the whole frames of an animation, a few of them per file.
+    printf("\n%-40s %10s %10s %8s\n", "usec/file", "cells", "accum",
+           "ratio");
+    double total[2] = {0, 0};
+    size_t paths = 0;
+    auto   files = corpus(DEMO_DIR);
+    for (auto &file : files) {
+        double time[2];
+        bool   same = timeShapes(file, std::max(1, iterations / 20), time);
+        print(file.front().name, time, same);
+        total[0] += time[0];
+        total[1] += time[1];
+        paths += file.size();
+    }
+    printf("%-40s %10.1f %10.1f %8.2f\n",
+           (std::to_string(files.size()) + " files, " +
+            std::to_string(paths) + " paths")
+               .c_str(),
+           total[0], total[1], total[0] / total[1]);
+    return 0;
+}
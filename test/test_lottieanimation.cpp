@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include "rlottie.h"
+#include "rlottiecommon.h"
 
 class AnimationTest : public ::testing::Test {
 public:
@@ -32,3 +38,813 @@ TEST_F(AnimationTest, loadFromFile) {
     ASSERT_EQ(width, 500);
     ASSERT_EQ(height, 500);
 }
+
+static size_t countFillColor(const LOTLayerNode *layer, unsigned char r,
+                             unsigned char g, unsigned char b)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < layer->mNodeList.size; i++) {
+        auto node = layer->mNodeList.ptr[i];
+        if (node->mBrushType == BrushSolid && !node->mStroke.enable &&
+            node->mColor.r == r && node->mColor.g == g && node->mColor.b == b)
+            count++;
+    }
+    for (size_t i = 0; i < layer->mLayerList.size; i++)
+        count += countFillColor(layer->mLayerList.ptr[i], r, g, b);
+    return count;
+}
+
+TEST(AnimationSetValueTest, keyPath) {
+    std::string filePath = DEMO_DIR;
+    filePath +="bell.json";
+    auto player = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(player != nullptr);
+
+    player->setValue<rlottie::Property::FillColor>(
+        "Pre-comp 1.Shape Layer 1.Ellipse 1.Fill 1", rlottie::Color(1, 0, 0));
+    ASSERT_EQ(countFillColor(player->renderTree(0, 100, 100), 255, 0, 0), 1);
+
+    player->setValue<rlottie::Property::FillColor>("**.Fill 1",
+                                                   rlottie::Color(0, 1, 0));
+    ASSERT_EQ(countFillColor(player->renderTree(1, 100, 100), 255, 0, 0), 0);
+    ASSERT_GE(countFillColor(player->renderTree(1, 100, 100), 0, 255, 0), 1);
+
+    // unknown keypath leaves the content untouched.
+    player->setValue<rlottie::Property::FillColor>("Pre-comp 1.Unknown.Fill 1",
+                                                   rlottie::Color(0, 0, 1));
+    ASSERT_EQ(countFillColor(player->renderTree(2, 100, 100), 0, 0, 255), 0);
+}
+
+TEST(AnimationSetValueTest, callbackOncePerFrame) {
+    std::string filePath = DEMO_DIR;
+    filePath +="3d.json";
+    auto player = rlottie::Animation::loadFromFile(filePath);
+    ASSERT_TRUE(player != nullptr);
+
+    int calls = 0;
+    player->setValue<rlottie::Property::FillColor>(
+        "**", [&calls](const rlottie::FrameInfo &) {
+            calls++;
+            return rlottie::Color(1, 0, 0);
+        });
+
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    player->renderSync(3, surface);
+    ASSERT_EQ(calls, 1);
+    player->renderSync(4, surface);
+    ASSERT_EQ(calls, 2);
+}
+
+static std::vector<uint32_t> renderFrame(rlottie::Animation &player,
+                                         size_t frameNo)
+{
+    std::vector<uint32_t> buffer(100 * 100);
+    rlottie::Surface surface(buffer.data(), 100, 100, 100 * 4);
+    player.renderSync(frameNo, surface);
+    return buffer;
+}
+
+// the kept pixels go through an extra blit, allow its rounding.
+static void expectNear(const std::vector<uint32_t> &expected,
+                       const std::vector<uint32_t> &actual, size_t frameNo,
+                       int tolerance = 2)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int e = (expected[i] >> shift) & 0xff;
+            int a = (actual[i] >> shift) & 0xff;
+            ASSERT_LE(std::abs(e - a), tolerance) << frameNo << " " << i;
+        }
+    }
+}
+
+// puts a library setting back when the test ends, also when one of its
+// assertions returns early.
+class Restore {
+public:
+    explicit Restore(std::function<void()> restore)
+        : mRestore(std::move(restore))
+    {
+    }
+    ~Restore() { mRestore(); }
+
+private:
+    std::function<void()> mRestore;
+};
+
+TEST(AnimationColorFilterTest, cachedVariant) {
+    std::ifstream file(std::string(DEMO_DIR) + "bell.json");
+    std::string json((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    ASSERT_FALSE(json.empty());
+
+    rlottie::ColorFilter filter = [](float &r, float &g, float &b) {
+        std::swap(r, b);
+        g = 1 - g;
+    };
+    auto reparsed = rlottie::Animation::loadFromData(json, DEMO_DIR, filter);
+    auto variant = rlottie::Animation::loadFromData(json, "bell_variant",
+                                                    filter, DEMO_DIR);
+    auto plain = rlottie::Animation::loadFromData(json, "bell_variant",
+                                                  DEMO_DIR);
+    ASSERT_TRUE(reparsed != nullptr);
+    ASSERT_TRUE(variant != nullptr);
+    ASSERT_TRUE(plain != nullptr);
+
+    for (size_t frameNo = 0; frameNo < variant->totalFrame(); frameNo += 10) {
+        ASSERT_EQ(renderFrame(*reparsed, frameNo),
+                  renderFrame(*variant, frameNo));
+    }
+    // the cached base model is left untouched by the variant.
+    ASSERT_NE(renderFrame(*plain, 10), renderFrame(*variant, 10));
+}
+
+TEST(AnimationPrecompTest, releaseInactive) {
+    std::string file = std::string(DEMO_DIR) + "1643-exploding-star.json";
+    auto kept = rlottie::Animation::loadFromFile(file, false);
+    auto released = rlottie::Animation::loadFromFile(file, false);
+    ASSERT_TRUE(kept != nullptr);
+    ASSERT_TRUE(released != nullptr);
+
+    std::vector<size_t> frames;
+    for (size_t frameNo = 0; frameNo < kept->totalFrame(); frameNo += 4)
+        frames.push_back(frameNo);
+    frames.insert(frames.end(), frames.rbegin(), frames.rend());
+
+    std::vector<std::vector<uint32_t>> images;
+    for (auto frameNo : frames) images.push_back(renderFrame(*kept, frameNo));
+
+    // precomps going off screen are released and rebuilt when they show
+    // up again, in both playing directions.
+    Restore delay([] { rlottie::configurePrecompReleaseDelay(0); });
+    rlottie::configurePrecompReleaseDelay(1);
+    for (size_t i = 0; i < frames.size(); i++) {
+        ASSERT_EQ(images[i], renderFrame(*released, frames[i]));
+    }
+}
+
+// the in and out frames of the layers of a precomp, staggered so that
+// they share some segment bounds. one layer has no frames at all, one a
+// single frame, and no layer is active before frame 10 or after 49.
+static const int ActiveRanges[][2] = {{10, 20}, {15, 30}, {20, 20},
+                                      {20, 40}, {25, 26}, {30, 50},
+                                      {35, 35}, {40, 45}, {10, 50}};
+
+static std::string activeRangesAnimation()
+{
+    std::string layers;
+    int         index = 0;
+    for (auto &range : ActiveRanges) {
+        if (index) layers += ",";
+        layers += R"({"ty":4,"ind":)" + std::to_string(index + 1) +
+                  R"(,"ip":)" + std::to_string(range[0]) + R"(,"op":)" +
+                  std::to_string(range[1]) + R"(,"st":0,"sr":1,
+"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"a":{"a":0,"k":[0,0,0]},
+"s":{"a":0,"k":[100,100,100]},"p":{"a":0,"k":[)" +
+                  std::to_string(5 + index * 11) + R"(,50,0]}},
+"shapes":[{"ty":"rc","d":1,"p":{"a":0,"k":[0,0]},"s":{"a":0,"k":[10,10]},
+"r":{"a":0,"k":0}},{"ty":"fl","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100},
+"r":1}]})";
+        index++;
+    }
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":60,"w":100,"h":100,
+"assets":[{"id":"ranges","layers":[)" +
+           layers + R"(]}],"layers":[{"ty":0,"refId":"ranges","ind":1,
+"ip":0,"op":60,"st":0,"sr":1,"w":100,"h":100,"ks":{"o":{"a":0,"k":100},
+"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},"a":{"a":0,"k":[0,0,0]},
+"s":{"a":0,"k":[100,100,100]}}}]})";
+}
+
+TEST(AnimationPrecompTest, activeRanges) {
+    auto json = activeRangesAnimation();
+    auto player = rlottie::Animation::loadFromData(json, "ranges", "", false);
+    ASSERT_TRUE(player != nullptr);
+    ASSERT_EQ(player->totalFrame(), size_t(60));
+
+    // forward, backward and jumping across the segment bounds.
+    std::vector<size_t> frames;
+    for (size_t frameNo = 0; frameNo < 60; frameNo++) frames.push_back(frameNo);
+    frames.insert(frames.end(), frames.rbegin(), frames.rend());
+    frames.insert(frames.end(), {25, 5, 45, 20, 55, 26, 19, 35, 34, 50, 49,
+                                 9, 10, 30, 59, 0, 40});
+
+    for (auto frameNo : frames) {
+        auto image = renderFrame(*player, frameNo);
+        for (size_t i = 0; i < sizeof(ActiveRanges) / sizeof(ActiveRanges[0]);
+             i++) {
+            bool active = int(frameNo) >= ActiveRanges[i][0] &&
+                          int(frameNo) < ActiveRanges[i][1];
+            uint32_t pixel = image[50 * 100 + 5 + i * 11];
+            ASSERT_EQ(pixel != 0, active) << frameNo << " " << i;
+        }
+
+        // a new instance updates every layer on its first frame, without
+        // going through the segments of the index.
+        auto fresh = rlottie::Animation::loadFromData(json, "ranges", "",
+                                                      false);
+        ASSERT_EQ(image, renderFrame(*fresh, frameNo)) << frameNo;
+    }
+}
+
+TEST(AnimationLayerCacheTest, staticLayers) {
+    std::string file = std::string(DEMO_DIR) + "windmill.json";
+    auto plain = rlottie::Animation::loadFromFile(file, false);
+    rlottie::configureLayerCache(rlottie::LayerCache::Rle);
+    auto rle = rlottie::Animation::loadFromFile(file, false);
+    rlottie::configureLayerCache(rlottie::LayerCache::Bitmap);
+    auto bitmap = rlottie::Animation::loadFromFile(file, false);
+    rlottie::configureLayerCache(rlottie::LayerCache::None);
+    ASSERT_TRUE(plain != nullptr);
+    ASSERT_TRUE(rle != nullptr);
+    ASSERT_TRUE(bitmap != nullptr);
+
+    // the static layers only move by whole pixels here.
+    for (size_t frameNo = 0; frameNo < plain->totalFrame(); frameNo++) {
+        auto image = renderFrame(*plain, frameNo);
+        ASSERT_EQ(image, renderFrame(*rle, frameNo)) << frameNo;
+        expectNear(image, renderFrame(*bitmap, frameNo), frameNo);
+    }
+}
+
+// a static rect whose layer moves right by one pixel per frame.
+static const char *movingRect = R"({"v":"5.5.2","fr":30,"ip":0,"op":30,
+"w":100,"h":100,"layers":[{"ty":4,"ind":1,"ip":0,"op":30,"st":0,"sr":1,
+"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"a":{"a":0,"k":[0,0,0]},
+"s":{"a":0,"k":[100,100,100]},"p":{"a":1,"k":[{"t":0,"s":[10,20,0],
+"e":[40,20,0],"i":{"x":1,"y":1},"o":{"x":0,"y":0}},{"t":30}]}},
+"shapes":[{"ty":"rc","d":1,"p":{"a":0,"k":[10,10]},"s":{"a":0,"k":[20,20]},
+"r":{"a":0,"k":0}},{"ty":"fl","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100},
+"r":1}]}]})";
+
+TEST(AnimationLayerCacheTest, movingLayer) {
+    auto plain = rlottie::Animation::loadFromData(movingRect, "moving", "",
+                                                  false);
+    rlottie::configureLayerCache(rlottie::LayerCache::Rle);
+    auto rle = rlottie::Animation::loadFromData(movingRect, "moving", "",
+                                                false);
+    rlottie::configureLayerCache(rlottie::LayerCache::Bitmap);
+    auto bitmap = rlottie::Animation::loadFromData(movingRect, "moving", "",
+                                                   false);
+    rlottie::configureLayerCache(rlottie::LayerCache::None);
+    ASSERT_TRUE(plain != nullptr);
+    ASSERT_TRUE(rle != nullptr);
+    ASSERT_TRUE(bitmap != nullptr);
+
+    // the kept raster follows every step, not only the first one.
+    for (size_t frameNo = 0; frameNo < plain->totalFrame(); frameNo++) {
+        auto image = renderFrame(*plain, frameNo);
+        ASSERT_EQ(image, renderFrame(*rle, frameNo)) << frameNo;
+        expectNear(image, renderFrame(*bitmap, frameNo), frameNo);
+    }
+}
+
+// two placements of the same precomp, 40px apart at every frame.
+static const char *precompInstances = R"({"v":"5.5.2","fr":30,"ip":0,
+"op":30,"w":100,"h":100,"assets":[{"id":"dot","layers":[{"ty":4,"ind":1,
+"ip":0,"op":30,"st":0,"sr":1,"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},
+"p":{"a":0,"k":[15,15,0]},"a":{"a":0,"k":[0,0,0]},
+"s":{"a":0,"k":[100,100,100]}},"shapes":[{"ty":"el","d":1,
+"p":{"a":0,"k":[0,0]},"s":{"a":1,"k":[{"t":0,"s":[8,8],"e":[24,24],
+"i":{"x":[0.5],"y":[0.5]},"o":{"x":[0.5],"y":[0.5]}},{"t":30}]}},
+{"ty":"fl","c":{"a":0,"k":[1,0.5,0,1]},"o":{"a":0,"k":80},"r":1}]}]}],
+"layers":[{"ty":0,"refId":"dot","ind":1,"ip":0,"op":30,"st":0,"sr":1,
+"w":30,"h":30,"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},
+"a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]},
+"p":{"a":1,"k":[{"t":0,"s":[5,10,0],"e":[35,60,0],"i":{"x":0.5,"y":0.5},
+"o":{"x":0.5,"y":0.5}},{"t":30}]}}},{"ty":0,"refId":"dot","ind":2,"ip":0,
+"op":30,"st":0,"sr":1,"w":30,"h":30,"ks":{"o":{"a":0,"k":100},
+"r":{"a":0,"k":0},"a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]},
+"p":{"a":1,"k":[{"t":0,"s":[45,10,0],"e":[75,60,0],"i":{"x":0.5,"y":0.5},
+"o":{"x":0.5,"y":0.5}},{"t":30}]}}}]})";
+
+TEST(AnimationLayerCacheTest, precompInstances) {
+    auto plain = rlottie::Animation::loadFromData(precompInstances, "plain");
+    rlottie::configureLayerCache(rlottie::LayerCache::Bitmap);
+    auto shared = rlottie::Animation::loadFromData(precompInstances, "shared");
+    rlottie::configureLayerCache(rlottie::LayerCache::None);
+    ASSERT_TRUE(plain != nullptr);
+    ASSERT_TRUE(shared != nullptr);
+
+    for (size_t frameNo = 0; frameNo < plain->totalFrame(); frameNo++) {
+        expectNear(renderFrame(*plain, frameNo), renderFrame(*shared, frameNo),
+                   frameNo);
+    }
+}
+
+static std::string dotsAnimation(const std::string &shapes)
+{
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,
+"layers":[{"ty":4,"ind":1,"ip":0,"op":30,"st":0,"sr":1,
+"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[10,30,0]},
+"a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]}},"shapes":[)" +
+           shapes + "]}]}";
+}
+
+static std::string dotGroup(int x, int opacity)
+{
+    return R"({"ty":"gr","it":[{"ty":"el","d":1,"p":{"a":0,"k":[0,0]},
+"s":{"a":1,"k":[{"t":0,"s":[6,6],"e":[14,14],"i":{"x":[0.5],"y":[0.5]},
+"o":{"x":[0.5],"y":[0.5]}},{"t":30}]}},{"ty":"st","c":{"a":0,"k":[0,0,1,1]},
+"o":{"a":0,"k":100},"w":{"a":0,"k":2},"lc":2,"lj":2},{"ty":"fl",
+"c":{"a":0,"k":[1,0.5,0,1]},"o":{"a":0,"k":80},"r":1},{"ty":"tr",
+"p":{"a":0,"k":[)" +
+           std::to_string(x) + R"(,0]},"a":{"a":0,"k":[0,0]},
+"s":{"a":0,"k":[100,100]},"r":{"a":0,"k":0},"o":{"a":0,"k":)" +
+           std::to_string(opacity) + "}}]}";
+}
+
+TEST(AnimationRepeaterTest, translatedCopies) {
+    // five copies 20px apart fading from 100% to 30%.
+    std::string repeater = dotsAnimation(dotGroup(0, 100) + R"(,{"ty":"rp",
+"c":{"a":0,"k":5},"o":{"a":0,"k":0},"m":1,"tr":{"ty":"tr",
+"p":{"a":0,"k":[20,0]},"a":{"a":0,"k":[0,0]},"s":{"a":0,"k":[100,100]},
+"r":{"a":0,"k":0},"so":{"a":0,"k":100},"eo":{"a":0,"k":30}}})");
+
+    // the same row written out by hand, the last copy is drawn on top.
+    std::string shapes;
+    for (int i = 4; i >= 0; i--) {
+        if (!shapes.empty()) shapes += ",";
+        shapes += dotGroup(20 * i, 100 - 14 * i);
+    }
+    std::string manual = dotsAnimation(shapes);
+
+    auto copies = rlottie::Animation::loadFromData(repeater, "repeater");
+    auto expected = rlottie::Animation::loadFromData(manual, "manual");
+    ASSERT_TRUE(copies != nullptr);
+    ASSERT_TRUE(expected != nullptr);
+
+    for (size_t frameNo = 0; frameNo < copies->totalFrame(); frameNo++) {
+        ASSERT_EQ(renderFrame(*expected, frameNo),
+                  renderFrame(*copies, frameNo));
+    }
+}
+
+static std::string shapeLayer(const std::string &attributes,
+                              const std::string &shapes)
+{
+    return R"({"ty":4,)" + attributes + R"(,"ip":0,"op":30,"st":0,"sr":1,
+"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},
+"a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[100,100,100]}},"shapes":[)" +
+           shapes + "]}";
+}
+
+static std::string matteShape(int x, int y, int from, int to)
+{
+    return R"({"ty":"el","d":1,"p":{"a":0,"k":[)" + std::to_string(x) + "," +
+           std::to_string(y) + R"(]},"s":{"a":1,"k":[{"t":0,"s":[)" +
+           std::to_string(from) + "," + std::to_string(from) +
+           R"(],"e":[)" + std::to_string(to) + "," + std::to_string(to) +
+           R"(],"i":{"x":[0.5],"y":[0.5]},"o":{"x":[0.5],"y":[0.5]}},
+{"t":30}]}})";
+}
+
+/*
+ * The two matte paths round differently. With x = c * l * m / 65025 the
+ * exact value of a channel c under layer coverage l and matte coverage m,
+ * and a truncating BYTE_MUL losing less than 2 levels:
+ * - the rle path rounds l * m to the nearest level, which moves x by half a
+ *   level at most, then takes one BYTE_MUL: (x - 2.5, x + 0.5].
+ * - the offscreen path takes one BYTE_MUL for the layer, truncates m while
+ *   drawing the matte into its alpha buffer, which loses less than a level
+ *   more, then takes one BYTE_MUL for the matte: (x - 5, x].
+ * So a channel of the rle path is at most 5 above and 2 below the offscreen
+ * one, an inverted matte truncates 255 - m upwards and stays within that.
+ */
+static const int MatteTolerance = 5;
+
+static const char *solidFill = R"({"ty":"fl","c":{"a":0,"k":[1,1,1,1]},
+"o":{"a":0,"k":100},"r":1})";
+
+// a mask over the whole canvas, it changes nothing but keeps the matte off
+// the rle path.
+static const char *canvasMask = R"("hasMask":true,"masksProperties":[
+{"inv":false,"mode":"a","o":{"a":0,"k":100},"pt":{"a":0,"k":{"c":true,
+"i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+"v":[[0,0],[100,0],[100,100],[0,100]]}}}])";
+
+// a red rect with its top left at x, y under an optional matte layer.
+static std::string matteAnimation(int type, const std::string &matte, int x,
+                                  int y, bool offscreen = false)
+{
+    std::string target = shapeLayer(
+        R"("ind":2,"tt":)" + std::to_string(type),
+        R"({"ty":"rc","d":1,"p":{"a":0,"k":[)" + std::to_string(x + 20) +
+            "," + std::to_string(y + 20) + R"(]},"s":{"a":0,"k":[40,40]},
+"r":{"a":0,"k":0}},{"ty":"fl","c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":80},
+"r":1})");
+    std::string source = R"("ind":1,"td":1)";
+    if (offscreen) source += std::string(",") + canvasMask;
+    std::string layers =
+        type ? shapeLayer(source, matte + "," + solidFill) + "," + target
+             : target;
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,"layers":[)" +
+           layers + "]}";
+}
+
+TEST(AnimationMatteTest, rleMatte) {
+    // alpha and inverted alpha mattes partly covering the rect.
+    for (int type : {1, 2}) {
+        auto shape = matteShape(40, 40, 10, 50);
+        auto rle = rlottie::Animation::loadFromData(
+            matteAnimation(type, shape, 20, 20), "rle", "", false);
+        auto offscreen = rlottie::Animation::loadFromData(
+            matteAnimation(type, shape, 20, 20, true), "offscreen", "",
+            false);
+        ASSERT_TRUE(rle != nullptr);
+        ASSERT_TRUE(offscreen != nullptr);
+
+        for (size_t frameNo = 0; frameNo < rle->totalFrame(); frameNo += 3) {
+            auto image = renderFrame(*offscreen, frameNo);
+            ASSERT_NE(image, std::vector<uint32_t>(image.size()));
+            expectNear(image, renderFrame(*rle, frameNo), frameNo,
+                       MatteTolerance);
+        }
+    }
+}
+
+TEST(AnimationMatteTest, offsetBounds) {
+    // the rect sits in the bottom right corner, an alpha matte covering it
+    // or an inverted one next to it keeps it whole.
+    auto plain = rlottie::Animation::loadFromData(
+        matteAnimation(0, "", 55, 50), "plain", "", false);
+    ASSERT_TRUE(plain != nullptr);
+
+    const struct {
+        int         type;
+        std::string shape;
+    } mattes[] = {{1, matteShape(75, 70, 70, 90)},
+                  {2, matteShape(20, 20, 10, 30)}};
+    for (auto &m : mattes) {
+        for (bool offscreen : {false, true}) {
+            auto matted = rlottie::Animation::loadFromData(
+                matteAnimation(m.type, m.shape, 55, 50, offscreen), "matte",
+                "", false);
+            ASSERT_TRUE(matted != nullptr);
+
+            for (size_t frameNo = 0; frameNo < plain->totalFrame();
+                 frameNo += 5) {
+                expectNear(renderFrame(*plain, frameNo),
+                           renderFrame(*matted, frameNo), frameNo,
+                           MatteTolerance);
+            }
+        }
+    }
+}
+
+TEST(AnimationSurfaceCacheTest, pooledBuffers) {
+    std::string file = std::string(DEMO_DIR) + "tractor.json";
+    auto player = rlottie::Animation::loadFromFile(file, false);
+    ASSERT_TRUE(player != nullptr);
+
+    auto image = renderFrame(*player, 10);
+    auto before = rlottie::surfaceCacheStats();
+    ASSERT_GT(before.bytes, size_t(0));
+
+    // the offscreen buffers of the next frame come from the pool.
+    renderFrame(*player, 11);
+    auto after = rlottie::surfaceCacheStats();
+    ASSERT_GT(after.hits, before.hits);
+    ASSERT_EQ(after.misses, before.misses);
+
+    // an empty budget flushes the pool and disables it.
+    Restore budget(
+        [] { rlottie::configureSurfaceCacheSize(16 * 1024 * 1024); });
+    rlottie::configureSurfaceCacheSize(0);
+    ASSERT_EQ(rlottie::surfaceCacheStats().bytes, size_t(0));
+    ASSERT_EQ(image, renderFrame(*player, 10));
+    ASSERT_EQ(rlottie::surfaceCacheStats().buffers, size_t(0));
+}
+
+static std::string rectLayer(int ind, int width, const char *color,
+                             int opacity)
+{
+    return R"({"ty":4,"ind":)" + std::to_string(ind) +
+           R"(,"ip":0,"op":30,"st":0,"sr":1,"ks":{"o":{"a":0,"k":100},
+"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},"a":{"a":0,"k":[0,0,0]},
+"s":{"a":0,"k":[100,100,100]}},"shapes":[{"ty":"rc","d":1,"p":{"a":0,"k":[)" +
+           std::to_string(width / 2) + R"(,50]},"s":{"a":0,"k":[)" +
+           std::to_string(width) + R"(,100]},"r":{"a":0,"k":0}},{"ty":"fl",
+"c":{"a":0,"k":)" + color + R"(},"o":{"a":0,"k":)" +
+           std::to_string(opacity) + R"(},"r":1}]})";
+}
+
+TEST(AnimationOcclusionTest, coveredLayers) {
+    std::string shapes;
+    for (int i = 4; i >= 0; i--) {
+        if (!shapes.empty()) shapes += ",";
+        shapes += dotGroup(20 * i, 100);
+    }
+    // the dots over a translucent background.
+    std::string plain = dotsAnimation(shapes);
+    plain.insert(plain.size() - 2, "," + rectLayer(2, 100, "[0,0,1,1]", 50));
+
+    // and an opaque green rect over the left 60 columns.
+    std::string covered = plain;
+    covered.insert(covered.find("\"layers\":[") + 10,
+                   rectLayer(3, 60, "[0,1,0,1]", 100) + ",");
+
+    // the keys are shared with the other tests, don't pick up their models.
+    auto expected = rlottie::Animation::loadFromData(plain, "plain", "", false);
+    auto actual =
+        rlottie::Animation::loadFromData(covered, "covered", "", false);
+    ASSERT_TRUE(expected != nullptr);
+    ASSERT_TRUE(actual != nullptr);
+
+    for (size_t frameNo = 0; frameNo < expected->totalFrame(); frameNo++) {
+        auto image = renderFrame(*expected, frameNo);
+        for (size_t y = 0; y < 100; y++)
+            std::fill_n(image.begin() + y * 100, 60, 0xff00ff00);
+        ASSERT_EQ(image, renderFrame(*actual, frameNo));
+    }
+}
+
+// a red and a blue pixel image scaled up to 100x50.
+static const char *scaledImage = R"({"v":"5.5.2","fr":30,"ip":0,"op":2,
+"w":100,"h":100,"assets":[{"id":"img","w":2,"h":1,"u":"","e":1,
+"p":"data:image/png;base64,)"
+    "iVBORw0KGgoAAAANSUhEUgAAAAIAAAABCAYAAAD0In+KAAAADklEQVR4nGP4z8AAQv8BD/kD/"
+    R"(YURmXYAAAAASUVORK5CYII="}],
+"layers":[{"ty":2,"refId":"img","ind":1,"ip":0,"op":2,"st":0,"sr":1,
+"ks":{"o":{"a":0,"k":100},"r":{"a":0,"k":0},"p":{"a":0,"k":[0,0,0]},
+"a":{"a":0,"k":[0,0,0]},"s":{"a":0,"k":[5000,5000,100]}}}]})";
+
+TEST(AnimationImageQualityTest, bilinearLayer) {
+    auto nearest = rlottie::Animation::loadFromData(scaledImage, "image", "",
+                                                    false);
+    rlottie::configureImageQuality(rlottie::ImageQuality::Bilinear);
+    auto bilinear = rlottie::Animation::loadFromData(scaledImage, "image", "",
+                                                     false);
+    rlottie::configureImageQuality(rlottie::ImageQuality::Nearest);
+    ASSERT_TRUE(nearest != nullptr);
+    ASSERT_TRUE(bilinear != nullptr);
+
+    auto sharp = renderFrame(*nearest, 0);
+    auto smooth = renderFrame(*bilinear, 0);
+    // the test build provides the image loader that decodes the png.
+    ASSERT_NE(sharp[25 * 100], 0u) << "the image was not decoded";
+
+    // the setting of the instance holds when the layer is built, only
+    // the bilinear one mixes the two pixels.
+    size_t blended = 0;
+    for (size_t x = 0; x < 100; x++) {
+        uint32_t p = sharp[25 * 100 + x];
+        uint32_t q = smooth[25 * 100 + x];
+        ASSERT_TRUE(((p >> 16) & 0xff) == 0 || (p & 0xff) == 0) << x;
+        ASSERT_EQ(p >> 24, q >> 24) << x;
+        if (((q >> 16) & 0xff) >= 64 && (q & 0xff) >= 64) blended++;
+    }
+    ASSERT_GT(blended, size_t(10));
+    ASSERT_EQ(sharp[25 * 100], smooth[25 * 100]);
+    ASSERT_EQ(sharp[25 * 100 + 99], smooth[25 * 100 + 99]);
+}
+
+TEST(AnimationRasterizerTest, sameCoverage) {
+    Restore backend(
+        [] { rlottie::configureRasterizer(rlottie::Rasterizer::Cells); });
+    // strokes, masks and even odd fills.
+    for (auto name : {"mask.json", "polystar_anim.json",
+                      "loading_rectangles.json"}) {
+        std::string file = std::string(DEMO_DIR) + name;
+        auto        cells = rlottie::Animation::loadFromFile(file, false);
+        auto        accum = rlottie::Animation::loadFromFile(file, false);
+        ASSERT_TRUE(cells != nullptr);
+        ASSERT_TRUE(accum != nullptr);
+
+        for (size_t frameNo = 0; frameNo < cells->totalFrame(); frameNo++) {
+            rlottie::configureRasterizer(rlottie::Rasterizer::Cells);
+            auto image = renderFrame(*cells, frameNo);
+            rlottie::configureRasterizer(rlottie::Rasterizer::Accumulation);
+            ASSERT_EQ(image, renderFrame(*accum, frameNo)) << name;
+        }
+    }
+}
+
+// renders into the 100x100 draw region at 10, 7 of a larger surface whose
+// rows are padded, returns the region rows packed. the rest of the surface
+// has to be cleared.
+static std::vector<uint8_t> renderFormat(rlottie::Animation &player,
+                                         size_t frameNo,
+                                         rlottie::PixelFormat format)
+{
+    size_t bpp = format == rlottie::PixelFormat::Alpha8      ? 1
+                 : format == rlottie::PixelFormat::RGB16_565 ? 2
+                                                             : 4;
+    const size_t         width = 120, height = 110, stride = width * bpp + 12;
+    std::vector<uint8_t> buffer(stride * height, 0xff);
+    rlottie::Surface     surface(reinterpret_cast<uint32_t *>(buffer.data()),
+                             width, height, stride);
+    surface.setDrawRegion(10, 7, 100, 100);
+    player.renderSync(frameNo, surface, format);
+
+    std::vector<uint8_t> region;
+    size_t               outside = 0;
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < stride; x++) {
+            uint8_t byte = buffer[y * stride + x];
+            if (y >= 7 && y < 107 && x >= 10 * bpp && x < 110 * bpp)
+                region.push_back(byte);
+            else if (byte)
+                outside++;
+        }
+    }
+    EXPECT_EQ(outside, 0u);
+    return region;
+}
+
+// the straight alpha bgra of a premultiplied argb pixel.
+static uint32_t unpremultiplied(uint32_t p)
+{
+    uint32_t a = p >> 24;
+    if (!a) return 0;
+    auto channel = [a](uint32_t c) { return std::min(c * 255 / a, 255u); };
+    return (a << 24) | (channel((p >> 16) & 0xff) << 16) |
+           (channel((p >> 8) & 0xff) << 8) | channel(p & 0xff);
+}
+
+TEST(AnimationPixelFormatTest, convertedFrames) {
+    std::string file = std::string(DEMO_DIR) + "mask.json";
+    auto player = rlottie::Animation::loadFromFile(file, false);
+    ASSERT_TRUE(player != nullptr);
+
+    auto argb = renderFrame(*player, 5);
+    auto rgbaPremul =
+        renderFormat(*player, 5, rlottie::PixelFormat::RGBA32_Premultiplied);
+    auto rgba = renderFormat(*player, 5, rlottie::PixelFormat::RGBA32);
+    auto bgra = renderFormat(*player, 5, rlottie::PixelFormat::BGRA32);
+    auto rgb565 = renderFormat(*player, 5, rlottie::PixelFormat::RGB16_565);
+    auto alpha8 = renderFormat(*player, 5, rlottie::PixelFormat::Alpha8);
+
+    // the asynchronous render takes the format along.
+    std::vector<uint8_t> async(100 * 100 * 4, 0xff);
+    player
+        ->render(5,
+                 rlottie::Surface(reinterpret_cast<uint32_t *>(async.data()),
+                                  100, 100, 400),
+                 rlottie::PixelFormat::BGRA32)
+        .get();
+    ASSERT_EQ(async, bgra);
+
+    for (size_t i = 0; i < argb.size(); i++) {
+        uint32_t p = argb[i];
+        uint32_t a = p >> 24, r = (p >> 16) & 0xff, g = (p >> 8) & 0xff,
+                 b = p & 0xff;
+        ASSERT_EQ(rgbaPremul[4 * i], r);
+        ASSERT_EQ(rgbaPremul[4 * i + 1], g);
+        ASSERT_EQ(rgbaPremul[4 * i + 2], b);
+        ASSERT_EQ(rgbaPremul[4 * i + 3], a);
+
+        uint32_t u = unpremultiplied(p);
+        uint32_t ur = (u >> 16) & 0xff, ub = u & 0xff;
+        ASSERT_EQ(rgba[4 * i], ur);
+        ASSERT_EQ(rgba[4 * i + 2], ub);
+        ASSERT_EQ(rgba[4 * i + 3], a);
+        ASSERT_EQ(bgra[4 * i], ub);
+        ASSERT_EQ(bgra[4 * i + 2], ur);
+        ASSERT_EQ(bgra[4 * i + 3], a);
+
+        uint32_t packed = rgb565[2 * i] | (rgb565[2 * i + 1] << 8);
+        ASSERT_EQ(packed, ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+
+        ASSERT_EQ(alpha8[i], a);
+    }
+}
+
+// the placements of precompInstances, one 40px under the other.
+static std::string stackedInstances()
+{
+    std::string json = precompInstances;
+    for (auto from : {"[45,10,0]", "[75,60,0]"}) {
+        auto pos = json.find(from);
+        json.replace(pos, strlen(from), from[1] == '4' ? "[5,50,0]"
+                                                       : "[35,100,0]");
+    }
+    return json;
+}
+
+// a red canvas with an inverted mask cutting a square out of it.
+static std::string invertedMask()
+{
+    return R"({"v":"5.5.2","fr":30,"ip":0,"op":30,"w":100,"h":100,"layers":[)" +
+           shapeLayer(
+               R"("ind":1,"hasMask":true,"masksProperties":[{"inv":true,
+"mode":"a","o":{"a":0,"k":100},"pt":{"a":0,"k":{"c":true,
+"i":[[0,0],[0,0],[0,0],[0,0]],"o":[[0,0],[0,0],[0,0],[0,0]],
+"v":[[30,30],[70,30],[70,70],[30,70]]}}}])",
+               R"({"ty":"rc","d":1,"p":{"a":0,"k":[50,50]},
+"s":{"a":0,"k":[100,100]},"r":{"a":0,"k":0}},{"ty":"fl",
+"c":{"a":0,"k":[1,0,0,1]},"o":{"a":0,"k":100},"r":1})") +
+           "]}";
+}
+
+TEST(AnimationPixelFormatTest, bandedFrames) {
+    // the straight alpha formats are blended in bands of 130 rows at this
+    // width, they have to give the frame blended whole. each is rendered
+    // by its own instance, so that no state is carried from one to the
+    // other.
+    const size_t size = 500;
+    auto check = [&](const std::function<std::unique_ptr<rlottie::Animation>()>
+                         &load,
+                     size_t step, const std::string &name) {
+        auto whole = load();
+        auto banded = load();
+        ASSERT_TRUE(whole != nullptr);
+        ASSERT_TRUE(banded != nullptr);
+        std::vector<uint32_t> argb(size * size), bgra(size * size);
+        for (size_t frameNo = 0; frameNo < whole->totalFrame();
+             frameNo += step) {
+            whole->renderSync(
+                frameNo, rlottie::Surface(argb.data(), size, size, size * 4));
+            banded->renderSync(
+                frameNo, rlottie::Surface(bgra.data(), size, size, size * 4),
+                rlottie::PixelFormat::BGRA32);
+            for (size_t i = 0; i < argb.size(); i++)
+                ASSERT_EQ(unpremultiplied(argb[i]), bgra[i])
+                    << name << " " << frameNo << " " << i;
+        }
+    };
+
+    // masks, mattes and translucent precomps.
+    for (std::string name : {"mask.json", "29056-nepenthe-illustration.json",
+                             "tractor.json", "1643-exploding-star.json"}) {
+        check([&] {
+            return rlottie::Animation::loadFromFile(
+                std::string(DEMO_DIR) + name, false);
+        }, 7, name);
+    }
+
+    // the inverted mask is bound to the clip of each band.
+    check([] { return rlottie::Animation::loadFromData(invertedMask(), "m"); },
+          10, "inverted");
+
+    // placements sharing their pixels across the bands.
+    Restore policy(
+        [] { rlottie::configureLayerCache(rlottie::LayerCache::None); });
+    rlottie::configureLayerCache(rlottie::LayerCache::Bitmap);
+    check([] {
+        return rlottie::Animation::loadFromData(stackedInstances(), "s");
+    }, 3, "stacked");
+}
+
+TEST(AnimationPixelFormatTest, yuvFrames) {
+    std::string file = std::string(DEMO_DIR) + "mask.json";
+    auto player = rlottie::Animation::loadFromFile(file, false);
+    ASSERT_TRUE(player != nullptr);
+
+    // odd sizes round the chroma planes up, the wider frame is converted
+    // in several bands and ends on a band of odd rows.
+    for (auto size : {std::make_pair<size_t, size_t>(99, 71),
+                      std::make_pair<size_t, size_t>(1001, 301)}) {
+        const size_t          width = size.first, height = size.second;
+        const size_t          cw = (width + 1) / 2, ch = (height + 1) / 2;
+        std::vector<uint32_t> argb(width * height);
+        rlottie::Surface      surface(argb.data(), width, height, width * 4);
+        player->renderSync(5, surface);
+
+        auto channel = [&](size_t x, size_t y, int shift) {
+            x = std::min(x, width - 1);
+            y = std::min(y, height - 1);
+            return int(argb[y * width + x] >> shift) & 0xff;
+        };
+        auto average = [&](size_t x, size_t y, int shift) {
+            return (channel(2 * x, 2 * y, shift) +
+                    channel(2 * x + 1, 2 * y, shift) +
+                    channel(2 * x, 2 * y + 1, shift) +
+                    channel(2 * x + 1, 2 * y + 1, shift) + 2) >> 2;
+        };
+
+        std::vector<uint8_t> y(width * height), u(cw * ch), v(cw * ch);
+        std::vector<uint8_t> uv(2 * cw * ch);
+        rlottie::YuvFrame    i420{y.data(), u.data(), v.data(), width, cw, cw,
+                               width, height, rlottie::YuvFormat::I420};
+        player->renderSync(5, i420);
+
+        auto              luma = y;
+        rlottie::YuvFrame nv12{y.data(), uv.data(), nullptr, width, 2 * cw, 0,
+                               width, height, rlottie::YuvFormat::NV12};
+        player->renderSync(5, nv12);
+        ASSERT_EQ(luma, y);
+
+        for (size_t j = 0; j < height; j++) {
+            for (size_t i = 0; i < width; i++) {
+                int r = channel(i, j, 16), g = channel(i, j, 8),
+                    b = channel(i, j, 0);
+                ASSERT_EQ(y[j * width + i],
+                          (66 * r + 129 * g + 25 * b + 0x1080) >> 8);
+            }
+        }
+        for (size_t j = 0; j < ch; j++) {
+            for (size_t i = 0; i < cw; i++) {
+                int r = average(i, j, 16), g = average(i, j, 8),
+                    b = average(i, j, 0);
+                int cu = (112 * b - 74 * g - 38 * r + 0x8080) >> 8;
+                int cv = (112 * r - 94 * g - 18 * b + 0x8080) >> 8;
+                ASSERT_EQ(u[j * cw + i], cu);
+                ASSERT_EQ(v[j * cw + i], cv);
+                ASSERT_EQ(uv[j * 2 * cw + 2 * i], cu);
+                ASSERT_EQ(uv[j * 2 * cw + 2 * i + 1], cv);
+            }
+        }
+    }
+}
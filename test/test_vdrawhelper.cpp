@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "vdrawhelper.h"
+
+// the avx2 kernels must give the same pixels as the ones they replace, the
+// gradient lookups the same as the scalar ones.
+class VDrawHelperTest : public ::testing::Test {
+public:
+    void SetUp()
+    {
+        std::mt19937 rng(7);
+        for (auto &p : src) p = premultiplied(rng);
+        for (auto &p : dest) p = premultiplied(rng);
+        for (auto &p : mask) p = uchar(rng());
+        // the kernels special case clear and opaque pixels.
+        for (size_t i = 0; i < Length; i += 5) src[i] = 0;
+        for (size_t i = 0; i < Length; i += 7) src[i] |= 0xff000000;
+    }
+    static uint premultiplied(std::mt19937 &rng)
+    {
+        uint a = rng() & 0xff;
+        uint r = (rng() & 0xff) * a / 255;
+        uint g = (rng() & 0xff) * a / 255;
+        uint b = (rng() & 0xff) * a / 255;
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+    bool supported() const
+    {
+        return RenderFuncTable::cpuSimd() == RenderFuncTable::Simd::Avx2;
+    }
+public:
+    static constexpr size_t Length = 67;
+    static constexpr uint   Alphas[] = {255, 254, 128, 1, 0};
+    std::vector<uint>       src = std::vector<uint>(Length);
+    std::vector<uint>       dest = std::vector<uint>(Length);
+    std::vector<uchar>      mask = std::vector<uchar>(Length);
+    RenderFuncTable         scalar{RenderFuncTable::Simd::None};
+    RenderFuncTable         base{RenderFuncTable::Simd::Baseline};
+    RenderFuncTable         simd{RenderFuncTable::Simd::Avx2};
+};
+
+constexpr uint VDrawHelperTest::Alphas[];
+
+static const BlendMode Modes[] = {
+    BlendMode::Src,    BlendMode::SrcOver,    BlendMode::DestIn,
+    BlendMode::DestOut, BlendMode::DestInLuma, BlendMode::DestOutLuma};
+
+// every channel of the pixels lies within tolerance.
+static ::testing::AssertionResult near(const std::vector<uint> &expect,
+                                       const std::vector<uint> &result,
+                                       int                      tolerance)
+{
+    for (size_t i = 0; i < expect.size(); ++i) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            int e = (expect[i] >> shift) & 0xff;
+            int r = (result[i] >> shift) & 0xff;
+            if (std::abs(e - r) > tolerance)
+                return ::testing::AssertionFailure()
+                       << "pixel " << i << " " << std::hex << expect[i]
+                       << " " << result[i];
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
+// the kernels of actual must give the pixels of the ones of expected.
+static void checkArgb(VDrawHelperTest &t, const RenderFuncTable &expected,
+                      const RenderFuncTable &actual, int tolerance)
+{
+    for (auto mode : Modes) {
+        for (auto alpha : VDrawHelperTest::Alphas) {
+            // unaligned and short spans run the head and tail loops.
+            for (int len : {int(VDrawHelperTest::Length) - 1, 8, 3}) {
+                auto expect = t.dest, result = t.dest;
+                expected.src(mode)(expect.data() + 1, len, t.src.data(),
+                                   alpha);
+                actual.src(mode)(result.data() + 1, len, t.src.data(), alpha);
+                ASSERT_TRUE(near(expect, result, tolerance))
+                    << int(mode) << " " << alpha;
+
+                for (size_t i = 0; i < VDrawHelperTest::Length; i += 11) {
+                    expect = result = t.dest;
+                    expected.color(mode)(expect.data(), len, t.src[i], alpha);
+                    actual.color(mode)(result.data(), len, t.src[i], alpha);
+                    ASSERT_TRUE(near(expect, result, tolerance))
+                        << int(mode) << " " << alpha;
+                }
+            }
+        }
+    }
+}
+
+static void checkAlpha8(VDrawHelperTest &t, const RenderFuncTable &expected,
+                        const RenderFuncTable &actual)
+{
+    const int len = int(VDrawHelperTest::Length);
+    for (auto mode : {BlendMode::Src, BlendMode::SrcOver}) {
+        for (auto alpha : VDrawHelperTest::Alphas) {
+            auto expect = t.mask, result = t.mask;
+            expected.alpha8Src(mode)(expect.data(), len, t.src.data(), alpha);
+            actual.alpha8Src(mode)(result.data(), len, t.src.data(), alpha);
+            ASSERT_EQ(expect, result) << int(mode) << " " << alpha;
+
+            expect = result = t.mask;
+            expected.alpha8Color(mode)(expect.data(), len, t.src[3], alpha);
+            actual.alpha8Color(mode)(result.data(), len, t.src[3], alpha);
+            ASSERT_EQ(expect, result) << int(mode) << " " << alpha;
+        }
+    }
+    for (auto mode : {BlendMode::DestIn, BlendMode::DestOut}) {
+        for (auto alpha : VDrawHelperTest::Alphas) {
+            auto expect = t.dest, result = t.dest;
+            expected.mask(mode)(expect.data(), len, t.mask.data(), alpha);
+            actual.mask(mode)(result.data(), len, t.mask.data(), alpha);
+            ASSERT_EQ(expect, result) << int(mode) << " " << alpha;
+        }
+    }
+}
+
+// the sse2 Src kernels round the alpha interpolation differently from the
+// scalar ones, by one level at most.
+TEST_F(VDrawHelperTest, argb) {
+    checkArgb(*this, scalar, base, 1);
+}
+
+TEST_F(VDrawHelperTest, argbAvx2) {
+    if (!supported()) GTEST_SKIP() << "the cpu has no avx2";
+    checkArgb(*this, base, simd, 0);
+}
+
+TEST_F(VDrawHelperTest, alpha8) {
+    checkAlpha8(*this, scalar, base);
+}
+
+TEST_F(VDrawHelperTest, alpha8Avx2) {
+    if (!supported()) GTEST_SKIP() << "the cpu has no avx2";
+    checkAlpha8(*this, base, simd);
+}
+
+TEST_F(VDrawHelperTest, gradient) {
+    std::mt19937          rng(3);
+    std::vector<uint32_t> table(VGradient::colorTableSize);
+    for (auto &p : table) p = rng();
+
+    // positions from well before to well after the table.
+    std::vector<float> det(Length), b(Length);
+    for (size_t i = 0; i < Length; ++i) {
+        det[i] = float(int(rng() % 4000) - 500) / 1000.0f;
+        b[i] = float(int(rng() % 6000) - 3000) / 1000.0f;
+    }
+
+    VGradientData grad{};
+    grad.mColorTable = table.data();
+    grad.radial.fradius = 0.25f;
+    RadialGradientValues radial{};
+    radial.dr = -0.75f;
+
+    std::vector<const RenderFuncTable *> tables{&base};
+    if (supported()) tables.push_back(&simd);
+
+    for (auto spread : {VGradient::Spread::Pad, VGradient::Spread::Repeat,
+                        VGradient::Spread::Reflect}) {
+        grad.mSpread = spread;
+        for (auto table : tables) {
+            std::vector<uint32_t> expect(Length), result(Length);
+            for (int inc : {1, -37, 6553, 0}) {
+                scalar.gradientLinear()(expect.data(), Length, &grad, -300000,
+                                        inc);
+                table->gradientLinear()(result.data(), Length, &grad, -300000,
+                                        inc);
+                ASSERT_EQ(expect, result) << int(spread) << " " << inc;
+            }
+            for (bool extended : {false, true}) {
+                radial.extended = extended;
+                scalar.gradientRadial()(expect.data(), Length, &grad, &radial,
+                                        det.data(), b.data());
+                table->gradientRadial()(result.data(), Length, &grad, &radial,
+                                        det.data(), b.data());
+                ASSERT_EQ(expect, result) << int(spread) << " " << extended;
+            }
+        }
+    }
+}
+
+TEST_F(VDrawHelperTest, texture) {
+    std::mt19937 rng(5);
+    VBitmap      bitmap(13, 9, VBitmap::Format::ARGB32_Premultiplied);
+    for (size_t y = 0; y < bitmap.height(); ++y) {
+        auto line =
+            reinterpret_cast<uint *>(bitmap.data() + y * bitmap.stride());
+        for (size_t x = 0; x < bitmap.width(); ++x)
+            line[x] = premultiplied(rng);
+    }
+    VTextureData tex;
+    tex.prepare(&bitmap);
+    tex.setClip(VRect(1, 2, 11, 6));
+
+    std::vector<const RenderFuncTable *> tables{&base};
+    if (supported()) tables.push_back(&simd);
+
+    // scale only, rotated and sheared spans that leave the texture.
+    const float matrices[][4] = {{0.37f, 0, -2.5f, 4.2f},
+                                 {0.21f, 0.13f, -3.1f, -1.7f},
+                                 {-0.29f, 0.31f, 14.6f, 0.4f},
+                                 {1, 0, 0.5f, 3}};
+    for (auto filter :
+         {VTexture::Filter::Nearest, VTexture::Filter::Bilinear}) {
+        for (auto &m : matrices) {
+            for (auto table : tables) {
+                for (int x : {0, -5, 30}) {
+                    std::vector<uint> expect(Length), result(Length);
+                    scalar.texture(filter)(expect.data(), Length, &tex, x,
+                                           m[2], m[3], m[0], m[1]);
+                    table->texture(filter)(result.data(), Length, &tex, x,
+                                           m[2], m[3], m[0], m[1]);
+                    ASSERT_EQ(expect, result) << int(filter) << " " << m[0];
+                }
+            }
+        }
+    }
+}
+
+// a solid linear gradient is blended by the color kernel of its mode, it
+// must give the pixels of the Src kernel over the filled span. a clear
+// color at full coverage is skipped for SrcOver.
+TEST_F(VDrawHelperTest, solidGradient) {
+    std::vector<const RenderFuncTable *> tables{&scalar, &base};
+    if (supported()) tables.push_back(&simd);
+
+    for (auto table : tables) {
+        for (auto mode :
+             {BlendMode::SrcOver, BlendMode::DestIn, BlendMode::DestOut}) {
+            for (auto alpha : Alphas) {
+                for (size_t i = 0; i < Length; ++i) {
+                    std::vector<uint> color(Length, src[i]);
+                    auto              expect = dest, result = dest;
+                    table->src(mode)(expect.data(), Length, color.data(),
+                                     alpha);
+                    if (alpha != 255 || src[i] || mode != BlendMode::SrcOver)
+                        table->color(mode)(result.data(), Length, src[i],
+                                           alpha);
+                    ASSERT_EQ(expect, result) << int(mode) << " " << alpha;
+
+                    // alpha8 targets only take the SrcOver shortcut.
+                    if (mode != BlendMode::SrcOver) continue;
+                    auto expect8 = mask, result8 = mask;
+                    table->alpha8Src(mode)(expect8.data(), Length,
+                                           color.data(), alpha);
+                    if (alpha != 255 || src[i])
+                        table->alpha8Color(mode)(result8.data(), Length,
+                                                 src[i], alpha);
+                    ASSERT_EQ(expect8, result8) << alpha;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(VDrawHelperTest, convert) {
+    std::mt19937      rng(9);
+    std::vector<uint> pixels(Length);
+    for (auto &p : pixels) p = rng();
+    for (size_t i = 0; i < Length; i += 6) pixels[i] &= 0x00ffffff;
+    for (size_t i = 0; i < Length; i += 9) pixels[i] |= 0xff000000;
+
+    std::vector<const RenderFuncTable *> tables{&base};
+    if (supported()) tables.push_back(&simd);
+
+    for (auto type : {PixelFunc::Type::Luma, PixelFunc::Type::Premultiply,
+                      PixelFunc::Type::Unpremultiply,
+                      PixelFunc::Type::SwapRB}) {
+        // luma expects premultiplied pixels.
+        auto &input = type == PixelFunc::Type::Luma ? src : pixels;
+        for (auto table : tables) {
+            std::vector<uint> expect(Length), result(Length);
+            scalar.convert(type)(expect.data(), input.data(), Length);
+            table->convert(type)(result.data(), input.data(), Length);
+            ASSERT_EQ(expect, result) << int(type);
+
+            // in place.
+            result = input;
+            table->convert(type)(result.data(), result.data(), Length);
+            ASSERT_EQ(expect, result) << int(type);
+        }
+    }
+    for (auto table : tables) {
+        std::vector<uint16_t> expect(Length), result(Length);
+        scalar.rgb565()(expect.data(), pixels.data(), Length);
+        table->rgb565()(result.data(), pixels.data(), Length);
+        ASSERT_EQ(expect, result);
+    }
+}
+
+TEST_F(VDrawHelperTest, yuv) {
+    std::vector<const RenderFuncTable *> tables{&base};
+    if (supported()) tables.push_back(&simd);
+
+    // the odd length pairs the last pixel with itself.
+    const int Width = int(Length);
+    const int Chroma = (Width + 1) / 2;
+    for (auto table : tables) {
+        std::vector<uint8_t> expect(Length), result(Length);
+        scalar.yuvLuma()(expect.data(), src.data(), Width);
+        table->yuvLuma()(result.data(), src.data(), Width);
+        ASSERT_EQ(expect, result);
+
+        std::vector<uint8_t> eu(Chroma), ev(Chroma), ru(Chroma), rv(Chroma);
+        scalar.yuvChroma()(eu.data(), ev.data(), src.data(), dest.data(),
+                           Width);
+        table->yuvChroma()(ru.data(), rv.data(), src.data(), dest.data(),
+                           Width);
+        ASSERT_EQ(eu, ru);
+        ASSERT_EQ(ev, rv);
+
+        std::vector<uint8_t> euv(2 * Chroma), ruv(2 * Chroma);
+        scalar.yuvChroma()(euv.data(), nullptr, src.data(), dest.data(),
+                           Width);
+        table->yuvChroma()(ruv.data(), nullptr, src.data(), dest.data(),
+                           Width);
+        ASSERT_EQ(euv, ruv);
+    }
+}
@@ -100,6 +100,18 @@ TEST_F(VPathTest, addRect_N) {
     ASSERT_EQ(pathEmpty.segments() , 0);
 }
 
+TEST_F(VPathTest, controlBox) {
+    ASSERT_TRUE(pathEmpty.controlBox().empty());
+    auto box = pathRect.controlBox();
+    ASSERT_EQ(box.left(), -10);
+    ASSERT_EQ(box.top(), -20);
+    ASSERT_EQ(box.right(), 90);
+    ASSERT_EQ(box.bottom(), 80);
+    box = pathCircle.controlBox();
+    ASSERT_LE(box.left(), -100);
+    ASSERT_GE(box.right(), 100);
+}
+
 TEST_F(VPathTest, addRoundRect) {
     ASSERT_FALSE(pathRoundRect.empty());
     ASSERT_EQ(pathRoundRect.segments() , 1);
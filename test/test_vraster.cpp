@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "vpath.h"
+#include "vraster.h"
+#include "vrle.h"
+
+static const VRect Clip{0, 0, 100, 100};
+
+static int area(const VRle &rle)
+{
+    int sum = 0;
+    rle.intersect(VRect(-1000, -1000, 2000, 2000),
+                  [](size_t count, const VRle::Span *spans, void *data) {
+                      for (size_t i = 0; i < count; i++)
+                          *static_cast<int *>(data) += spans[i].len;
+                  },
+                  &sum);
+    return sum;
+}
+
+// the part of the unclipped stroke that lies inside the clip.
+static int clippedArea(const VPath &path, CapStyle cap, JoinStyle join,
+                       float width, float miterLimit)
+{
+    VRasterizer raster;
+    raster.rasterize(path, cap, join, width, miterLimit);
+    return area(Clip & raster.rle());
+}
+
+TEST(VRasterizerTest, fillOutsideClip)
+{
+    VPath path;
+    path.addRect(VRectF(120, 20, 40, 40));
+
+    VRasterizer raster;
+    raster.rasterize(path, FillRule::Winding, Clip);
+    ASSERT_TRUE(raster.rle().empty());
+
+    path.reset();
+    path.addRect(VRectF(80, 20, 40, 40));
+    raster.rasterize(path, FillRule::Winding, Clip);
+    ASSERT_EQ(area(raster.rle()), 20 * 40);
+}
+
+TEST(VRasterizerTest, strokeOutsideClip)
+{
+    VPath path;
+    path.moveTo(140, 20);
+    path.lineTo(140, 80);
+
+    VRasterizer raster;
+    raster.rasterize(path, CapStyle::Square, JoinStyle::Miter, 10, 4, Clip);
+    ASSERT_TRUE(raster.rle().empty());
+}
+
+// the control points stay right of the clip, the miter tip does not.
+TEST(VRasterizerTest, miterIntoClip)
+{
+    VPath path;
+    path.moveTo(130, 40);
+    path.lineTo(105, 50);
+    path.lineTo(130, 60);
+
+    int expected = clippedArea(path, CapStyle::Flat, JoinStyle::Miter, 10, 4);
+    ASSERT_GT(expected, 0);
+
+    VRasterizer raster;
+    raster.rasterize(path, CapStyle::Flat, JoinStyle::Miter, 10, 4, Clip);
+    ASSERT_EQ(area(raster.rle()), expected);
+}
+
+// the control points stay right of the clip, the square cap does not.
+TEST(VRasterizerTest, capIntoClip)
+{
+    VPath path;
+    path.moveTo(105, 50);
+    path.lineTo(150, 50);
+
+    int expected = clippedArea(path, CapStyle::Square, JoinStyle::Miter, 20, 1);
+    ASSERT_GT(expected, 0);
+
+    VRasterizer raster;
+    raster.rasterize(path, CapStyle::Square, JoinStyle::Miter, 20, 1, Clip);
+    ASSERT_EQ(area(raster.rle()), expected);
+}
+
+static std::vector<VRle::Span> spans(const VRle &rle)
+{
+    std::vector<VRle::Span> result;
+    rle.intersect(VRect(-1000, -1000, 2000, 2000),
+                  [](size_t count, const VRle::Span *spans, void *data) {
+                      auto v = static_cast<std::vector<VRle::Span> *>(data);
+                      v->insert(v->end(), spans, spans + count);
+                  },
+                  &result);
+    return result;
+}
+
+static bool operator==(const VRle::Span &a, const VRle::Span &b)
+{
+    return a.x == b.x && a.y == b.y && a.len == b.len &&
+           a.coverage == b.coverage;
+}
+
+// the cells of this path do not fit the first cell pool of a raster, the
+// bands are split until the pool has grown on the later calls.
+TEST(VRasterizerTest, growingPool)
+{
+    std::mt19937 rng(1);
+    VPath        path;
+    path.moveTo(float(rng() % 512), float(rng() % 512));
+    for (int i = 1; i < 300; ++i)
+        path.lineTo(float(rng() % 5120) / 10, float(rng() % 5120) / 10);
+    path.close();
+
+    const VRect clip(0, 0, 512, 512);
+    VRasterizer raster;
+    VRasterizer::setBackend(VRasterizer::Backend::Accumulation);
+    raster.rasterize(path, FillRule::EvenOdd, clip);
+    auto expected = spans(raster.rle());
+    VRasterizer::setBackend(VRasterizer::Backend::Cells);
+    ASSERT_FALSE(expected.empty());
+
+    // the pool doubles after every call that split the bands.
+    for (int i = 0; i < 12; ++i) {
+        raster.rasterize(path, FillRule::EvenOdd, clip);
+        ASSERT_TRUE(spans(raster.rle()) == expected) << i;
+    }
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "vrle.h"
+
+static VRle rectRle(int x, int y, int w, int h)
+{
+    std::vector<VRle::Span> spans;
+    for (int i = 0; i < h; i++)
+        spans.push_back({short(x), short(y + i), ushort(w), 255});
+
+    VRle rle;
+    rle.addSpan(spans.data(), spans.size());
+    return rle;
+}
+
+static int area(const VRle &rle)
+{
+    int sum = 0;
+    rle.intersect(VRect(-1000, -1000, 2000, 2000),
+                  [](size_t count, const VRle::Span *spans, void *data) {
+                      for (size_t i = 0; i < count; i++)
+                          *static_cast<int *>(data) += spans[i].len;
+                  },
+                  &sum);
+    return sum;
+}
+
+TEST(VRleTest, intersect)
+{
+    auto a = rectRle(0, 0, 10, 10);
+    auto b = rectRle(5, 0, 10, 10);
+
+    auto c = a & b;
+    ASSERT_EQ(c.boundingRect(), VRect(5, 0, 5, 10));
+    ASSERT_EQ(area(c), 50);
+}
+
+TEST(VRleTest, subtractIntersection)
+{
+    auto a = rectRle(0, 0, 10, 10);
+    auto b = rectRle(5, 0, 10, 10);
+
+    // the result of & has to carry its own bounds, a stale box made
+    // the subtraction treat both rles as disjoint.
+    auto c = a - (a & b);
+    ASSERT_EQ(c.boundingRect(), VRect(0, 0, 5, 10));
+    ASSERT_EQ(area(c), 50);
+
+    auto d = a;
+    d &= b;
+    ASSERT_EQ(area(a - d), 50);
+}
+
+TEST(VRleTest, subtractDisjoint)
+{
+    auto a = rectRle(0, 0, 10, 10);
+    auto b = rectRle(20, 0, 10, 10);
+
+    ASSERT_TRUE((a & b).empty());
+    ASSERT_EQ(area(a - b), 100);
+}